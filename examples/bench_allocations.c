@@ -0,0 +1,168 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+/* Count the memory allocations made while a warmed up context 
+ * edits lines. 
+ * A session over a socket pair (using the telnet transport, so 
+ * the context behaves as it would with a terminal) is sent a 
+ * series of lines that are typed, edited, and recalled from the 
+ * history. Every call to malloc(), calloc() and realloc() is 
+ * counted by replacing them with versions that count the call 
+ * before passing it on to the C library (glibc). 
+ * Usage: bench_allocations [num_lines] 
+ */
+
+#define _GNU_SOURCE
+
+#include "readline.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+
+#define DEFAULT_NUM_LINES 100000
+#define WARM_UP_LINES 1000
+#define HISTORY_SIZE 10
+
+static bool counting_allocations;
+static size_t allocation_count;
+
+void * __libc_malloc(size_t size);
+void * __libc_calloc(size_t count, size_t size);
+void * __libc_realloc(void * ptr, size_t size);
+
+void * malloc(size_t size)
+{
+    if (counting_allocations)
+    {
+        allocation_count++;
+    }
+    return __libc_malloc(size);
+}
+
+void * calloc(size_t count, size_t size)
+{
+    if (counting_allocations)
+    {
+        allocation_count++;
+    }
+    return __libc_calloc(count, size);
+}
+
+void * realloc(void * ptr, size_t size)
+{
+    if (counting_allocations)
+    {
+        allocation_count++;
+    }
+    return __libc_realloc(ptr, size);
+}
+
+/* Typing, cursor movement, deletion and a trip through the 
+ * history, which saves and restores the line being edited. 
+ */
+static char const * const scripts[] = 
+{
+    "show interface ethernet0 | include packets\r\n",
+    "show ip route\033[D\033[D\033[D\033[C\177e\r\n",
+    "configure terminal\033[A\033[B\r\n",
+    "interface ethernet1\001no \005 \027\r\n",
+    "exit\033[A\033[A\033[A\033[B\033[B\033[B\r\n"
+};
+#define NUM_SCRIPTS (sizeof scripts / sizeof scripts[0])
+
+static void drain(int const fd)
+{
+    char buffer[4096];
+
+    while (read(fd, buffer, sizeof buffer) > 0)
+    {
+    }
+}
+
+/* Returns false if the line wasn't read successfully. */
+static bool edit_line(readline_st * const readline_ctx, int const client_fd, char const * const script)
+{
+    bool line_read;
+    char const * line;
+    readline_result_t result;
+
+    if (readline_begin(readline_ctx, "bench> ") != readline_result_success)
+    {
+        line_read = false;
+        goto done;
+    }
+    if (write(client_fd, script, strlen(script)) != (ssize_t)strlen(script))
+    {
+        line_read = false;
+        goto done;
+    }
+    /* The line is borrowed from the context rather than copied. */
+    result = readline_process_ready_borrow(readline_ctx, &line, NULL);
+    drain(client_fd);
+    line_read = result == readline_result_success && line != NULL;
+
+done:
+    return line_read;
+}
+
+int main(int argc, char * * argv)
+{
+    size_t num_lines = DEFAULT_NUM_LINES;
+    int fds[2];
+    readline_st * readline_ctx;
+    size_t index;
+    int exit_code = EXIT_FAILURE;
+
+    if (argc > 1)
+    {
+        num_lines = strtoul(argv[1], NULL, 0);
+    }
+
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == -1)
+    {
+        perror("socketpair");
+        goto done;
+    }
+    readline_ctx = readline_context_create(NULL, NULL, NULL, '\0', fds[0], fds[0], HISTORY_SIZE);
+    if (readline_ctx == NULL)
+    {
+        fprintf(stderr, "Unable to create readline context\n");
+        goto done;
+    }
+    readline_enable_telnet(readline_ctx);
+
+    for (index = 0; index < WARM_UP_LINES + num_lines; index++)
+    {
+        if (index == WARM_UP_LINES)
+        {
+            counting_allocations = true;
+        }
+        if (!edit_line(readline_ctx, fds[1], scripts[index % NUM_SCRIPTS]))
+        {
+            fprintf(stderr, "Line %zu wasn't read\n", index);
+            goto done;
+        }
+    }
+    counting_allocations = false;
+
+    printf("%zu lines, %zu allocations, %.2f per line\n",
+           num_lines,
+           allocation_count,
+           (double)allocation_count / num_lines);
+    exit_code = allocation_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    readline_context_destroy(readline_ctx);
+    close(fds[0]);
+    close(fds[1]);
+
+done:
+    return exit_code;
+}
@@ -0,0 +1,436 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+/* Measure how the library scales when many sessions are served 
+ * from a single thread. 
+ * A child process serves every session over a pseudo terminal 
+ * using session_server. The parent plays the part of the users, 
+ * typing a scripted command into every session one keystroke at 
+ * a time, and waiting for each keystroke to be echoed before 
+ * typing the next one. 
+ * With -t, each session is a socket pair using the telnet 
+ * transport instead of a pseudo terminal. 
+ * Usage: bench_sessions [-t] [-k keystrokes_per_session] [num_sessions ...] 
+ */
+
+#define _GNU_SOURCE
+
+#include "session_server.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <termios.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#define DEFAULT_KEYSTROKES_PER_SESSION 200
+#define MAX_EVENTS 256
+#define PROMPT "Bench> "
+
+static char const script[] = "show interface ethernet0 | include packets\n";
+
+typedef struct bench_session_st bench_session_st;
+struct bench_session_st
+{
+    int fd;
+    size_t keystrokes_sent;
+    bool waiting_for_output;
+    bool waiting_for_prompt;
+    bool measuring;
+    struct timespec sent_at;
+    char tail[sizeof PROMPT]; /* The most recent output, for spotting the prompt. */
+    size_t tail_length;
+};
+
+static double timespec_to_us(struct timespec const * const ts)
+{
+    return ts->tv_sec * 1e6 + ts->tv_nsec / 1e3;
+}
+
+static double timeval_to_seconds(struct timeval const * const tv)
+{
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+static int compare_doubles(void const * const p1, void const * const p2)
+{
+    double const v1 = *(double const *)p1;
+    double const v2 = *(double const *)p2;
+
+    return (v1 > v2) - (v1 < v2);
+}
+
+static double percentile(double const * const sorted, size_t const count, double const fraction)
+{
+    size_t index;
+
+    if (count == 0)
+    {
+        return 0.0;
+    }
+    index = (size_t)(fraction * (count - 1));
+
+    return sorted[index];
+}
+
+static void raise_file_limit(void)
+{
+    struct rlimit limit;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+static void update_tail(bench_session_st * const session, char const * const data, size_t const length)
+{
+    size_t const tail_size = sizeof session->tail - 1;
+
+    if (length >= tail_size)
+    {
+        memcpy(session->tail, &data[length - tail_size], tail_size);
+        session->tail_length = tail_size;
+    }
+    else
+    {
+        size_t const keep = session->tail_length < tail_size - length ? session->tail_length : tail_size - length;
+
+        memmove(session->tail, &session->tail[session->tail_length - keep], keep);
+        memcpy(&session->tail[keep], data, length);
+        session->tail_length = keep + length;
+    }
+    session->tail[session->tail_length] = '\0';
+}
+
+static bool output_ends_with_prompt(bench_session_st const * const session)
+{
+    return session->tail_length == sizeof PROMPT - 1 && strcmp(session->tail, PROMPT) == 0;
+}
+
+static void send_keystroke(bench_session_st * const session)
+{
+    char const ch = script[session->keystrokes_sent % (sizeof script - 1)];
+
+    clock_gettime(CLOCK_MONOTONIC, &session->sent_at);
+    if (write(session->fd, &ch, 1) != 1)
+    {
+        perror("write");
+    }
+    session->keystrokes_sent++;
+    session->waiting_for_output = true;
+    /* After ENTER the whole response must arrive before the next 
+     * keystroke, otherwise its tail would look like an echo. 
+     */
+    session->waiting_for_prompt = ch == '\n';
+    session->measuring = true;
+    session->tail_length = 0;
+}
+
+static int open_telnet_sessions(bench_session_st * const sessions, int * const server_fds, size_t const num_sessions)
+{
+    size_t index;
+
+    for (index = 0; index < num_sessions; index++)
+    {
+        int fds[2];
+
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == -1)
+        {
+            break;
+        }
+        server_fds[index] = fds[0];
+        sessions[index].fd = fds[1];
+        /* The server sends the telnet negotiation and then the 
+         * first prompt. 
+         */
+        sessions[index].waiting_for_output = true;
+        sessions[index].waiting_for_prompt = true;
+    }
+
+    return index;
+}
+
+static int open_sessions(bench_session_st * const sessions, int * const master_fds, size_t const num_sessions)
+{
+    size_t index;
+
+    for (index = 0; index < num_sessions; index++)
+    {
+        char const * slave_name;
+        struct termios settings;
+
+        master_fds[index] = open_pty_master(&slave_name);
+        if (master_fds[index] == -1)
+        {
+            break;
+        }
+        sessions[index].fd = open(slave_name, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (sessions[index].fd == -1)
+        {
+            close(master_fds[index]);
+            break;
+        }
+        /* Raw mode from the start, so nothing typed before the 
+         * server has set up the terminal gets echoed or buffered. 
+         */
+        tcgetattr(sessions[index].fd, &settings);
+        cfmakeraw(&settings);
+        tcsetattr(sessions[index].fd, TCSANOW, &settings);
+        /* The server prints the first prompt unprompted. */
+        sessions[index].waiting_for_output = true;
+        sessions[index].waiting_for_prompt = true;
+    }
+
+    return index;
+}
+
+static void run_server(int const * const master_fds, size_t const num_sessions, bool const telnet)
+{
+    session_server_st * const server = session_server_create(num_sessions, PROMPT);
+    size_t index;
+
+    if (server == NULL)
+    {
+        _exit(EXIT_FAILURE);
+    }
+    for (index = 0; index < num_sessions; index++)
+    {
+        if (!session_server_add_session(server, master_fds[index], telnet))
+        {
+            _exit(EXIT_FAILURE);
+        }
+    }
+    session_server_run(server);
+    session_server_destroy(server);
+    _exit(EXIT_SUCCESS);
+}
+
+static size_t drive_sessions(bench_session_st * const sessions, 
+                             size_t const num_sessions, 
+                             size_t const keystrokes_per_session, 
+                             double * const latencies)
+{
+    int const epoll_fd = epoll_create1(0);
+    struct epoll_event events[MAX_EVENTS];
+    size_t num_latencies = 0;
+    size_t sessions_running = num_sessions;
+    size_t index;
+
+    for (index = 0; index < num_sessions; index++)
+    {
+        struct epoll_event event;
+
+        memset(&event, 0, sizeof event);
+        event.events = EPOLLIN;
+        event.data.ptr = &sessions[index];
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sessions[index].fd, &event);
+    }
+
+    while (sessions_running > 0)
+    {
+        int const num_events = epoll_wait(epoll_fd, events, MAX_EVENTS, 10000);
+        int event_index;
+
+        if (num_events <= 0)
+        {
+            fprintf(stderr, "Timed out waiting for output (%zu sessions still running)\n", sessions_running);
+            break;
+        }
+        for (event_index = 0; event_index < num_events; event_index++)
+        {
+            bench_session_st * const session = events[event_index].data.ptr;
+            struct timespec now;
+            char buffer[512];
+            ssize_t bytes_read;
+
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            while ((bytes_read = read(session->fd, buffer, sizeof buffer)) > 0)
+            {
+                update_tail(session, buffer, bytes_read);
+            }
+            if (!session->waiting_for_output)
+            {
+                continue;
+            }
+            if (session->measuring)
+            {
+                latencies[num_latencies++] = timespec_to_us(&now) - timespec_to_us(&session->sent_at);
+                session->measuring = false;
+            }
+            if (session->waiting_for_prompt && !output_ends_with_prompt(session))
+            {
+                continue;
+            }
+            session->waiting_for_output = false;
+
+            if (session->keystrokes_sent < keystrokes_per_session)
+            {
+                send_keystroke(session);
+            }
+            else
+            {
+                /* Hanging up ends the session on the server. */
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, session->fd, NULL);
+                close(session->fd);
+                session->fd = -1;
+                sessions_running--;
+            }
+        }
+    }
+    close(epoll_fd);
+
+    return num_latencies;
+}
+
+static void run_benchmark(size_t const requested_sessions, size_t const keystrokes_per_session, bool const telnet)
+{
+    bench_session_st * sessions = calloc(requested_sessions, sizeof *sessions);
+    int * master_fds = calloc(requested_sessions, sizeof *master_fds);
+    double * latencies = calloc(requested_sessions * keystrokes_per_session, sizeof *latencies);
+    size_t num_sessions;
+    size_t num_latencies;
+    size_t index;
+    pid_t server_pid;
+    struct rusage usage_before;
+    struct rusage usage_after;
+    double cpu_seconds;
+    struct timespec start;
+    struct timespec end;
+
+    if (sessions == NULL || master_fds == NULL || latencies == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        goto done;
+    }
+
+    if (telnet)
+    {
+        num_sessions = open_telnet_sessions(sessions, master_fds, requested_sessions);
+    }
+    else
+    {
+        num_sessions = open_sessions(sessions, master_fds, requested_sessions);
+    }
+    if (num_sessions < requested_sessions)
+    {
+        fprintf(stderr, "Only able to open %zu of %zu sessions (see /proc/sys/kernel/pty/max and ulimit -n)\n", 
+                num_sessions, requested_sessions);
+    }
+    if (num_sessions == 0)
+    {
+        goto done;
+    }
+
+    getrusage(RUSAGE_CHILDREN, &usage_before);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    fflush(stdout);
+    server_pid = fork();
+    if (server_pid == -1)
+    {
+        perror("fork");
+        goto done;
+    }
+    if (server_pid == 0)
+    {
+        for (index = 0; index < num_sessions; index++)
+        {
+            close(sessions[index].fd);
+        }
+        run_server(master_fds, num_sessions, telnet);
+    }
+    for (index = 0; index < num_sessions; index++)
+    {
+        close(master_fds[index]);
+    }
+
+    num_latencies = drive_sessions(sessions, num_sessions, keystrokes_per_session, latencies);
+
+    for (index = 0; index < num_sessions; index++)
+    {
+        if (sessions[index].fd != -1)
+        {
+            close(sessions[index].fd);
+        }
+    }
+    waitpid(server_pid, NULL, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    getrusage(RUSAGE_CHILDREN, &usage_after);
+
+    cpu_seconds = timeval_to_seconds(&usage_after.ru_utime) - timeval_to_seconds(&usage_before.ru_utime)
+        + timeval_to_seconds(&usage_after.ru_stime) - timeval_to_seconds(&usage_before.ru_stime);
+
+    qsort(latencies, num_latencies, sizeof *latencies, compare_doubles);
+
+    printf("%zu %s sessions, %zu keystrokes, %.2f s elapsed\n", 
+           num_sessions, 
+           telnet ? "telnet" : "pty",
+           num_latencies, 
+           (timespec_to_us(&end) - timespec_to_us(&start)) / 1e6);
+    printf("  keystroke to echo latency (us): p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f max %.1f\n",
+           percentile(latencies, num_latencies, 0.50),
+           percentile(latencies, num_latencies, 0.90),
+           percentile(latencies, num_latencies, 0.99),
+           percentile(latencies, num_latencies, 0.999),
+           percentile(latencies, num_latencies, 1.0));
+    printf("  server CPU: %.3f s total, %.3f ms per session, %.2f us per keystroke\n",
+           cpu_seconds,
+           cpu_seconds * 1e3 / num_sessions,
+           num_latencies > 0 ? cpu_seconds * 1e6 / num_latencies : 0.0);
+
+done:
+    free(latencies);
+    free(master_fds);
+    free(sessions);
+}
+
+int main(int argc, char * * argv)
+{
+    size_t keystrokes_per_session = DEFAULT_KEYSTROKES_PER_SESSION;
+    bool telnet = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "tk:")) != -1)
+    {
+        switch (opt)
+        {
+            case 't':
+                telnet = true;
+                break;
+            case 'k':
+                keystrokes_per_session = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-t] [-k keystrokes_per_session] [num_sessions ...]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    raise_file_limit();
+
+    if (optind == argc)
+    {
+        run_benchmark(1000, keystrokes_per_session, telnet);
+        run_benchmark(10000, keystrokes_per_session, telnet);
+    }
+    for (; optind < argc; optind++)
+    {
+        run_benchmark(strtoul(argv[optind], NULL, 0), keystrokes_per_session, telnet);
+    }
+
+    return EXIT_SUCCESS;
+}
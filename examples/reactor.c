@@ -0,0 +1,98 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+/* Serve a number of readline sessions from a single thread. 
+ * Each session is a pseudo terminal. Connect to a session with 
+ * something like 'screen /dev/pts/<n>', and enter 'quit' to 
+ * end it. The program exits once all sessions have ended. 
+ * If a port is given, telnet connections to that port are 
+ * served too (e.g. 'telnet localhost <port>'), and the program 
+ * keeps running. 
+ * usage: reactor [num_ptys] [telnet_port]
+ */
+
+#define _GNU_SOURCE
+
+#include "session_server.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define DEFAULT_NUM_SESSIONS 4
+#define MAX_TELNET_SESSIONS 100
+
+int main(int argc, char * * argv)
+{
+    session_server_st * server;
+    size_t num_sessions = DEFAULT_NUM_SESSIONS;
+    size_t index;
+    int * slave_fds = NULL;
+    unsigned short telnet_port = 0;
+
+    if (argc > 1)
+    {
+        num_sessions = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        telnet_port = strtoul(argv[2], NULL, 0);
+    }
+
+    server = session_server_create(num_sessions + MAX_TELNET_SESSIONS, "Session> ");
+    slave_fds = calloc(num_sessions, sizeof *slave_fds);
+    if (server == NULL || slave_fds == NULL)
+    {
+        fprintf(stderr, "Unable to create session server\n");
+        goto done;
+    }
+
+    for (index = 0; index < num_sessions; index++)
+    {
+        char const * slave_name;
+        int const master_fd = open_pty_master(&slave_name);
+
+        if (master_fd == -1)
+        {
+            perror("Unable to open pseudo terminal");
+            break;
+        }
+        /* Keep the slave side open so that the session doesn't see 
+         * a hangup before anyone has connected to it. 
+         */
+        slave_fds[index] = open(slave_name, O_RDWR | O_NOCTTY);
+        printf("session %zu: %s\n", index, slave_name);
+        if (!session_server_add_session(server, master_fd, false))
+        {
+            fprintf(stderr, "Unable to add session %zu\n", index);
+            break;
+        }
+    }
+
+    if (telnet_port != 0 && !session_server_listen_for_telnet(server, telnet_port))
+    {
+        perror("Unable to listen for telnet connections");
+    }
+
+    session_server_run(server);
+
+done:
+    if (slave_fds != NULL)
+    {
+        for (index = 0; index < num_sessions; index++)
+        {
+            if (slave_fds[index] > 0)
+            {
+                close(slave_fds[index]);
+            }
+        }
+        free(slave_fds);
+    }
+    session_server_destroy(server);
+
+    return 0;
+}
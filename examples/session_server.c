@@ -0,0 +1,402 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#define _GNU_SOURCE
+
+#include "session_server.h"
+#include "readline.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#define HISTORY_SIZE 10
+#define MIN(x,y) ((x) < (y) ? (x) : (y))
+#define MAX_EVENTS 256
+#define OUTPUT_QUEUE_LIMIT 4096
+
+typedef struct session_st session_st;
+struct session_st
+{
+    int fd;
+    readline_st * readline_ctx;
+};
+
+struct session_server_st
+{
+    int epoll_fd;
+    char const * prompt;
+    size_t maximum_sessions;
+    size_t num_sessions;
+    readline_context_pool_st * context_pool; /* Contexts are reused as sessions come and go. */
+    int listen_fd; /* -1 if not accepting telnet connections. */
+};
+
+session_server_st * session_server_create(size_t const maximum_sessions, char const * const prompt)
+{
+    session_server_st * server;
+
+    server = calloc(1, sizeof *server);
+    if (server == NULL)
+    {
+        goto done;
+    }
+    server->epoll_fd = epoll_create1(0);
+    if (server->epoll_fd == -1)
+    {
+        free(server);
+        server = NULL;
+        goto done;
+    }
+    server->context_pool = readline_context_pool_create(maximum_sessions, NULL, NULL, '\0', HISTORY_SIZE);
+    if (server->context_pool == NULL)
+    {
+        close(server->epoll_fd);
+        free(server);
+        server = NULL;
+        goto done;
+    }
+    server->maximum_sessions = maximum_sessions;
+    server->prompt = prompt;
+    server->listen_fd = -1;
+
+done:
+    return server;
+}
+
+void session_server_destroy(session_server_st * const server)
+{
+    if (server != NULL)
+    {
+        close(server->epoll_fd);
+        if (server->listen_fd != -1)
+        {
+            close(server->listen_fd);
+        }
+        readline_context_pool_destroy(server->context_pool);
+        free(server);
+    }
+}
+
+size_t session_server_get_num_sessions(session_server_st const * const server)
+{
+    return server->num_sessions;
+}
+
+static void session_free(session_server_st * const server, session_st * const session)
+{
+    readline_context_pool_put(server->context_pool, session->readline_ctx);
+    close(session->fd);
+    free(session);
+}
+
+static void session_end(session_server_st * const server, session_st * const session)
+{
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, session->fd, NULL);
+    session_free(server, session);
+    server->num_sessions--;
+}
+
+/* Only poll for input while the session is accepting it, and for 
+ * output while there is some queued. 
+ */
+static bool session_update_events(session_server_st * const server, session_st * const session)
+{
+    readline_fds_st fds;
+    struct epoll_event event;
+
+    readline_get_fds(session->readline_ctx, &fds);
+
+    memset(&event, 0, sizeof event);
+    event.data.ptr = session;
+    if (fds.read_fd != -1)
+    {
+        event.events |= EPOLLIN;
+    }
+    if (fds.write_fd != -1)
+    {
+        event.events |= EPOLLOUT;
+    }
+
+    return epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, session->fd, &event) == 0;
+}
+
+bool session_server_add_session(session_server_st * const server, int const fd, bool const telnet)
+{
+    bool added;
+    session_st * session = NULL;
+    struct epoll_event event;
+
+    if (server->num_sessions == server->maximum_sessions)
+    {
+        added = false;
+        goto done;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    session = calloc(1, sizeof *session);
+    if (session == NULL)
+    {
+        added = false;
+        goto done;
+    }
+    session->fd = fd;
+    session->readline_ctx = readline_context_pool_get(server->context_pool, session, fd, fd);
+    if (session->readline_ctx == NULL)
+    {
+        added = false;
+        goto done;
+    }
+    if (telnet)
+    {
+        readline_enable_telnet(session->readline_ctx);
+    }
+    readline_set_field_separators(session->readline_ctx, "|");
+    readline_set_output_queue_limit(session->readline_ctx, OUTPUT_QUEUE_LIMIT);
+
+    if (readline_begin(session->readline_ctx, server->prompt) != readline_result_success)
+    {
+        added = false;
+        goto done;
+    }
+
+    memset(&event, 0, sizeof event);
+    event.data.ptr = session;
+    if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1
+        || !session_update_events(server, session))
+    {
+        added = false;
+        goto done;
+    }
+    server->num_sessions++;
+    added = true;
+
+done:
+    if (!added)
+    {
+        if (session != NULL)
+        {
+            session_free(server, session);
+        }
+        else
+        {
+            close(fd);
+        }
+    }
+    return added;
+}
+
+/* Returns false if the session should be ended. */
+static bool process_line(session_st * const session, readline_result_t const result, char const * const line)
+{
+    bool keep_session;
+
+    switch (result)
+    {
+        case readline_result_success:
+            if (strcmp(line, "quit") == 0)
+            {
+                keep_session = false;
+                break;
+            }
+        {
+            char response[256];
+            int const length = snprintf(response, sizeof response, "got '%s'\n", line);
+
+            readline_write_output(session->readline_ctx, response, MIN((size_t)length, sizeof response - 1));
+            keep_session = true;
+            break;
+        }
+        case readline_result_ctrl_c:
+            keep_session = true;
+            break;
+        default:
+            keep_session = false;
+            break;
+    }
+
+    return keep_session;
+}
+
+static bool session_process_input(session_server_st * const server, session_st * const session)
+{
+    bool keep_session;
+    readline_fds_st fds;
+
+    do
+    {
+        /* The line is only needed until the next one is started, 
+         * so there's no need for a copy. 
+         */
+        char const * line;
+        readline_result_t const result = readline_process_ready_borrow(session->readline_ctx, &line, NULL);
+
+        if (result == readline_result_pending)
+        {
+            keep_session = true;
+            break;
+        }
+        keep_session = process_line(session, result, line);
+        if (!keep_session)
+        {
+            break;
+        }
+        if (readline_begin(session->readline_ctx, server->prompt) != readline_result_success)
+        {
+            keep_session = false;
+            break;
+        }
+        /* A paste may have delivered more than one line. */
+        readline_get_fds(session->readline_ctx, &fds);
+    }
+    while (fds.input_pending);
+
+    return keep_session;
+}
+
+static bool session_process_events(session_server_st * const server, session_st * const session, uint32_t const events)
+{
+    bool keep_session = true;
+    readline_fds_st fds;
+
+    if ((events & EPOLLOUT) != 0)
+    {
+        keep_session = readline_process_writable(session->readline_ctx) != readline_result_error;
+    }
+    readline_get_fds(session->readline_ctx, &fds);
+    if (keep_session && ((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0 || fds.input_pending))
+    {
+        keep_session = session_process_input(server, session);
+    }
+    if (keep_session)
+    {
+        keep_session = session_update_events(server, session);
+    }
+
+    return keep_session;
+}
+
+bool session_server_listen_for_telnet(session_server_st * const server, unsigned short const port)
+{
+    bool listening;
+    int fd;
+    int const enable = 1;
+    struct sockaddr_in address;
+    struct epoll_event event;
+
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd == -1)
+    {
+        listening = false;
+        goto done;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof enable);
+
+    memset(&address, 0, sizeof address);
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr *)&address, sizeof address) == -1 || listen(fd, SOMAXCONN) == -1)
+    {
+        close(fd);
+        listening = false;
+        goto done;
+    }
+
+    /* Sessions always have a non-NULL pointer, so NULL marks the 
+     * listening socket. 
+     */
+    memset(&event, 0, sizeof event);
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1)
+    {
+        close(fd);
+        listening = false;
+        goto done;
+    }
+    server->listen_fd = fd;
+    listening = true;
+
+done:
+    return listening;
+}
+
+static void accept_telnet_connections(session_server_st * const server)
+{
+    int fd;
+
+    while ((fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK)) != -1)
+    {
+        session_server_add_session(server, fd, true);
+    }
+}
+
+void session_server_run(session_server_st * const server)
+{
+    struct epoll_event events[MAX_EVENTS];
+
+    while (server->num_sessions > 0 || server->listen_fd != -1)
+    {
+        int num_events;
+        int index;
+
+        num_events = epoll_wait(server->epoll_fd, events, MAX_EVENTS, -1);
+        if (num_events == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("epoll_wait");
+            break;
+        }
+        for (index = 0; index < num_events; index++)
+        {
+            session_st * const session = events[index].data.ptr;
+
+            if (session == NULL)
+            {
+                accept_telnet_connections(server);
+            }
+            else if (!session_process_events(server, session, events[index].events))
+            {
+                session_end(server, session);
+            }
+        }
+    }
+}
+
+int open_pty_master(char const * * const slave_name)
+{
+    int fd;
+
+    fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd == -1)
+    {
+        goto done;
+    }
+    if (grantpt(fd) == -1 || unlockpt(fd) == -1)
+    {
+        close(fd);
+        fd = -1;
+        goto done;
+    }
+    if (slave_name != NULL)
+    {
+        *slave_name = ptsname(fd);
+    }
+
+done:
+    return fd;
+}
@@ -0,0 +1,39 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#ifndef __SESSION_SERVER_H__
+#define __SESSION_SERVER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Serves many readline contexts from a single thread using 
+ * epoll and the non-blocking readline interface. 
+ */
+typedef struct session_server_st session_server_st;
+
+session_server_st * session_server_create(size_t const maximum_sessions, char const * const prompt);
+void session_server_destroy(session_server_st * const server);
+
+/* The server takes ownership of fd, and closes it when the 
+ * session ends. Set telnet if fd is a connection from a telnet 
+ * client rather than a terminal. 
+ */
+bool session_server_add_session(session_server_st * const server, int const fd, bool const telnet);
+/* Accept telnet connections on the given TCP port. Each 
+ * connection becomes a session without needing a pty. 
+ */
+bool session_server_listen_for_telnet(session_server_st * const server, unsigned short const port);
+size_t session_server_get_num_sessions(session_server_st const * const server);
+
+/* Returns once all sessions have ended, unless listening for 
+ * telnet connections. 
+ */
+void session_server_run(session_server_st * const server);
+
+int open_pty_master(char const * * const slave_name);
+
+#endif /* __SESSION_SERVER_H__ */
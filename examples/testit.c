@@ -85,20 +85,6 @@ static int test_help_callback(help_context_st * const help_context,
     return result;
 }
 
-static void free_args(size_t argc, char const * const * const argv)
-{
-    if (argv != NULL)
-    {
-        size_t index;
-
-        for (index = 0; index < argc; index++)
-        {
-            FREE_CONST(argv[index]);
-        }
-        FREE_CONST(argv);
-    }
-}
-
 static void do_print_args(int const argc, char const * const * const argv)
 {
     int index;
@@ -193,7 +179,8 @@ static bool read_line(readline_st * const readline_ctx, char const * const promp
 
     continue_processing = process_readline_result(result, readline_argc, readline_argv);
 
-    free_args(readline_argc, readline_argv);
+    /* The args are all in the one block. */
+    FREE_CONST(readline_argv);
 
     return continue_processing;
 }
@@ -19,12 +19,41 @@ typedef enum readline_result_t
     readline_result_ctrl_c,
     readline_result_timed_out,
     readline_result_eof,
-    readline_result_error   /* General error */
+    readline_result_error,  /* General error */
+    readline_result_pending /* readline_process_ready() needs more input to complete the line. */
 } readline_result_t;
 
 typedef struct completion_context_st completion_context_st;
 typedef struct help_context_st help_context_st; 
 
+typedef struct token_span_st token_span_st;
+/* Where a token is in the line being edited. The text points into 
+ * the line itself rather than being a copy, so it isn't NUL 
+ * terminated, and it is only valid until the callback returns. 
+ * A token with quotes or backslash escapes is the exception; its 
+ * text has them removed, so is kept separately. 
+ */
+struct token_span_st
+{
+    char const * text;
+    size_t length;
+    size_t line_index; /* Where the token starts in the line. */
+};
+
+typedef struct token_segment_st token_segment_st;
+/* The tokens of the command the cursor is in, when the line is a 
+ * pipeline of commands divided by field separators. The separators 
+ * aren't included, though the cursor is in the command before a 
+ * separator until it is past it. first_token is NULL if the command 
+ * has no tokens. 
+ */
+struct token_segment_st
+{
+    size_t first_token_index;
+    size_t num_tokens;
+    char const * first_token;
+};
+
 typedef int (* completion_possible_word_add_fn)(completion_context_st * const completion_context,
                                                 char const * const possible_word);
 typedef void (* completion_start_index_set_fn)(completion_context_st * const completion_context,
@@ -35,11 +64,33 @@ typedef int (* completion_callback_fn)(completion_context_st * const completion_
                                        void * const user_context);
 typedef int (* help_callback_fn)(help_context_st * const completion_context,
                                        void * const user_context); 
+/* Returns true if the input entered so far is incomplete, in 
+ * which case ENTER starts another line of the same input. 
+ */
+typedef bool (* continuation_callback_fn)(char const * const input, void * const user_context);
 
 typedef size_t (* tokens_get_current_token_index_fn)(completion_context_st * const completion_context);
 typedef char const * (* tokens_get_current_token_fn)(completion_context_st * const completion_context);
 typedef size_t (* tokens_get_num_tokens_fn)(completion_context_st * const completion_context);
 typedef char const * (* tokens_get_token_at_index_fn)(completion_context_st * const completion_context, size_t const index); 
+/* Fills in the span of the token at 'index'. The span of the 
+ * current token covers the whole token, not just the part before 
+ * the cursor. Returns false if there is no such token. 
+ */
+typedef bool (* tokens_get_token_span_at_index_fn)(completion_context_st * const completion_context, 
+                                                   size_t const index, 
+                                                   token_span_st * const span);
+/* Points 'spans' at an array of the tokens before the current 
+ * token, and returns how many there are, so the earlier tokens 
+ * can be examined without a call per token. 
+ */
+typedef size_t (* tokens_get_preceding_token_spans_fn)(completion_context_st * const completion_context, 
+                                                       token_span_st const * * const spans);
+/* Fills in which of the tokens make up the command the cursor is 
+ * in, so that only those need be looked at. 
+ */
+typedef void (* tokens_get_current_segment_fn)(completion_context_st * const completion_context, 
+                                               token_segment_st * const segment);
 
 
 struct completion_context_st
@@ -54,12 +105,21 @@ struct completion_context_st
     tokens_get_token_at_index_fn tokens_get_token_at_index_fn;
 
     int write_back_fd;
+
+    tokens_get_token_span_at_index_fn tokens_get_token_span_at_index_fn;
+    tokens_get_preceding_token_spans_fn tokens_get_preceding_token_spans_fn;
+    tokens_get_current_segment_fn tokens_get_current_segment_fn;
 };
 
 typedef size_t (* help_tokens_get_current_token_index_fn)(help_context_st * const help_context);
 typedef char const * (* help_tokens_get_current_token_fn)(help_context_st * const help_context);
 typedef size_t (* help_tokens_get_num_tokens_fn)(help_context_st * const help_context);
 typedef char const * (* help_tokens_get_token_at_index_fn)(help_context_st * const help_context, size_t const index);
+typedef bool (* help_tokens_get_token_span_at_index_fn)(help_context_st * const help_context, 
+                                                        size_t const index, 
+                                                        token_span_st * const span);
+typedef size_t (* help_tokens_get_preceding_token_spans_fn)(help_context_st * const help_context, 
+                                                            token_span_st const * * const spans);
 
 struct help_context_st
 {
@@ -69,6 +129,10 @@ struct help_context_st
     help_tokens_get_token_at_index_fn const tokens_get_token_at_index_fn; 
 
     int const write_back_fd;
+
+    help_tokens_get_token_span_at_index_fn const tokens_get_token_span_at_index_fn;
+    help_tokens_get_preceding_token_spans_fn const tokens_get_preceding_token_spans_fn;
+    token_segment_st const current_segment;
 }; 
 
 readline_st * readline_context_create(void * const user_context,
@@ -80,23 +144,322 @@ readline_st * readline_context_create(void * const user_context,
                                       size_t const history_size);
 void readline_context_destroy(readline_st * const readline_ctx);
 
+/* Prepare a context for a new session on different file 
+ * descriptors. All settings go back to what they were when the 
+ * context was created (other than the completion and help 
+ * callbacks, help key and history size, which are kept), and the 
+ * history is cleared, but the memory held by the context is kept, 
+ * so a session server can reuse a context rather than destroying 
+ * it and creating another. 
+ */
+void readline_context_reset(readline_st * const readline_ctx, 
+                            void * const user_context, 
+                            int const input_fd, 
+                            int const output_fd);
+
+/* A pool of contexts for servers where sessions come and go. 
+ * Contexts handed back to the pool are kept (up to 
+ * maximum_idle_contexts of them) and reset before being handed 
+ * out again. All contexts from the pool share the callbacks, help 
+ * key and history size given when the pool is created. 
+ */
+typedef struct readline_context_pool_st readline_context_pool_st;
+
+readline_context_pool_st * readline_context_pool_create(size_t const maximum_idle_contexts, 
+                                                        completion_callback_fn const completion_callback, 
+                                                        help_callback_fn const help_callback, 
+                                                        char const help_key, 
+                                                        size_t const history_size);
+void readline_context_pool_destroy(readline_context_pool_st * const pool);
+readline_st * readline_context_pool_get(readline_context_pool_st * const pool, 
+                                        void * const user_context, 
+                                        int const input_fd, 
+                                        int const output_fd);
+void readline_context_pool_put(readline_context_pool_st * const pool, readline_st * const readline_ctx);
+
 bool readline_history_control(readline_st * const readline_ctx, bool const enable);
 char readline_set_mask_character(readline_st * const readline_ctx, char const mask_character);
 void readline_set_field_separators(readline_st * const readline_ctx, char const * const field_separators);
+/* By default only letters and digits are part of a word for the 
+ * word motion and deletion keys (CTRL-W, ALT-D and CTRL-left/right). 
+ * This adds other characters (e.g. "-_./"). Field separators 
+ * are never part of a word. 
+ */
+void readline_set_word_characters(readline_st * const readline_ctx, char const * const word_characters);
 size_t readline_set_maximum_line_length(readline_st * const readline_ctx, size_t const maximum_line_length); 
 void readline_set_initial_timeout_check(readline_st * const readline_ctx, bool const do_initial_check);
 
+/* Edits to the current line can be undone with CTRL-_ and redone 
+ * with ALT-_. Consecutive typing is undone a word at a time. The 
+ * oldest edits are forgotten once the record of them would use 
+ * more than the limit (in bytes). A limit of 0 disables undo. 
+ * Returns the previous limit. 
+ */
+size_t readline_set_undo_limit(readline_st * const readline_ctx, size_t const limit);
+
+/* Allows input to be entered over several lines. Whenever ENTER 
+ * is pressed the callback is passed everything entered so far, 
+ * with a '\n' between lines. If it returns true another line is 
+ * started with the continuation prompt ("> " if NULL), and the 
+ * up and down arrows move between the lines rather than through 
+ * the history. The completed input is returned as a single 
+ * string with a '\n' between lines. Input that needed more than 
+ * one line isn't added to the history. 
+ */
+void readline_set_continuation_callback(readline_st * const readline_ctx, 
+                                        continuation_callback_fn const continuation_callback, 
+                                        char const * const continuation_prompt);
+
+/* Use when the input and output file descriptors are a socket 
+ * connected to a telnet client rather than a terminal (e.g. 
+ * a pty). The server echoes and works a character at a time 
+ * (ECHO and SGA), and the terminal width is taken from the 
+ * client's window size (NAWS). Telnet commands are removed from 
+ * the input, and new lines are sent as CR LF. 
+ * Output written directly to write_back_fd by completion and 
+ * help callbacks isn't converted. 
+ */
+void readline_enable_telnet(readline_st * const readline_ctx);
+
 readline_result_t readline(readline_st * const readline_ctx,
                            unsigned int const timeout_seconds,
                            char const * const prompt,
                            char * * const line);
 
+/* As readline(), but the line is copied into a buffer owned by 
+ * the caller rather than into newly allocated memory. Like 
+ * snprintf(), the line is truncated if it doesn't fit, and 
+ * *length (if length isn't NULL) is set to the length of the 
+ * whole line. The buffer is left empty if no line is returned. 
+ */
+readline_result_t readline_into(readline_st * const readline_ctx, 
+                                unsigned int const timeout_seconds, 
+                                char const * const prompt, 
+                                char * const buffer, 
+                                size_t const buffer_size, 
+                                size_t * const length);
+
+/* As readline(), but *line points into the context's own edit 
+ * buffer, so nothing is copied and the line mustn't be freed. 
+ * The line is only valid until the next call that starts a line 
+ * on this context, or the context is freed. *line is NULL if no 
+ * line is returned. 
+ */
+readline_result_t readline_borrow(readline_st * const readline_ctx, 
+                                  unsigned int const timeout_seconds, 
+                                  char const * const prompt, 
+                                  char const * * const line, 
+                                  size_t * const length);
+
+/* Non-blocking interface, for use with select(), poll(), epoll 
+ * etc. Start a line with readline_begin(), then call 
+ * readline_process_ready() whenever the input file descriptor 
+ * is readable, or whenever input_pending is set. 
+ * readline_result_pending is returned until the line is 
+ * complete, at which point the result and line are as for 
+ * readline(). 
+ */
+typedef struct readline_fds_st readline_fds_st;
+struct readline_fds_st
+{
+    int read_fd; /* Poll this descriptor for readability, or -1 if too much output is queued. */
+    int write_fd; /* Poll this descriptor for writability, or -1 if no output is queued. */
+    bool input_pending; /* Input has already been read. Call readline_process_ready() without waiting. */
+};
+
+readline_result_t readline_begin(readline_st * const readline_ctx, char const * const prompt);
+void readline_get_fds(readline_st const * const readline_ctx, readline_fds_st * const fds);
+readline_result_t readline_process_ready(readline_st * const readline_ctx, char * * const line);
+/* As readline_process_ready(), but the completed line is returned 
+ * as for readline_into() and readline_borrow(). 
+ */
+readline_result_t readline_process_ready_into(readline_st * const readline_ctx, 
+                                              char * const buffer, 
+                                              size_t const buffer_size, 
+                                              size_t * const length);
+readline_result_t readline_process_ready_borrow(readline_st * const readline_ctx, 
+                                                char const * * const line, 
+                                                size_t * const length);
+
+/* Output is queued by the context. In non-blocking mode, call 
+ * readline_process_writable() when write_fd is writable. It 
+ * returns readline_result_pending while output remains queued. 
+ * The output queue limit is the most that is queued at once. 
+ * Once the queue is full, read_fd is reported as -1 and no more 
+ * input is processed until the queue has drained, so a slow 
+ * reader only holds up its own session. Output that doesn't fit 
+ * is dropped in non-blocking mode, and the line is shown again 
+ * once the queue has drained. Otherwise the context waits for the 
+ * output to be written. A limit of 0 (the default) means no limit. 
+ * readline_write_output() returns false if some of the data was 
+ * dropped. 
+ */
+readline_result_t readline_process_writable(readline_st * const readline_ctx);
+bool readline_write_output(readline_st * const readline_ctx, char const * const data, size_t const length);
+size_t readline_set_output_queue_limit(readline_st * const readline_ctx, size_t const limit);
+
+/* Like readline(), but the line is split into args. Args are 
+ * separated by whitespace or field separators, which can be 
+ * included in an arg by quoting them with single or double quotes 
+ * or escaping them with a backslash, as in the shell. The quotes 
+ * and escapes aren't included in the args. 
+ * argv, and the strings it points to, are allocated as a single 
+ * block, so are released with a single call to free(). *argv is 
+ * NULL if no line is returned. 
+ */
 readline_result_t readline_args(readline_st * const readline_ctx,
                                 unsigned int const timeout_seconds,
                                 char const * const prompt,
                                 size_t * const argc,
                                 char const * * * argv);
 
+/* Keywords that may be abbreviated to any prefix that is unique 
+ * amongst them, as network device CLIs allow (e.g. "sh int" for 
+ * "show interface"). A trie holds the keywords allowed at one 
+ * point in a command, and each keyword can lead on to the trie 
+ * of the keywords allowed after it, so a command tree is made up 
+ * of a trie for each node. Looking up a word takes time in 
+ * proportion to its length however many keywords there are. 
+ */
+typedef struct keyword_trie_st keyword_trie_st;
+
+typedef enum keyword_match_result_t
+{
+    keyword_match_none,
+    keyword_match_unique, /* The word is a keyword, or an abbreviation of only one. */
+    keyword_match_ambiguous /* The word is an abbreviation of more than one keyword. */
+} keyword_match_result_t;
+
+typedef struct keyword_match_st keyword_match_st;
+struct keyword_match_st
+{
+    keyword_match_result_t result;
+    size_t num_matches; /* How many keywords the word is an abbreviation of. */
+    /* The rest are only set if the match is unique. */
+    char const * keyword; /* The keyword in full. */
+    int id;
+    keyword_trie_st const * next; /* The keywords allowed after this one. NULL if none are. */
+};
+
+keyword_trie_st * keyword_trie_create(void);
+/* The tries that the keywords lead on to aren't destroyed. */
+void keyword_trie_destroy(keyword_trie_st * const trie);
+/* Adding a keyword again changes its ID and the trie it leads on 
+ * to. Returns false if there wasn't enough memory. 
+ */
+bool keyword_trie_add(keyword_trie_st * const trie, 
+                      char const * const keyword, 
+                      int const id, 
+                      keyword_trie_st const * const next);
+/* The word needn't be NUL terminated. A word that is a keyword in 
+ * full matches that keyword even if it is also an abbreviation of 
+ * longer ones. 
+ */
+void keyword_trie_lookup(keyword_trie_st const * const trie, 
+                         char const * const word, 
+                         size_t const length, 
+                         keyword_match_st * const match);
+/* Looks up the args in turn, starting with 'trie' and going on 
+ * with the trie that each keyword leads to, until reaching a 
+ * keyword that doesn't lead anywhere, after which the args are 
+ * left to the application. 'matches' must have room for argc 
+ * matches, and *num_resolved is set to the number of args looked 
+ * up. If one of the args isn't a keyword or is ambiguous, the 
+ * result says which and *num_resolved is its index. 
+ */
+keyword_match_result_t keyword_trie_resolve(keyword_trie_st const * const trie, 
+                                            size_t const argc, 
+                                            char const * const * const argv, 
+                                            keyword_match_st * const matches, 
+                                            size_t * const num_resolved);
+/* Completion callback that completes keywords. The user context 
+ * must be the trie of the first keyword of each command. User 
+ * callbacks can call this from their own completion callback. 
+ */
+int do_keyword_completion(completion_context_st * const completion_context,
+                          void * const user_context);
+
+/* A command grammar is registered once, and each line is then 
+ * matched against it in a single pass over its args, to find 
+ * which command it is without comparing the args with every 
+ * command in turn. Each command's syntax is a list of keywords 
+ * and typed args separated by spaces, e.g. 
+ * "show interface <word>" or "set mtu <number>". Keywords may be 
+ * abbreviated, as with keyword_trie_lookup(). 
+ */
+typedef struct command_grammar_st command_grammar_st;
+
+typedef enum command_arg_type_t
+{
+    command_arg_keyword,
+    command_arg_word, /* "<word>": any single arg. */
+    command_arg_number /* "<number>": a decimal integer, which may be negative. */
+} command_arg_type_t;
+
+typedef enum command_syntax_t
+{
+    command_syntax_ok,
+    command_syntax_unknown_word, /* The arg isn't a keyword allowed at that point, and no other arg is allowed. */
+    command_syntax_ambiguous_word, /* The arg is an abbreviation of more than one keyword. */
+    command_syntax_bad_number, /* The arg should have been a number. */
+    command_syntax_incomplete /* The args were all matched, but more are needed to make a command. */
+} command_syntax_t;
+
+typedef struct command_arg_st command_arg_st;
+/* What an arg was matched as. line_index and length (of the arg 
+ * as it was typed) are only filled in by readline_command(). 
+ */
+struct command_arg_st
+{
+    command_arg_type_t type;
+    long number; /* The value of a command_arg_number arg. */
+    size_t line_index;
+    size_t length;
+};
+
+typedef struct command_st command_st;
+struct command_st
+{
+    command_syntax_t syntax;
+    int id; /* The ID of the command, if syntax is command_syntax_ok. */
+    /* The index of the first arg in error, or argc if the command 
+     * is incomplete. 
+     */
+    size_t error_index;
+    size_t error_line_index; /* Where that arg is in the line. Only filled in by readline_command(). */
+    command_arg_st * args; /* One for each of argv, up to error_index. */
+};
+
+command_grammar_st * command_grammar_create(void);
+void command_grammar_destroy(command_grammar_st * const grammar);
+/* Returns false if the syntax is empty or has an unknown arg type, 
+ * if it has an arg where another command has an arg of a 
+ * different type, or if there isn't enough memory. Adding a 
+ * command again changes its ID. Where a keyword and an arg are 
+ * both allowed, a word that is a keyword (or an abbreviation of 
+ * just one) is matched as the keyword. 
+ */
+bool command_grammar_add(command_grammar_st * const grammar, char const * const syntax, int const id);
+/* 'args' must have room for argc args. */
+void command_grammar_parse(command_grammar_st const * const grammar,
+                           size_t const argc,
+                           char const * const * const argv,
+                           command_arg_st * const args,
+                           command_st * const command);
+
+/* Like readline_args(), but the args are also matched against the
+ * grammar. command->args is in the same block as argv, so is
+ * released with it. An empty line gives no args, and a syntax of
+ * command_syntax_incomplete.
+ */
+readline_result_t readline_command(readline_st * const readline_ctx,
+                                   unsigned int const timeout_seconds,
+                                   char const * const prompt,
+                                   command_grammar_st const * const grammar,
+                                   size_t * const argc,
+                                   char const * * * argv,
+                                   command_st * const command);
+
 /* Standard filename completion callback. User callbacks can 
  * call this function from their own completion callback if they
  * want filename completion. 
@@ -0,0 +1,130 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include "arena.h"
+#include "utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGNMENT 16 /* Enough for any of the objects kept in an arena. */
+#define ARENA_MINIMUM_CHUNK_SIZE 1024
+#define ARENA_ROUND_UP(size) (((size) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+struct arena_chunk_st
+{
+    arena_chunk_st * next; /* The next older chunk. */
+    size_t size; /* Bytes available after the header. */
+};
+
+#define ARENA_CHUNK_HEADER_SIZE ARENA_ROUND_UP(sizeof(arena_chunk_st))
+
+static char * arena_chunk_get_data(arena_chunk_st * const chunk)
+{
+    return (char *)chunk + ARENA_CHUNK_HEADER_SIZE;
+}
+
+static void arena_free_chunks(arena_chunk_st * chunk)
+{
+    while (chunk != NULL)
+    {
+        arena_chunk_st * const next = chunk->next;
+
+        free(chunk);
+        chunk = next;
+    }
+}
+
+void arena_init(arena_st * const arena)
+{
+    arena->chunks = NULL;
+    arena->used = 0;
+}
+
+void arena_teardown(arena_st * const arena)
+{
+    arena_free_chunks(arena->chunks);
+    arena_init(arena);
+}
+
+/* Give back everything allocated from the arena. Only the newest 
+ * chunk is kept. 
+ */
+void arena_reset(arena_st * const arena)
+{
+    if (arena->chunks != NULL)
+    {
+        arena_free_chunks(arena->chunks->next);
+        arena->chunks->next = NULL;
+    }
+    arena->used = 0;
+}
+
+/* As arena_reset(), but the last chunk is freed too if it's 
+ * bigger than maximum_idle_size. 
+ */
+void arena_trim(arena_st * const arena, size_t const maximum_idle_size)
+{
+    arena_reset(arena);
+    if (arena->chunks != NULL && arena->chunks->size > maximum_idle_size)
+    {
+        arena_teardown(arena);
+    }
+}
+
+void * arena_alloc(arena_st * const arena, size_t const size)
+{
+    size_t const rounded_size = ARENA_ROUND_UP(MAX(size, 1));
+    void * memory;
+
+    if (arena->chunks == NULL || arena->used + rounded_size > arena->chunks->size)
+    {
+        size_t const previous_size = arena->chunks != NULL ? arena->chunks->size : 0;
+        size_t const new_size = MAX(MAX(previous_size * 2, ARENA_MINIMUM_CHUNK_SIZE), rounded_size);
+        arena_chunk_st * const chunk = malloc(ARENA_CHUNK_HEADER_SIZE + new_size);
+
+        if (chunk == NULL)
+        {
+            memory = NULL;
+            goto done;
+        }
+        chunk->size = new_size;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        arena->used = 0;
+    }
+    memory = arena_chunk_get_data(arena->chunks) + arena->used;
+    arena->used += rounded_size;
+
+done:
+    return memory;
+}
+
+/* Copies the characters from start up to (but not including) end. 
+ * Unlike strdup_partial(), the source isn't checked, so the 
+ * caller must know that it's long enough. 
+ */
+char * arena_strdup_partial(arena_st * const arena, char const * const source, size_t const start, size_t const end)
+{
+    size_t const length = end > start ? end - start : 0;
+    char * const string = arena_alloc(arena, length + 1);
+
+    if (string != NULL)
+    {
+        if (length > 0)
+        {
+            memcpy(string, &source[start], length);
+        }
+        string[length] = '\0';
+    }
+
+    return string;
+}
+
+char * arena_strdup(arena_st * const arena, char const * const string)
+{
+    return arena_strdup_partial(arena, string, 0, strlen(string));
+}
@@ -0,0 +1,40 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+typedef struct arena_chunk_st arena_chunk_st;
+
+typedef struct arena_st arena_st;
+/* Memory for short lived objects, such as the tokens and 
+ * possible words used while completing a word. Allocating is 
+ * just a matter of moving a pointer along, nothing is freed 
+ * individually, and everything is given back at once by 
+ * arena_reset(). 
+ * The memory is taken from chunks, each twice the size of the 
+ * one before. When reset only the newest (and largest) chunk is 
+ * kept, so once it has grown big enough, no more memory needs to 
+ * be allocated. 
+ */
+struct arena_st
+{
+    arena_chunk_st * chunks; /* Newest first. */
+    size_t used; /* Bytes handed out from the newest chunk. */
+};
+
+void arena_init(arena_st * const arena);
+void arena_teardown(arena_st * const arena);
+void arena_reset(arena_st * const arena);
+void arena_trim(arena_st * const arena, size_t const maximum_idle_size);
+
+void * arena_alloc(arena_st * const arena, size_t const size);
+char * arena_strdup(arena_st * const arena, char const * const string);
+char * arena_strdup_partial(arena_st * const arena, char const * const source, size_t const start, size_t const end);
+
+#endif /* __ARENA_H__ */
@@ -5,113 +5,80 @@
  */
 
 #include "args.h"
-#include "utils.h"
 
 #include <stdlib.h>
 #include <string.h>
-#include <stdbool.h>
 
-#define INCREMENT	1
-
-static void free_args_array(size_t const num_args, char const * * const args)
+/* 'strings_length' is the total length of the strings that will 
+ * be added, not including their NUL terminators. 
+ */
+bool args_alloc(args_st * const args, 
+                size_t const maximum_args, 
+                size_t const strings_length, 
+                size_t const extra_size)
 {
-    size_t index;
-
-    for (index = 0; index < num_args; index++)
+    bool allocated;
+    /* Include 1 for the NULL terminator. The pointers come first 
+     * so that they, and the extra data after them, are suitably 
+     * aligned. 
+     */
+    size_t const array_size = (maximum_args + 1) * sizeof *args->argv;
+    char * block;
+
+    args->argc = 0;
+    args->maximum_args = maximum_args;
+    block = malloc(array_size + extra_size + strings_length + maximum_args);
+    if (block == NULL)
     {
-        FREE_CONST(args[index]);
+        args->argv = NULL;
+        args->extra = NULL;
+        args->next_string = NULL;
+        allocated = false;
+        goto done;
     }
-    free(args);
-}
+    args->argv = (char const * *)block;
+    args->extra = extra_size > 0 ? block + array_size : NULL;
+    args->next_string = block + array_size + extra_size;
+    allocated = true;
 
-void args_free(args_st const * const args)
-{
-    if (args != NULL)
-    {
-        if (args->argv != NULL)
-        {
-            free_args_array(args->argc, args->argv);
-        }
-        FREE_CONST(args);
-    }
+done:
+    return allocated;
 }
 
-args_st * args_alloc(unsigned int const initial_size)
+void args_free(args_st * const args)
 {
-    args_st * args;
-
-    args = calloc(1, sizeof *args);
-    if (args == NULL)
-    {
-        goto error;
-    }
-    if (initial_size > 0)
-    {
-        args->slots_allocated = initial_size;
-        args->argv = calloc(initial_size, sizeof(*args->argv));
-        if (args->argv == NULL)
-        {
-            goto error;
-        }
-    }
-
-    goto done;
-
-error:
-    args_free(args);
-    args = NULL;
-done:
-    return args;
+    free(args->argv);
+    args->argv = NULL;
+    args->argc = 0;
 }
 
-static bool args_increase_size(args_st * const args)
+/* Copy 'length' characters of 'arg' into the block, followed by a 
+ * NUL, so 'arg' needn't be NUL terminated. 
+ */
+void args_add_arg(args_st * const args, char const * const arg, size_t const length)
 {
-    bool size_increased;
-
-    args->argv = realloc(args->argv, (args->slots_allocated + INCREMENT) * sizeof( *args->argv));
-    if (args->argv == NULL)
+    if (args->argc < args->maximum_args)
     {
-        args->argc = 0;
-        size_increased = false;
-        goto done;
+        memcpy(args->next_string, arg, length);
+        args->next_string[length] = '\0';
+        args->argv[args->argc] = args->next_string;
+        args->next_string += length + 1;
+        args->argc++;
     }
-    args->slots_allocated += INCREMENT;
-    size_increased = true;
-
-done:
-    return size_increased;
 }
 
-int args_add_arg(args_st * const args, char const * const arg)
+/* Terminate the array with a NULL and hand the block over to the 
+ * caller, who must free() it. 
+ */
+char const * * args_release(args_st * const args)
 {
-    int arg_added;
+    char const * * const argv = args->argv;
 
-    if (args->argc == args->slots_allocated)
+    if (argv != NULL)
     {
-        if (!args_increase_size(args))
-        {
-            arg_added = 0;
-            goto done;
-        }
+        argv[args->argc] = NULL;
     }
-    if (arg != NULL)
-    {
-        args->argv[args->argc] = strdup(arg);
-        if (args->argv[args->argc] == NULL)
-        {
-            arg_added = 0;
-            goto done;
-        }
-        args->argc++;
-    }
-    else
-    {
-        args->argv[args->argc] = NULL;
-    }
-    arg_added = 1;
+    args->argv = NULL;
 
-done:
-    return arg_added;
+    return argv;
 }
-
-
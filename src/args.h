@@ -8,17 +8,32 @@
 #define __ARGS_H__
 
 #include <stddef.h>
+#include <stdbool.h>
 
 typedef struct args_st args_st;
+/* An argv array built in a single block, with the strings that 
+ * the array points to following the array itself, so that the 
+ * whole lot is released by a single free(). The number of args 
+ * and the total length of their strings must be known beforehand 
+ * so that the block is only allocated once. Room for other data 
+ * that goes with the args can be included too, between the array 
+ * and the strings. 
+ */
 struct args_st
 {
-    size_t slots_allocated;
     size_t argc;
+    size_t maximum_args; /* The number of args there is space for, not including the NULL. */
     char const * * argv;
+    void * extra; /* The other data, or NULL if none was asked for. */
+    char * next_string; /* Where the next arg's string goes. */
 }; 
 
-void args_free(args_st const * const args);
-args_st * args_alloc(unsigned int const initial_size);
-int args_add_arg(args_st * const args, char const * const arg);
+bool args_alloc(args_st * const args, 
+                size_t const maximum_args, 
+                size_t const strings_length, 
+                size_t const extra_size);
+void args_free(args_st * const args);
+void args_add_arg(args_st * const args, char const * const arg, size_t const length);
+char const * * args_release(args_st * const args);
 
 #endif /* __ARGS_H__ */
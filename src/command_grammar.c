@@ -0,0 +1,343 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include "readline.h"
+#include "strdup_partial.h"
+#include "utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define COMMAND_GRAMMAR_MINIMUM_NODES 16
+#define NO_NODE 0 /* The root is never followed by another node, so 0 can mean "none". */
+
+typedef struct grammar_node_st grammar_node_st;
+/* A point in a command, reached by the keywords and args before 
+ * it. The keywords that can come next are in a trie whose IDs 
+ * are the indexes of the nodes they lead to. 
+ */
+struct grammar_node_st
+{
+    keyword_trie_st * keywords; /* NULL if no keyword can come next. */
+    size_t arg_node; /* The node reached by an arg that isn't a keyword, or NO_NODE. */
+    command_arg_type_t arg_type;
+    bool is_command; /* A command ends here. */
+    int id;
+};
+
+/* The nodes are kept in a single array that doubles in size when 
+ * it is full, and refer to each other by index so that the array 
+ * can be moved. Node 0 is the start of every command. 
+ */
+struct command_grammar_st
+{
+    grammar_node_st * nodes;
+    size_t num_nodes;
+    size_t nodes_size;
+};
+
+static size_t command_grammar_add_node(command_grammar_st * const grammar)
+{
+    size_t node_index;
+    grammar_node_st * node;
+
+    if (grammar->num_nodes == grammar->nodes_size)
+    {
+        size_t const new_size = MAX(grammar->nodes_size * 2, COMMAND_GRAMMAR_MINIMUM_NODES);
+        grammar_node_st * const new_nodes = realloc(grammar->nodes, new_size * sizeof *new_nodes);
+
+        if (new_nodes == NULL)
+        {
+            node_index = NO_NODE;
+            goto done;
+        }
+        grammar->nodes = new_nodes;
+        grammar->nodes_size = new_size;
+    }
+    node_index = grammar->num_nodes;
+    node = &grammar->nodes[node_index];
+    node->keywords = NULL;
+    node->arg_node = NO_NODE;
+    node->arg_type = command_arg_word;
+    node->is_command = false;
+    node->id = 0;
+    grammar->num_nodes++;
+
+done:
+    return node_index;
+}
+
+command_grammar_st * command_grammar_create(void)
+{
+    command_grammar_st * grammar;
+
+    grammar = calloc(1, sizeof *grammar);
+    if (grammar == NULL)
+    {
+        goto done;
+    }
+    /* The start of every command. */
+    command_grammar_add_node(grammar);
+    if (grammar->num_nodes == 0)
+    {
+        command_grammar_destroy(grammar);
+        grammar = NULL;
+        goto done;
+    }
+
+done:
+    return grammar;
+}
+
+void command_grammar_destroy(command_grammar_st * const grammar)
+{
+    size_t index;
+
+    if (grammar != NULL)
+    {
+        for (index = 0; index < grammar->num_nodes; index++)
+        {
+            keyword_trie_destroy(grammar->nodes[index].keywords);
+        }
+        free(grammar->nodes);
+        free(grammar);
+    }
+}
+
+static bool get_arg_type(char const * const element, size_t const length, command_arg_type_t * const arg_type)
+{
+    bool got_type;
+
+    if (length == strlen("<word>") && strncmp(element, "<word>", length) == 0)
+    {
+        *arg_type = command_arg_word;
+        got_type = true;
+    }
+    else if (length == strlen("<number>") && strncmp(element, "<number>", length) == 0)
+    {
+        *arg_type = command_arg_number;
+        got_type = true;
+    }
+    else
+    {
+        got_type = false;
+    }
+
+    return got_type;
+}
+
+/* Returns the node that the arg leads to from 'node_index', 
+ * adding it if it isn't already there. Returns NO_NODE if the 
+ * node can't be added, or there is already an arg of a different 
+ * type at this point. 
+ */
+static size_t command_grammar_add_arg(command_grammar_st * const grammar,
+                                      size_t const node_index,
+                                      command_arg_type_t const arg_type)
+{
+    size_t next_node;
+
+    next_node = grammar->nodes[node_index].arg_node;
+    if (next_node != NO_NODE)
+    {
+        if (grammar->nodes[node_index].arg_type != arg_type)
+        {
+            next_node = NO_NODE;
+        }
+        goto done;
+    }
+    next_node = command_grammar_add_node(grammar);
+    if (next_node == NO_NODE)
+    {
+        goto done;
+    }
+    grammar->nodes[node_index].arg_node = next_node;
+    grammar->nodes[node_index].arg_type = arg_type;
+
+done:
+    return next_node;
+}
+
+/* As command_grammar_add_arg(), but for a keyword. */
+static size_t command_grammar_add_keyword(command_grammar_st * const grammar,
+                                          size_t const node_index,
+                                          char const * const keyword,
+                                          size_t const length)
+{
+    size_t next_node;
+    keyword_match_st match;
+    char * keyword_copy = NULL;
+
+    if (grammar->nodes[node_index].keywords == NULL)
+    {
+        grammar->nodes[node_index].keywords = keyword_trie_create();
+        if (grammar->nodes[node_index].keywords == NULL)
+        {
+            next_node = NO_NODE;
+            goto done;
+        }
+    }
+    keyword_trie_lookup(grammar->nodes[node_index].keywords, keyword, length, &match);
+    /* An abbreviation of an existing keyword is a new keyword, so 
+     * only a match in full counts. 
+     */
+    if (match.result == keyword_match_unique && strlen(match.keyword) == length)
+    {
+        next_node = (size_t)match.id;
+        goto done;
+    }
+
+    keyword_copy = strdup_partial(keyword, 0, length);
+    next_node = command_grammar_add_node(grammar);
+    if (keyword_copy == NULL || next_node == NO_NODE)
+    {
+        next_node = NO_NODE;
+        goto done;
+    }
+    if (!keyword_trie_add(grammar->nodes[node_index].keywords, keyword_copy, (int)next_node, NULL))
+    {
+        /* The node added is left in place, but as nothing leads to 
+         * it, it is never reached. 
+         */
+        next_node = NO_NODE;
+        goto done;
+    }
+
+done:
+    free(keyword_copy);
+
+    return next_node;
+}
+
+bool command_grammar_add(command_grammar_st * const grammar, char const * const syntax, int const id)
+{
+    bool added;
+    char const * element = syntax;
+    size_t node_index = 0;
+
+    while (true)
+    {
+        size_t length;
+        command_arg_type_t arg_type;
+
+        element += strspn(element, " ");
+        length = strcspn(element, " ");
+        if (length == 0)
+        {
+            break;
+        }
+
+        if (element[0] == '<')
+        {
+            if (!get_arg_type(element, length, &arg_type))
+            {
+                added = false;
+                goto done;
+            }
+            node_index = command_grammar_add_arg(grammar, node_index, arg_type);
+        }
+        else
+        {
+            node_index = command_grammar_add_keyword(grammar, node_index, element, length);
+        }
+        if (node_index == NO_NODE)
+        {
+            added = false;
+            goto done;
+        }
+        element += length;
+    }
+
+    if (node_index == 0)
+    {
+        /* The syntax was empty. */
+        added = false;
+        goto done;
+    }
+    /* Adding a command again changes its ID. */
+    grammar->nodes[node_index].is_command = true;
+    grammar->nodes[node_index].id = id;
+    added = true;
+
+done:
+    return added;
+}
+
+static bool parse_number(char const * const arg, long * const number)
+{
+    bool parsed;
+    char * end;
+
+    errno = 0;
+    *number = strtol(arg, &end, 10);
+    parsed = *arg != '\0' && *end == '\0' && errno == 0;
+
+    return parsed;
+}
+
+void command_grammar_parse(command_grammar_st const * const grammar,
+                           size_t const argc,
+                           char const * const * const argv,
+                           command_arg_st * const args,
+                           command_st * const command)
+{
+    size_t node_index = 0;
+    size_t index;
+
+    command->id = 0;
+    command->args = args;
+    for (index = 0; index < argc; index++)
+    {
+        grammar_node_st const * const node = &grammar->nodes[node_index];
+        keyword_match_st match;
+
+        args[index].number = 0;
+        match.result = keyword_match_none;
+        if (node->keywords != NULL)
+        {
+            keyword_trie_lookup(node->keywords, argv[index], strlen(argv[index]), &match);
+        }
+        /* Keywords take priority over args, but a word that isn't 
+         * a keyword, or is an abbreviation of several, is taken as 
+         * an arg if one is allowed. 
+         */
+        if (match.result == keyword_match_unique)
+        {
+            args[index].type = command_arg_keyword;
+            node_index = (size_t)match.id;
+        }
+        else if (node->arg_node != NO_NODE)
+        {
+            args[index].type = node->arg_type;
+            if (node->arg_type == command_arg_number
+                && !parse_number(argv[index], &args[index].number))
+            {
+                command->syntax = command_syntax_bad_number;
+                goto done;
+            }
+            node_index = node->arg_node;
+        }
+        else
+        {
+            command->syntax = match.result == keyword_match_ambiguous
+                ? command_syntax_ambiguous_word
+                : command_syntax_unknown_word;
+            goto done;
+        }
+    }
+
+    if (!grammar->nodes[node_index].is_command)
+    {
+        command->syntax = command_syntax_incomplete;
+        goto done;
+    }
+    command->syntax = command_syntax_ok;
+    command->id = grammar->nodes[node_index].id;
+
+done:
+    command->error_index = index;
+}
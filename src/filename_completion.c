@@ -99,9 +99,9 @@ static int do_complete_filename_matches(completion_context_st * const completion
     /* If there is a single match append either a slash if the match
      * is a directory, else append a space. 
      */
-    if (private_completion_context->possible_words->argc == 1)
+    if (private_completion_context->num_possible_words == 1)
     {
-        process_unique_match(completion_context, directory_name, private_completion_context->possible_words->argv[0]);
+        process_unique_match(completion_context, directory_name, private_completion_context->possible_words[0]);
     }
 
     result = 0;
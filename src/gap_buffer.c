@@ -0,0 +1,259 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include "gap_buffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define GAP_BUFFER_MINIMUM_SIZE 16
+
+static size_t gap_buffer_get_gap_size(gap_buffer_st const * const gap_buffer)
+{
+    return gap_buffer->gap_end - gap_buffer->gap_start;
+}
+
+bool gap_buffer_init(gap_buffer_st * const gap_buffer, size_t const initial_size)
+{
+    bool init_ok;
+
+    gap_buffer->buffer = malloc(initial_size + 1);
+    if (gap_buffer->buffer == NULL)
+    {
+        gap_buffer->buffer_size = 0;
+        gap_buffer->gap_start = 0;
+        gap_buffer->gap_end = 0;
+        init_ok = false;
+        goto done;
+    }
+    gap_buffer->buffer_size = initial_size;
+    gap_buffer->gap_start = 0;
+    gap_buffer->gap_end = initial_size;
+    gap_buffer->buffer[gap_buffer->buffer_size] = '\0';
+    init_ok = true;
+
+done:
+    return init_ok;
+}
+
+void gap_buffer_teardown(gap_buffer_st * const gap_buffer)
+{
+    free(gap_buffer->buffer);
+    gap_buffer->buffer = NULL;
+    gap_buffer->buffer_size = 0;
+    gap_buffer->gap_start = 0;
+    gap_buffer->gap_end = 0;
+}
+
+/* Empty the buffer, keeping the memory for the next time. */
+void gap_buffer_clear(gap_buffer_st * const gap_buffer)
+{
+    gap_buffer->gap_start = 0;
+    gap_buffer->gap_end = gap_buffer->buffer_size;
+}
+
+/* Empty the buffer, and give back any memory beyond 
+ * maximum_size. Used once a buffer is idle so that one long line 
+ * doesn't tie up memory indefinitely. 
+ */
+void gap_buffer_trim(gap_buffer_st * const gap_buffer, size_t const maximum_size)
+{
+    gap_buffer_clear(gap_buffer);
+    if (gap_buffer->buffer_size > maximum_size)
+    {
+        char * const new_buffer = realloc(gap_buffer->buffer, maximum_size + 1);
+
+        /* If realloc() fails the original buffer is still usable. */
+        if (new_buffer != NULL)
+        {
+            gap_buffer->buffer = new_buffer;
+            gap_buffer->buffer_size = maximum_size;
+            gap_buffer->gap_end = maximum_size;
+            gap_buffer->buffer[gap_buffer->buffer_size] = '\0';
+        }
+    }
+}
+
+size_t gap_buffer_get_length(gap_buffer_st const * const gap_buffer)
+{
+    return gap_buffer->buffer_size - gap_buffer_get_gap_size(gap_buffer);
+}
+
+static size_t gap_buffer_get_buffer_index(gap_buffer_st const * const gap_buffer, size_t const index)
+{
+    return index < gap_buffer->gap_start ? index : index + gap_buffer_get_gap_size(gap_buffer);
+}
+
+/* Returns '\0' if index is beyond the end of the text. */
+char gap_buffer_get_char(gap_buffer_st const * const gap_buffer, size_t const index)
+{
+    char ch;
+
+    if (index >= gap_buffer_get_length(gap_buffer))
+    {
+        ch = '\0';
+    }
+    else
+    {
+        ch = gap_buffer->buffer[gap_buffer_get_buffer_index(gap_buffer, index)];
+    }
+
+    return ch;
+}
+
+void gap_buffer_set_char(gap_buffer_st * const gap_buffer, size_t const index, char const ch)
+{
+    if (index < gap_buffer_get_length(gap_buffer))
+    {
+        gap_buffer->buffer[gap_buffer_get_buffer_index(gap_buffer, index)] = ch;
+    }
+}
+
+/* Only the characters between the current and new gap 
+ * positions are moved. 
+ */
+static void gap_buffer_move_gap(gap_buffer_st * const gap_buffer, size_t const index)
+{
+    if (index < gap_buffer->gap_start)
+    {
+        size_t const chars_to_move = gap_buffer->gap_start - index;
+
+        memmove(&gap_buffer->buffer[gap_buffer->gap_end - chars_to_move], 
+                &gap_buffer->buffer[index], 
+                chars_to_move);
+        gap_buffer->gap_start -= chars_to_move;
+        gap_buffer->gap_end -= chars_to_move;
+    }
+    else if (index > gap_buffer->gap_start)
+    {
+        size_t const chars_to_move = index - gap_buffer->gap_start;
+
+        memmove(&gap_buffer->buffer[gap_buffer->gap_start], 
+                &gap_buffer->buffer[gap_buffer->gap_end], 
+                chars_to_move);
+        gap_buffer->gap_start += chars_to_move;
+        gap_buffer->gap_end += chars_to_move;
+    }
+}
+
+static bool gap_buffer_make_space(gap_buffer_st * const gap_buffer, size_t const space_required)
+{
+    bool have_space;
+    size_t const chars_after_gap = gap_buffer->buffer_size - gap_buffer->gap_end;
+    size_t new_buffer_size;
+    char * new_buffer;
+
+    if (gap_buffer_get_gap_size(gap_buffer) >= space_required)
+    {
+        have_space = true;
+        goto done;
+    }
+
+    /* Grow geometrically so that a long line only needs a few 
+     * reallocs. 
+     */
+    new_buffer_size = gap_buffer->buffer_size > 0 ? gap_buffer->buffer_size * 2 : GAP_BUFFER_MINIMUM_SIZE;
+    if (new_buffer_size < gap_buffer_get_length(gap_buffer) + space_required)
+    {
+        new_buffer_size = gap_buffer_get_length(gap_buffer) + space_required;
+    }
+    new_buffer = realloc(gap_buffer->buffer, new_buffer_size + 1);
+    if (new_buffer == NULL)
+    {
+        have_space = false;
+        goto done;
+    }
+    /* The text after the gap goes to the end of the new buffer. */
+    memmove(&new_buffer[new_buffer_size - chars_after_gap], 
+            &new_buffer[gap_buffer->gap_end], 
+            chars_after_gap);
+    gap_buffer->buffer = new_buffer;
+    gap_buffer->gap_end = new_buffer_size - chars_after_gap;
+    gap_buffer->buffer_size = new_buffer_size;
+    gap_buffer->buffer[gap_buffer->buffer_size] = '\0';
+    have_space = true;
+
+done:
+    return have_space;
+}
+
+bool gap_buffer_insert(gap_buffer_st * const gap_buffer, size_t const index, char const * const data, size_t const length)
+{
+    bool inserted;
+
+    if (index > gap_buffer_get_length(gap_buffer) || !gap_buffer_make_space(gap_buffer, length))
+    {
+        inserted = false;
+        goto done;
+    }
+    gap_buffer_move_gap(gap_buffer, index);
+    memcpy(&gap_buffer->buffer[gap_buffer->gap_start], data, length);
+    gap_buffer->gap_start += length;
+    inserted = true;
+
+done:
+    return inserted;
+}
+
+/* Delete length characters starting at index. The deleted 
+ * characters just become part of the gap. 
+ */
+void gap_buffer_delete(gap_buffer_st * const gap_buffer, size_t const index, size_t const length)
+{
+    size_t const text_length = gap_buffer_get_length(gap_buffer);
+    size_t chars_to_delete;
+
+    if (index >= text_length)
+    {
+        goto done;
+    }
+    chars_to_delete = length < text_length - index ? length : text_length - index;
+    gap_buffer_move_gap(gap_buffer, index);
+    gap_buffer->gap_end += chars_to_delete;
+
+done:
+    return;
+}
+
+/* Returns the text from index to the end as a NUL terminated 
+ * string. This moves the gap to index, so is cheap if the gap 
+ * is already nearby. 
+ */
+char const * gap_buffer_get_string_from(gap_buffer_st * const gap_buffer, size_t const index)
+{
+    size_t const text_length = gap_buffer_get_length(gap_buffer);
+
+    gap_buffer_move_gap(gap_buffer, index < text_length ? index : text_length);
+
+    return &gap_buffer->buffer[gap_buffer->gap_end];
+}
+
+/* Returns the text before index. This isn't NUL terminated, 
+ * but is contiguous because the gap is moved to index. 
+ */
+char const * gap_buffer_get_text_before(gap_buffer_st * const gap_buffer, size_t const index)
+{
+    size_t const text_length = gap_buffer_get_length(gap_buffer);
+
+    gap_buffer_move_gap(gap_buffer, index < text_length ? index : text_length);
+
+    return gap_buffer->buffer;
+}
+
+/* Returns the whole of the text as a NUL terminated string. 
+ * This moves the gap to the end of the text, so should only be 
+ * used when a contiguous copy of the text is really needed. 
+ */
+char const * gap_buffer_get_string(gap_buffer_st * const gap_buffer)
+{
+    gap_buffer_move_gap(gap_buffer, gap_buffer_get_length(gap_buffer));
+    /* Either this is in the gap, or it is the terminating NUL 
+     * after the end of the buffer. 
+     */
+    gap_buffer->buffer[gap_buffer->gap_start] = '\0';
+
+    return gap_buffer->buffer;
+}
@@ -0,0 +1,47 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#ifndef __GAP_BUFFER_H__
+#define __GAP_BUFFER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct gap_buffer_st gap_buffer_st;
+/* Text with a gap of unused space where the next edit is made. 
+ * Edits at the gap don't require the rest of the text to be 
+ * moved, so typing and deleting at the cursor cost the same 
+ * regardless of the length of the line. The gap only moves 
+ * when an edit is made somewhere else. 
+ * The text is held in buffer[0, gap_start) and 
+ * buffer[gap_end, buffer_size). buffer[buffer_size] is always 
+ * '\0', so the text after the gap is always NUL terminated. 
+ */
+struct gap_buffer_st
+{
+    char * buffer;
+    size_t buffer_size; /* Excludes the terminating NUL. */
+    size_t gap_start;
+    size_t gap_end;
+};
+
+bool gap_buffer_init(gap_buffer_st * const gap_buffer, size_t const initial_size);
+void gap_buffer_teardown(gap_buffer_st * const gap_buffer);
+void gap_buffer_clear(gap_buffer_st * const gap_buffer);
+void gap_buffer_trim(gap_buffer_st * const gap_buffer, size_t const maximum_size);
+
+size_t gap_buffer_get_length(gap_buffer_st const * const gap_buffer);
+char gap_buffer_get_char(gap_buffer_st const * const gap_buffer, size_t const index);
+void gap_buffer_set_char(gap_buffer_st * const gap_buffer, size_t const index, char const ch);
+
+bool gap_buffer_insert(gap_buffer_st * const gap_buffer, size_t const index, char const * const data, size_t const length);
+void gap_buffer_delete(gap_buffer_st * const gap_buffer, size_t const index, size_t const length);
+
+char const * gap_buffer_get_string(gap_buffer_st * const gap_buffer);
+char const * gap_buffer_get_string_from(gap_buffer_st * const gap_buffer, size_t const index);
+char const * gap_buffer_get_text_before(gap_buffer_st * const gap_buffer, size_t const index);
+
+#endif /* __GAP_BUFFER_H__ */
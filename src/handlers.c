@@ -9,6 +9,7 @@
 #include "terminal.h"
 #include "read_char.h"
 #include "help.h"
+#include "multi_line.h"
 
 #include <string.h>
 #include <ctype.h>
@@ -16,14 +17,25 @@
 static readline_status_t handle_enter(readline_st * const readline_ctx)
 {
     line_context_st * const line_ctx = &readline_ctx->line_context;
+    readline_status_t status;
+
+    if (multi_line_need_more_input(readline_ctx))
+    {
+        multi_line_start_next_row(readline_ctx);
+        status = readline_status_continue;
+        goto done;
+    }
+    multi_line_finish(readline_ctx);
 
     /* Move the cursor to the end of the line so that any output 
      * from the application will go after this line. 
      */
     move_cursor_right_n_columns(line_ctx, line_ctx->line_length - line_ctx->edit_index);
-    tty_put(line_ctx->terminal_fd, '\n');
+    tty_put(line_ctx->output, '\n');
+    status = readline_status_done;
 
-    return readline_status_done;
+done:
+    return status;
 }
 
 static void handle_control_t(readline_st * const readline_ctx)
@@ -31,22 +43,86 @@ static void handle_control_t(readline_st * const readline_ctx)
     transpose_characters(&readline_ctx->line_context);
 }
 
+/* Save the characters between start and end so they can be 
+ * yanked back with CTRL-Y. A masked line, such as a password, is 
+ * never saved. 
+ */
+static void save_killed_chars(readline_st * const readline_ctx, size_t const start, size_t const end)
+{
+    if (end > start && readline_ctx->mask_character == '\0')
+    {
+        kill_ring_add(&readline_ctx->kill_ring, 
+                      line_context_get_line_from(&readline_ctx->line_context, start), 
+                      end - start);
+    }
+}
+
 static void handle_control_w(readline_st * const readline_ctx)
 {
-    delete_previous_word(&readline_ctx->line_context);
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+
+    save_killed_chars(readline_ctx, get_index_of_start_of_previous_word(line_ctx), line_ctx->edit_index);
+    delete_previous_word(line_ctx);
 }
 
 static void handle_control_k(readline_st * const readline_ctx)
 {
-    /* TODO: Save the characters deleted so they can be inserted 
-     * using CTRL-Y? 
-     */
-    delete_from_cursor_to_end(&readline_ctx->line_context);
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+
+    save_killed_chars(readline_ctx, line_ctx->edit_index, line_ctx->line_length);
+    delete_from_cursor_to_end(line_ctx);
 }
 
 static void handle_control_u(readline_st * const readline_ctx)
 {
-    delete_from_start_to_cursor(&readline_ctx->line_context);
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+
+    save_killed_chars(readline_ctx, 0, line_ctx->edit_index);
+    delete_from_start_to_cursor(line_ctx);
+}
+
+/* Insert the text from the kill ring, replacing 
+ * chars_to_replace characters before the cursor. 
+ */
+static void yank(readline_st * const readline_ctx, size_t const age, size_t const chars_to_replace)
+{
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+    size_t length;
+    char const * const text = kill_ring_get(&readline_ctx->kill_ring, age, &length);
+    size_t start_index;
+
+    if (text == NULL || readline_ctx->mask_character != '\0')
+    {
+        goto done;
+    }
+    move_cursor_left_n_columns(line_ctx, chars_to_replace);
+    start_index = line_ctx->edit_index;
+    replace_chars(line_ctx, chars_to_replace, text, length);
+
+    readline_ctx->yank_age = age;
+    readline_ctx->yanked_length = line_ctx->edit_index - start_index;
+    readline_ctx->yank_key_count = readline_ctx->key_count;
+
+done:
+    return;
+}
+
+static void handle_control_y(readline_st * const readline_ctx)
+{
+    yank(readline_ctx, 0, 0);
+}
+
+/* Replace the text just yanked with the kill before it. Only 
+ * does anything straight after CTRL-Y or ALT-Y. 
+ */
+static void handle_alt_y(readline_st * const readline_ctx)
+{
+    size_t const num_kills = kill_ring_get_num_kills(&readline_ctx->kill_ring);
+
+    if (num_kills > 0 && readline_ctx->yank_key_count + 1 == readline_ctx->key_count)
+    {
+        yank(readline_ctx, (readline_ctx->yank_age + 1) % num_kills, readline_ctx->yanked_length);
+    }
 }
 
 static void handle_control_left(readline_st * const readline_ctx)
@@ -61,7 +137,20 @@ static void handle_control_right(readline_st * const readline_ctx)
 
 static void handle_alt_d(readline_st * const readline_ctx)
 {
-    delete_to_next_word(&readline_ctx->line_context); 
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+
+    save_killed_chars(readline_ctx, line_ctx->edit_index, get_index_of_end_of_next_word(line_ctx));
+    delete_to_next_word(line_ctx); 
+}
+
+static void handle_undo(readline_st * const readline_ctx)
+{
+    undo_edit(&readline_ctx->line_context);
+}
+
+static void handle_redo(readline_st * const readline_ctx)
+{
+    redo_edit(&readline_ctx->line_context);
 }
 
 static void handle_tab(readline_st * const readline_ctx)
@@ -116,6 +205,12 @@ readline_status_t handle_control_char(readline_st * const readline_ctx, int cons
         case CTL('E'):
             handle_end_key(readline_ctx);
             break;
+        case CTL('Y'):
+            handle_control_y(readline_ctx);
+            break;
+        case CTL('_'):
+            handle_undo(readline_ctx);
+            break;
         default:  /* silently ignore any control character that isn't supported. */
             break;
     }
@@ -146,14 +241,18 @@ void handle_backspace(readline_st * const readline_ctx)
 {
     line_context_st * const line_ctx = &readline_ctx->line_context;
 
+    undo_log_begin_typing(&line_ctx->undo_log);
     delete_char_to_the_left(line_ctx);
+    undo_log_end_typing(&line_ctx->undo_log);
 }
 
 static void handle_delete(readline_st * const readline_ctx)
 {
     line_context_st * const line_ctx = &readline_ctx->line_context;
 
+    undo_log_begin_typing(&line_ctx->undo_log);
     delete_char_to_the_right(line_ctx, true);
+    undo_log_end_typing(&line_ctx->undo_log);
 }
 
 static void handle_up_arrow(readline_st * const readline_ctx)
@@ -162,12 +261,16 @@ static void handle_up_arrow(readline_st * const readline_ctx)
     line_context_st * const line_ctx = &readline_ctx->line_context;
     char const * historic_line;
 
+    if (multi_line_move_up(readline_ctx))
+    {
+        goto done;
+    }
     if (history_currently_at_most_recent(readline_ctx->history))
     {
         /* save the current line in case the user returns to the top 
          * of the history 
          */
-        save_string(line_ctx, &readline_ctx->saved_line);
+        saved_line_save(&readline_ctx->saved_line, line_ctx);
     }
     historic_line = history_get_older_entry(history);
 
@@ -175,6 +278,9 @@ static void handle_up_arrow(readline_st * const readline_ctx)
     {
         replace_edit_line(line_ctx, historic_line);
     }
+
+done:
+    return;
 }
 
 static void handle_down_arrow(readline_st * const readline_ctx)
@@ -182,12 +288,18 @@ static void handle_down_arrow(readline_st * const readline_ctx)
     history_st * const history = readline_ctx->history;
     char const * replacement_line;
 
+    if (multi_line_move_down(readline_ctx))
+    {
+        goto done;
+    }
     replacement_line = history_get_newer_entry(history);
     if (replacement_line == NULL)
     {
         if (history_currently_at_most_recent(history))
         {
-            if (readline_ctx->saved_line != NULL)
+            char const * const saved_line = saved_line_get(&readline_ctx->saved_line);
+
+            if (saved_line != NULL)
             {
                 line_context_st * line_ctx = &readline_ctx->line_context;
 
@@ -195,9 +307,9 @@ static void handle_down_arrow(readline_st * const readline_ctx)
                  * replaced it, we'd get the side-effect that the current 
                  * cursor editing position would jump to the end of the line. 
                  */
-                if (strcmp(line_ctx->edit_buffer, readline_ctx->saved_line) != 0)
+                if (strcmp(line_context_get_line(line_ctx), saved_line) != 0)
                 {
-                    replacement_line = readline_ctx->saved_line;
+                    replacement_line = saved_line;
                 }
             }
         }
@@ -208,11 +320,14 @@ static void handle_down_arrow(readline_st * const readline_ctx)
         line_context_st * line_ctx = &readline_ctx->line_context;
 
         replace_edit_line(line_ctx, replacement_line);
-        if (replacement_line == readline_ctx->saved_line)
+        if (replacement_line == saved_line_get(&readline_ctx->saved_line))
         {
-            free_saved_string(&readline_ctx->saved_line);
+            saved_line_clear(&readline_ctx->saved_line);
         }
     }
+
+done:
+    return;
 }
 
 static void handle_shift_up(readline_st * const readline_ctx)
@@ -229,14 +344,19 @@ static void handle_shift_down(readline_st * const readline_ctx)
     move_cursor_right_n_columns(line_ctx, line_ctx->terminal_width);
 }
 
+static int read_escape_sequence_char(readline_st * const readline_ctx, readline_status_t * const status)
+{
+    return read_char_from_input(readline_ctx,
+                                readline_ctx->maximum_seconds_to_wait_for_char,
+                                status);
+}
+
 static readline_status_t handle_escape_o(readline_st * const readline_ctx)
 {
     readline_status_t status;
     int escape_command_char;
 
-    escape_command_char = read_char_from_input(readline_ctx->in_fd,
-                                               readline_ctx->maximum_seconds_to_wait_for_char,
-                                               &status);
+    escape_command_char = read_escape_sequence_char(readline_ctx, &status);
     if (status != readline_status_continue)
     {
         goto done;
@@ -259,12 +379,16 @@ done:
     return status;
 }
 
-static void handle_escape_left_bracket_1_semicolon_2(readline_st * const readline_ctx)
+static readline_status_t handle_escape_left_bracket_1_semicolon_2(readline_st * const readline_ctx)
 {
+    readline_status_t status;
     int ch;
 
-    ch = '\0';
-    tty_get(readline_ctx->in_fd, readline_ctx->maximum_seconds_to_wait_for_char, &ch);
+    ch = read_escape_sequence_char(readline_ctx, &status);
+    if (status != readline_status_continue)
+    {
+        goto done;
+    }
     switch (ch)
     {
         case 'A':
@@ -282,14 +406,21 @@ static void handle_escape_left_bracket_1_semicolon_2(readline_st * const readlin
             /* Shift + left arrow. */
             break;
     }
+
+done:
+    return status;
 }
 
-static void handle_escape_left_bracket_1_semicolon_5(readline_st * const readline_ctx)
+static readline_status_t handle_escape_left_bracket_1_semicolon_5(readline_st * const readline_ctx)
 {
+    readline_status_t status;
     int ch;
 
-    ch = '\0';
-    tty_get(readline_ctx->in_fd, readline_ctx->maximum_seconds_to_wait_for_char, &ch);
+    ch = read_escape_sequence_char(readline_ctx, &status);
+    if (status != readline_status_continue)
+    {
+        goto done;
+    }
     switch (ch)
     {
         case 'A':
@@ -307,74 +438,117 @@ static void handle_escape_left_bracket_1_semicolon_5(readline_st * const readlin
             handle_control_left(readline_ctx);
             break;
     }
+
+done:
+    return status;
 }
 
-static void handle_escape_left_bracket_1_semicolon(readline_st * const readline_ctx)
+static readline_status_t handle_escape_left_bracket_1_semicolon(readline_st * const readline_ctx)
 {
+    readline_status_t status;
     int ch;
 
-    ch = '\0';
-    tty_get(readline_ctx->in_fd, readline_ctx->maximum_seconds_to_wait_for_char, &ch);
+    ch = read_escape_sequence_char(readline_ctx, &status);
+    if (status != readline_status_continue)
+    {
+        goto done;
+    }
     switch (ch)
     {
         case '2':
-            handle_escape_left_bracket_1_semicolon_2(readline_ctx);
+            status = handle_escape_left_bracket_1_semicolon_2(readline_ctx);
             break;
         case '5':
-            handle_escape_left_bracket_1_semicolon_5(readline_ctx);
+            status = handle_escape_left_bracket_1_semicolon_5(readline_ctx);
             break;
     }
+
+done:
+    return status;
 }
 
-static void handle_escape_left_bracket_1(readline_st * const readline_ctx)
+static readline_status_t handle_escape_left_bracket_1(readline_st * const readline_ctx)
 {
+    readline_status_t status;
     int ch;
 
-    ch = '\0';
-    tty_get(readline_ctx->in_fd, readline_ctx->maximum_seconds_to_wait_for_char, &ch);
+    ch = read_escape_sequence_char(readline_ctx, &status);
+    if (status != readline_status_continue)
+    {
+        goto done;
+    }
     switch (ch)
     {
         case '~':
             handle_home_key(readline_ctx);
             break;
         case ';':
-            handle_escape_left_bracket_1_semicolon(readline_ctx);
+            status = handle_escape_left_bracket_1_semicolon(readline_ctx);
             break;
     }
+
+done:
+    return status;
 }
 
-static void handle_escape_left_bracket_3(readline_st * const readline_ctx)
+static readline_status_t handle_escape_left_bracket_3(readline_st * const readline_ctx)
 {
-    int ch = '\0';
+    readline_status_t status;
+    int ch;
 
-    tty_get(readline_ctx->in_fd, readline_ctx->maximum_seconds_to_wait_for_char, &ch);
+    ch = read_escape_sequence_char(readline_ctx, &status);
+    if (status != readline_status_continue)
+    {
+        goto done;
+    }
     if (ch == '~')
     {
         handle_delete(readline_ctx);
     }
     else if (ch == ';')
     {
-        tty_get(readline_ctx->in_fd, readline_ctx->maximum_seconds_to_wait_for_char, &ch);
+        ch = read_escape_sequence_char(readline_ctx, &status);
+        if (status != readline_status_continue)
+        {
+            goto done;
+        }
         if (ch == '5')
         {
-            tty_get(readline_ctx->in_fd, readline_ctx->maximum_seconds_to_wait_for_char, &ch);
+            ch = read_escape_sequence_char(readline_ctx, &status);
+            if (status != readline_status_continue)
+            {
+                goto done;
+            }
             if (ch == '~')
             {
                 /* CTRL-DEL */
             }
         }
     }
+
+done:
+    return status;
+}
+
+/* Read the '~' that terminates sequences like "ESC [ 2 ~". */
+static readline_status_t read_tilde(readline_st * const readline_ctx, bool * const got_tilde)
+{
+    readline_status_t status;
+    int ch;
+
+    ch = read_escape_sequence_char(readline_ctx, &status);
+    *got_tilde = status == readline_status_continue && ch == '~';
+
+    return status;
 }
 
 static readline_status_t handle_escape_left_bracket(readline_st * const readline_ctx)
 {
     readline_status_t status;
     int escape_command_char;
-    int ch;
+    bool got_tilde;
 
-    escape_command_char = read_char_from_input(readline_ctx->in_fd,
-                                               readline_ctx->maximum_seconds_to_wait_for_char,
-                                               &status);
+    escape_command_char = read_escape_sequence_char(readline_ctx, &status);
     if (status != readline_status_continue)
     {
         goto done;
@@ -383,39 +557,35 @@ static readline_status_t handle_escape_left_bracket(readline_st * const readline
     switch (escape_command_char)
     {
         case '1':
-            handle_escape_left_bracket_1(readline_ctx);
+            status = handle_escape_left_bracket_1(readline_ctx);
             break;
         case '2':
-            ch = '\0';
-            tty_get(readline_ctx->in_fd, readline_ctx->maximum_seconds_to_wait_for_char, &ch);
-            if (ch == '~')
+            status = read_tilde(readline_ctx, &got_tilde);
+            if (got_tilde)
             {
                 handle_insert_key(readline_ctx);
             }
             break;
         case '3':
-            handle_escape_left_bracket_3(readline_ctx);
+            status = handle_escape_left_bracket_3(readline_ctx);
             break;
         case '4':
-            ch = '\0';
-            tty_get(readline_ctx->in_fd, readline_ctx->maximum_seconds_to_wait_for_char, &ch);
-            if (ch == '~')
+            status = read_tilde(readline_ctx, &got_tilde);
+            if (got_tilde)
             {
                 handle_end_key(readline_ctx);
             }
             break;
         case '5':
-            ch = '\0';
-            tty_get(readline_ctx->in_fd, readline_ctx->maximum_seconds_to_wait_for_char, &ch);
-            if (ch == '~')
+            status = read_tilde(readline_ctx, &got_tilde);
+            if (got_tilde)
             {
                 // TODO: handle_page_up(readline_ctx);
             }
             break;
         case '6':
-            ch = '\0';
-            tty_get(readline_ctx->in_fd, readline_ctx->maximum_seconds_to_wait_for_char, &ch);
-            if (ch == '~')
+            status = read_tilde(readline_ctx, &got_tilde);
+            if (got_tilde)
             {
                 // TODO: handle_page_down(readline_ctx);
             }
@@ -447,9 +617,7 @@ readline_status_t handle_escaped_char(readline_st * const readline_ctx)
     readline_status_t status;
     int escaped_char;
 
-    escaped_char = read_char_from_input(readline_ctx->in_fd,
-                                        readline_ctx->maximum_seconds_to_wait_for_char,
-                                        &status);
+    escaped_char = read_escape_sequence_char(readline_ctx, &status);
     if (status != readline_status_continue)
     {
         goto done;
@@ -466,6 +634,14 @@ readline_status_t handle_escaped_char(readline_st * const readline_ctx)
     {
         handle_alt_d(readline_ctx);
     }
+    else if (escaped_char == 'y' || escaped_char == 'Y')
+    {
+        handle_alt_y(readline_ctx);
+    }
+    else if (escaped_char == '_')
+    {
+        handle_redo(readline_ctx);
+    }
     else
     {
         /* Silently ignore other characters. */
@@ -483,7 +659,11 @@ void handle_regular_char(readline_st * const readline_ctx, int const ch, bool co
     }
     else
     {
-        write_char(&readline_ctx->line_context, ch, readline_ctx->insert_mode, update_terminal);
+        line_context_st * const line_ctx = &readline_ctx->line_context;
+
+        undo_log_begin_typing(&line_ctx->undo_log);
+        write_char(line_ctx, ch, readline_ctx->insert_mode, update_terminal);
+        undo_log_end_typing(&line_ctx->undo_log);
     }
 }
 
@@ -6,11 +6,10 @@
 
 #include "help.h"
 #include "tokenise.h"
-#include "args.h"
-#include "strdup_partial.h"
 #include "common_prefix_length.h"
 #include "print_words_in_columns.h"
 #include "readline_context.h"
+#include "multi_line.h"
 #include "terminal.h"
 #include "utils.h"
 
@@ -23,6 +22,7 @@ typedef struct private_help_context_st private_help_context_st;
 struct private_help_context_st
 {
     tokens_st * tokens;
+    char const * line; /* The line the token spans refer to. */
 
     help_context_st public_context;
 }; 
@@ -35,7 +35,26 @@ static char const * get_token_at_index(help_context_st * const help_context, siz
     private_help_context_st * const private_help_context =
         GET_PRIVATE_CONTEXT_FROM_PUBLIC_CONTEXT(help_context); 
 
-    return tokens_get_token_at_index(private_help_context->tokens, index);
+    return tokens_get_token_value_at_index(private_help_context->tokens, index);
+}
+
+static bool get_token_span_at_index(help_context_st * const help_context, 
+                                    size_t const index, 
+                                    token_span_st * const span)
+{
+    private_help_context_st * const private_help_context =
+        GET_PRIVATE_CONTEXT_FROM_PUBLIC_CONTEXT(help_context); 
+
+    return tokens_get_token_span(private_help_context->tokens, private_help_context->line, index, span);
+}
+
+static size_t get_preceding_token_spans(help_context_st * const help_context, 
+                                        token_span_st const * * const spans)
+{
+    private_help_context_st * const private_help_context =
+        GET_PRIVATE_CONTEXT_FROM_PUBLIC_CONTEXT(help_context); 
+
+    return tokens_get_preceding_token_spans(private_help_context->tokens, private_help_context->line, spans);
 }
 
 static void private_help_context_teardown(private_help_context_st * const private_help_context)
@@ -47,29 +66,44 @@ static void private_help_context_teardown(private_help_context_st * const privat
         close(help_context->write_back_fd);
     }
 
-    tokens_free(private_help_context->tokens);
+    private_help_context->tokens = NULL;
+    private_help_context->line = NULL;
 }
 
 static bool private_help_context_init(private_help_context_st * const private_help_context, 
-                                      line_context_st * const line_ctx,
-                                      char const * const field_separators)
+                                      line_context_st * const line_ctx, 
+                                      bool const wait_until_writable)
 {
     help_context_st * const help_context = &private_help_context->public_context;
     bool init_ok;
 
     memset(private_help_context, 0, sizeof *private_help_context);
-
-    private_help_context->tokens = tokenise_line(line_ctx->edit_buffer, 0, line_ctx->edit_index, true, field_separators);
-    if (private_help_context->tokens == NULL)
+    *(int *)&help_context->write_back_fd = -1;
+    private_help_context->tokens = line_context_get_tokens(line_ctx);
+    /* The number of tokens is handed to the callback, so all of 
+     * them are needed. 
+     */
+    if (private_help_context->tokens == NULL || !tokens_find_all(private_help_context->tokens))
     {
         init_ok = false;
         goto done;
     }
+    private_help_context->line = line_context_get_line(line_ctx);
 
     /* The casts are required because the struct members are 
      * marked as const. 
      */
-    *(int *)&help_context->write_back_fd = dup(line_ctx->terminal_fd);
+    /* The callback writes directly to the file descriptor, so 
+     * anything already queued must go out first. In non-blocking 
+     * mode the key isn't processed until the queue has drained, so 
+     * this only fails if the output has backed up again. 
+     */
+    if (output_queue_flush(line_ctx->output, wait_until_writable) == output_queue_flush_result_pending)
+    {
+        init_ok = false;
+        goto done;
+    }
+    *(int *)&help_context->write_back_fd = dup(line_ctx->output->fd);
     if (help_context->write_back_fd == -1)
     {
         init_ok = false;
@@ -78,7 +112,11 @@ static bool private_help_context_init(private_help_context_st * const private_he
     *(size_t *)&help_context->current_token_index = tokens_get_current_token_index(private_help_context->tokens);
     *(char const * *)&help_context->current_token = tokens_get_current_token(private_help_context->tokens);
     *(size_t *)&help_context->num_tokens = tokens_get_num_tokens(private_help_context->tokens);
+    tokens_get_current_segment(private_help_context->tokens, (token_segment_st *)&help_context->current_segment);
     *(help_tokens_get_token_at_index_fn *)&help_context->tokens_get_token_at_index_fn = get_token_at_index;
+    *(help_tokens_get_token_span_at_index_fn *)&help_context->tokens_get_token_span_at_index_fn = get_token_span_at_index;
+    *(help_tokens_get_preceding_token_spans_fn *)&help_context->tokens_get_preceding_token_spans_fn = 
+        get_preceding_token_spans;
 
     init_ok = true;
 
@@ -101,9 +139,7 @@ static void private_help_context_process_results(private_help_context_st * const
 
     if (need_to_redisplay_line)
     {
-        line_context_st * const line_ctx = &readline_ctx->line_context;
-
-        redisplay_line(line_ctx);
+        multi_line_redisplay(readline_ctx);
     }
 }
 
@@ -116,7 +152,7 @@ void do_help(readline_st * const readline_ctx)
         line_context_st * const line_ctx = &readline_ctx->line_context;
         private_help_context_st private_help_context;
 
-        if (!private_help_context_init(&private_help_context, line_ctx, readline_ctx->field_separators))
+        if (!private_help_context_init(&private_help_context, line_ctx, !readline_ctx->non_blocking))
         {
             goto done;
         }
@@ -23,12 +23,6 @@ struct history_st
     history_entry_st const * current_entry;
 }; 
 
-static void history_remove_and_free_entry(history_st * const history, history_entry_st * const entry)
-{
-    history_remove_entry_from_list(history->entries, entry);
-    history_entry_free(entry);
-}
-
 static void history_add_entry(history_st * const history, history_entry_st * const entry)
 {
     history_add_new_entry_to_list(history->entries, entry);
@@ -72,17 +66,6 @@ done:
     return is_duplicate_of_last;
 }
 
-static void history_remove_oldest_entry(history_st * const history)
-{
-    history_entry_st * const oldest_entry = history_get_oldest_entry_from_list(history->entries);
-
-    if (oldest_entry != NULL)
-    {
-        history_remove_and_free_entry(history, oldest_entry);
-    }
-}
-
-
 static history_entry_st * history_get_previous_entry(history_st * const history, history_entry_st const * const entry)
 {
     history_entry_st * previous_entry;
@@ -181,17 +164,42 @@ bool history_add(history_st * const history, char const * const str)
         goto done;
     }
 
-    new_entry = history_entry_alloc(str);
-    if (new_entry == NULL)
+    if (history_entries_get_count(history->entries) == history->max_entries 
+        && history->max_entries > 0)
     {
-        added = false;
-        goto done;
+        /* History is full. Reuse the oldest entry for the new 
+         * line. 
+         */
+        new_entry = history_get_oldest_entry_from_list(history->entries);
+        history_remove_entry_from_list(history->entries, new_entry);
+        if (!history_entry_set_value(new_entry, str))
+        {
+            history_entry_free(new_entry);
+            added = false;
+            goto done;
+        }
     }
-
-    if (history_entries_get_count(history->entries) == history->max_entries)
+    else
     {
-        /* History is full. Remove the oldest entry. */
-        history_remove_oldest_entry(history);
+        /* Reuse an entry left over from before the history was 
+         * cleared if there is one. 
+         */
+        new_entry = history_get_spare_entry(history->entries);
+        if (new_entry != NULL && !history_entry_set_value(new_entry, str))
+        {
+            history_entry_free(new_entry);
+            added = false;
+            goto done;
+        }
+        if (new_entry == NULL)
+        {
+            new_entry = history_entry_alloc(str);
+        }
+        if (new_entry == NULL)
+        {
+            added = false;
+            goto done;
+        }
     }
 
     history_add_entry(history, new_entry);
@@ -210,6 +218,18 @@ void history_reset(history_st * const history)
     }
 }
 
+/* Forget all lines. The memory used by the entries is kept for 
+ * the lines added next. 
+ */
+void history_clear(history_st * const history)
+{
+    if (HISTORY_IS_VALID(history))
+    {
+        history_entries_clear(history->entries);
+        history->current_entry = NULL;
+    }
+}
+
 bool history_currently_at_most_recent(history_st * const history)
 {
     bool at_most_recent;
@@ -18,17 +18,20 @@ struct history_entries_st
 {
     history_entries_list_st list;
     size_t num_entries;
+    history_entries_list_st spare_list; /* Entries that have been cleared, kept for reuse. */
 };
 
 struct history_entry_st
 {
     TAILQ_ENTRY(history_entry_st) entry;
-    char const * value;
+    char * value;
+    size_t value_size; /* Amount of memory allocated for the value. */
 }; 
 
 static void history_init_list(history_entries_st * const entries)
 {
     TAILQ_INIT(&entries->list);
+    TAILQ_INIT(&entries->spare_list);
 }
 
 static void history_entries_init(history_entries_st * const entries)
@@ -48,6 +51,13 @@ static void history_free_all_entries(history_entries_st * const entries)
         history_remove_entry_from_list(entries, entry);
         history_entry_free(entry);
     }
+    for (entry = TAILQ_FIRST(&entries->spare_list);
+         entry != NULL;
+         entry = TAILQ_FIRST(&entries->spare_list))
+    {
+        TAILQ_REMOVE(&entries->spare_list, entry, entry);
+        history_entry_free(entry);
+    }
 }
 
 history_entry_st * history_get_oldest_entry_from_list(history_entries_st const * const entries)
@@ -115,6 +125,29 @@ void history_add_new_entry_to_list(history_entries_st * const entries, history_e
     entries->num_entries++;
 }
 
+/* Remove all entries from the list, but keep them, and the 
+ * memory for their values, to be reused by 
+ * history_get_spare_entry(). 
+ */
+void history_entries_clear(history_entries_st * const entries)
+{
+    TAILQ_CONCAT(&entries->spare_list, &entries->list, entry);
+    entries->num_entries = 0;
+}
+
+/* Returns NULL if there are no spare entries. */
+history_entry_st * history_get_spare_entry(history_entries_st * const entries)
+{
+    history_entry_st * const entry = TAILQ_FIRST(&entries->spare_list);
+
+    if (entry != NULL)
+    {
+        TAILQ_REMOVE(&entries->spare_list, entry, entry);
+    }
+
+    return entry;
+}
+
 void history_entry_free(history_entry_st * const entry)
 {
     if (entry != NULL)
@@ -136,8 +169,7 @@ history_entry_st * history_entry_alloc(char const * const value)
 
     if (value != NULL)
     {
-        entry->value = strdup(value);
-        if (entry->value == NULL)
+        if (!history_entry_set_value(entry, value))
         {
             history_entry_free(entry);
             entry = NULL;
@@ -149,6 +181,35 @@ done:
     return entry;
 }
 
+/* The entry's memory is reused if the new value fits, so once 
+ * the history is full, adding lines to it doesn't usually need 
+ * any memory to be allocated. 
+ */
+bool history_entry_set_value(history_entry_st * const entry, char const * const value)
+{
+    bool value_set;
+    size_t const size_required = strlen(value) + 1;
+
+    if (size_required > entry->value_size)
+    {
+        size_t const new_value_size = MAX(size_required, entry->value_size * 2);
+        char * const new_value = realloc(entry->value, new_value_size);
+
+        if (new_value == NULL)
+        {
+            value_set = false;
+            goto done;
+        }
+        entry->value = new_value;
+        entry->value_size = new_value_size;
+    }
+    memcpy(entry->value, value, size_required);
+    value_set = true;
+
+done:
+    return value_set;
+}
+
 char const * history_entry_get_value(history_entry_st const * const entry)
 {
     return entry->value;
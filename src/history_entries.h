@@ -7,6 +7,7 @@
 #ifndef __HISTORY_ENTRIES_H__
 #define __HISTORY_ENTRIES_H__
 
+#include <stdbool.h>
 #include <stddef.h>
 
 typedef struct history_entry_st history_entry_st;
@@ -18,8 +19,11 @@ history_entry_st * history_get_older_entry_from_list(history_entries_st const *
 history_entry_st * history_get_newer_entry_from_list(history_entries_st const * const entries, history_entry_st const * const entry);
 void history_remove_entry_from_list(history_entries_st * const entries, history_entry_st * const entry);
 void history_add_new_entry_to_list(history_entries_st * const entries, history_entry_st * const entry);
+void history_entries_clear(history_entries_st * const entries);
+history_entry_st * history_get_spare_entry(history_entries_st * const entries);
 void history_entry_free(history_entry_st * const entry);
 history_entry_st * history_entry_alloc(char const * const value);
+bool history_entry_set_value(history_entry_st * const entry, char const * const value);
 char const * history_entry_get_value(history_entry_st const * const entry);
 size_t history_entries_get_count(history_entries_st * const entries);
 history_entries_st * history_entries_alloc(void);
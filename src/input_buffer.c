@@ -0,0 +1,101 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include "input_buffer.h"
+
+#include <string.h>
+
+void input_buffer_init(input_buffer_st * const input_buffer)
+{
+    input_buffer->read_index = 0;
+    input_buffer->write_index = 0;
+    input_buffer->mark_index = 0;
+    input_buffer->needs_more_input = false;
+}
+
+bool input_buffer_is_empty(input_buffer_st const * const input_buffer)
+{
+    return input_buffer->read_index == input_buffer->write_index;
+}
+
+/* Returns true if there are characters that could be processed 
+ * without first reading any more input. 
+ */
+bool input_buffer_has_unprocessed_input(input_buffer_st const * const input_buffer)
+{
+    return !input_buffer_is_empty(input_buffer) && !input_buffer->needs_more_input;
+}
+
+bool input_buffer_get_char(input_buffer_st * const input_buffer, int * const ch)
+{
+    bool got_char;
+
+    if (input_buffer_is_empty(input_buffer))
+    {
+        got_char = false;
+        goto done;
+    }
+
+    *ch = input_buffer->data[input_buffer->read_index];
+    input_buffer->read_index++;
+    got_char = true;
+
+done:
+    return got_char;
+}
+
+void input_buffer_mark(input_buffer_st * const input_buffer)
+{
+    if (input_buffer_is_empty(input_buffer))
+    {
+        /* Everything has been consumed, so start again from the 
+         * beginning of the buffer. 
+         */
+        input_buffer_init(input_buffer);
+    }
+    input_buffer->mark_index = input_buffer->read_index;
+}
+
+void input_buffer_rewind_to_mark(input_buffer_st * const input_buffer)
+{
+    input_buffer->read_index = input_buffer->mark_index;
+    input_buffer->needs_more_input = true;
+}
+
+/* As input_buffer_rewind_to_mark(), but for a complete key that 
+ * is to be processed later, so no more input is needed. 
+ */
+void input_buffer_put_back_to_mark(input_buffer_st * const input_buffer)
+{
+    input_buffer->read_index = input_buffer->mark_index;
+}
+
+char * input_buffer_get_write_space(input_buffer_st * const input_buffer, size_t * const space_available)
+{
+    /* Move any characters still to be processed (including those 
+     * belonging to a partially decoded key sequence) to the start 
+     * of the buffer to make as much room as possible. 
+     */
+    if (input_buffer->mark_index > 0)
+    {
+        size_t const bytes_to_keep = input_buffer->write_index - input_buffer->mark_index;
+
+        memmove(input_buffer->data, &input_buffer->data[input_buffer->mark_index], bytes_to_keep);
+        input_buffer->read_index -= input_buffer->mark_index;
+        input_buffer->write_index = bytes_to_keep;
+        input_buffer->mark_index = 0;
+    }
+
+    *space_available = sizeof input_buffer->data - input_buffer->write_index;
+
+    return &input_buffer->data[input_buffer->write_index];
+}
+
+void input_buffer_commit_write(input_buffer_st * const input_buffer, size_t const bytes_written)
+{
+    input_buffer->write_index += bytes_written;
+    input_buffer->needs_more_input = false;
+}
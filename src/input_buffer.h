@@ -0,0 +1,41 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#ifndef __INPUT_BUFFER_H__
+#define __INPUT_BUFFER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define INPUT_BUFFER_SIZE 256
+
+typedef struct input_buffer_st input_buffer_st;
+/* Holds characters that have been read from the input but not 
+ * yet processed. When not enough characters are available to 
+ * complete a key sequence, the read position can be wound back 
+ * to the start of the sequence so it can be decoded again once 
+ * the rest of it has arrived. 
+ */
+struct input_buffer_st
+{
+    size_t read_index; /* Index of the next character to hand out. */
+    size_t write_index; /* Index where the next character read from the input is stored. */
+    size_t mark_index; /* Index of the start of the key sequence currently being decoded. */
+    bool needs_more_input; /* The remaining characters are an incomplete key sequence. */
+    char data[INPUT_BUFFER_SIZE];
+};
+
+void input_buffer_init(input_buffer_st * const input_buffer);
+bool input_buffer_is_empty(input_buffer_st const * const input_buffer);
+bool input_buffer_has_unprocessed_input(input_buffer_st const * const input_buffer);
+bool input_buffer_get_char(input_buffer_st * const input_buffer, int * const ch);
+void input_buffer_mark(input_buffer_st * const input_buffer);
+void input_buffer_rewind_to_mark(input_buffer_st * const input_buffer);
+void input_buffer_put_back_to_mark(input_buffer_st * const input_buffer);
+char * input_buffer_get_write_space(input_buffer_st * const input_buffer, size_t * const space_available);
+void input_buffer_commit_write(input_buffer_st * const input_buffer, size_t const bytes_written);
+
+#endif /* __INPUT_BUFFER_H__ */
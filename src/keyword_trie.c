@@ -0,0 +1,462 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include "readline.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define KEYWORD_TRIE_MINIMUM_ARRAY_SIZE 16
+#define KEYWORD_TRIE_MINIMUM_TEXT_SIZE 128
+#define NO_NODE 0 /* The root is never a child, so 0 can mean "none". */
+#define NO_KEYWORD SIZE_MAX
+
+typedef struct keyword_node_st keyword_node_st;
+struct keyword_node_st
+{
+    size_t first_child;
+    size_t next_sibling;
+    size_t num_keywords; /* The number of keywords that start with the characters leading to this node. */
+    size_t keyword_index; /* The keyword that ends at this node, or NO_KEYWORD. */
+    char ch;
+};
+
+typedef struct keyword_st keyword_st;
+struct keyword_st
+{
+    size_t text_offset; /* Where the keyword is in the text block. */
+    int id;
+    keyword_trie_st const * next;
+};
+
+/* There is a node for each distinct prefix of the keywords, with 
+ * the root (node 0) standing for the empty prefix. Each node has 
+ * a list of children, one for each character that can follow the 
+ * prefix, and counts the keywords below it, so whether a word is 
+ * an abbreviation of just one keyword is known as soon as its 
+ * last character has been looked up. 
+ * The nodes, the keywords and their text are each kept in a 
+ * single array that doubles in size when it is full, and refer to 
+ * each other by index so that the arrays can be moved. 
+ */
+struct keyword_trie_st
+{
+    keyword_node_st * nodes;
+    size_t num_nodes;
+    size_t nodes_size;
+
+    keyword_st * keywords;
+    size_t num_keywords;
+    size_t keywords_size;
+
+    char * text;
+    size_t text_length;
+    size_t text_size;
+};
+
+/* Make room in an array for at least 'size_required' elements, 
+ * doubling its size so that adding to it takes constant time on 
+ * average. 
+ */
+static bool ensure_space(void * * const array,
+                         size_t * const array_size,
+                         size_t const size_required,
+                         size_t const element_size,
+                         size_t const minimum_size)
+{
+    bool has_space;
+    size_t new_size;
+    void * new_array;
+
+    if (size_required <= *array_size)
+    {
+        has_space = true;
+        goto done;
+    }
+    new_size = MAX(MAX(*array_size * 2, minimum_size), size_required);
+    new_array = realloc(*array, new_size * element_size);
+    if (new_array == NULL)
+    {
+        has_space = false;
+        goto done;
+    }
+    *array = new_array;
+    *array_size = new_size;
+    has_space = true;
+
+done:
+    return has_space;
+}
+
+static size_t keyword_trie_add_node(keyword_trie_st * const trie, char const ch)
+{
+    size_t node_index;
+    keyword_node_st * node;
+
+    if (!ensure_space((void * *)&trie->nodes,
+                      &trie->nodes_size,
+                      trie->num_nodes + 1,
+                      sizeof *trie->nodes,
+                      KEYWORD_TRIE_MINIMUM_ARRAY_SIZE))
+    {
+        node_index = NO_NODE;
+        goto done;
+    }
+    node_index = trie->num_nodes;
+    node = &trie->nodes[node_index];
+    node->first_child = NO_NODE;
+    node->next_sibling = NO_NODE;
+    node->num_keywords = 0;
+    node->keyword_index = NO_KEYWORD;
+    node->ch = ch;
+    trie->num_nodes++;
+
+done:
+    return node_index;
+}
+
+keyword_trie_st * keyword_trie_create(void)
+{
+    keyword_trie_st * trie;
+
+    trie = calloc(1, sizeof *trie);
+    if (trie == NULL)
+    {
+        goto done;
+    }
+    /* The root. */
+    keyword_trie_add_node(trie, '\0');
+    if (trie->num_nodes == 0)
+    {
+        keyword_trie_destroy(trie);
+        trie = NULL;
+        goto done;
+    }
+
+done:
+    return trie;
+}
+
+void keyword_trie_destroy(keyword_trie_st * const trie)
+{
+    if (trie != NULL)
+    {
+        free(trie->nodes);
+        free(trie->keywords);
+        free(trie->text);
+        free(trie);
+    }
+}
+
+static size_t keyword_trie_find_child(keyword_trie_st const * const trie, size_t const node_index, char const ch)
+{
+    size_t child_index;
+
+    for (child_index = trie->nodes[node_index].first_child;
+         child_index != NO_NODE && trie->nodes[child_index].ch != ch;
+         child_index = trie->nodes[child_index].next_sibling)
+    {
+    }
+
+    return child_index;
+}
+
+/* Finds the node reached by following the characters of 'word' 
+ * from the root. Returns false if no keyword starts with 'word'. 
+ */
+static bool keyword_trie_find_node(keyword_trie_st const * const trie,
+                                   char const * const word,
+                                   size_t const length,
+                                   size_t * const node_index)
+{
+    bool found;
+    size_t index;
+
+    *node_index = 0;
+    for (index = 0; index < length; index++)
+    {
+        *node_index = keyword_trie_find_child(trie, *node_index, word[index]);
+        if (*node_index == NO_NODE)
+        {
+            found = false;
+            goto done;
+        }
+    }
+    found = trie->nodes[*node_index].num_keywords > 0;
+
+done:
+    return found;
+}
+
+static char const * keyword_trie_get_text(keyword_trie_st const * const trie, size_t const keyword_index)
+{
+    return &trie->text[trie->keywords[keyword_index].text_offset];
+}
+
+/* Adds a new keyword, with its text copied into the text block. 
+ * Returns NO_KEYWORD if there wasn't enough memory. 
+ */
+static size_t keyword_trie_add_keyword(keyword_trie_st * const trie, char const * const keyword, size_t const length)
+{
+    size_t keyword_index;
+
+    if (!ensure_space((void * *)&trie->keywords,
+                      &trie->keywords_size,
+                      trie->num_keywords + 1,
+                      sizeof *trie->keywords,
+                      KEYWORD_TRIE_MINIMUM_ARRAY_SIZE)
+        || !ensure_space((void * *)&trie->text,
+                         &trie->text_size,
+                         trie->text_length + length + 1,
+                         sizeof *trie->text,
+                         KEYWORD_TRIE_MINIMUM_TEXT_SIZE))
+    {
+        keyword_index = NO_KEYWORD;
+        goto done;
+    }
+    memcpy(&trie->text[trie->text_length], keyword, length + 1);
+    keyword_index = trie->num_keywords;
+    trie->keywords[keyword_index].text_offset = trie->text_length;
+    trie->text_length += length + 1;
+    trie->num_keywords++;
+
+done:
+    return keyword_index;
+}
+
+bool keyword_trie_add(keyword_trie_st * const trie,
+                      char const * const keyword,
+                      int const id,
+                      keyword_trie_st const * const next)
+{
+    bool added;
+    size_t const length = strlen(keyword);
+    size_t node_index;
+    size_t index;
+    size_t keyword_index;
+
+    if (length == 0)
+    {
+        added = false;
+        goto done;
+    }
+
+    /* Add the nodes first, so that if there isn't enough memory 
+     * the keyword counts are still correct. The nodes added are 
+     * left in place, but with no keywords below them they don't 
+     * match anything. 
+     */
+    node_index = 0;
+    for (index = 0; index < length; index++)
+    {
+        size_t child_index = keyword_trie_find_child(trie, node_index, keyword[index]);
+
+        if (child_index == NO_NODE)
+        {
+            child_index = keyword_trie_add_node(trie, keyword[index]);
+            if (child_index == NO_NODE)
+            {
+                added = false;
+                goto done;
+            }
+            trie->nodes[child_index].next_sibling = trie->nodes[node_index].first_child;
+            trie->nodes[node_index].first_child = child_index;
+        }
+        node_index = child_index;
+    }
+
+    keyword_index = trie->nodes[node_index].keyword_index;
+    if (keyword_index == NO_KEYWORD)
+    {
+        keyword_index = keyword_trie_add_keyword(trie, keyword, length);
+        if (keyword_index == NO_KEYWORD)
+        {
+            added = false;
+            goto done;
+        }
+        trie->nodes[node_index].keyword_index = keyword_index;
+
+        /* Count the keyword in every node on the way to it. */
+        node_index = 0;
+        trie->nodes[node_index].num_keywords++;
+        for (index = 0; index < length; index++)
+        {
+            node_index = keyword_trie_find_child(trie, node_index, keyword[index]);
+            trie->nodes[node_index].num_keywords++;
+        }
+    }
+    /* Adding a keyword again replaces what it leads to. */
+    trie->keywords[keyword_index].id = id;
+    trie->keywords[keyword_index].next = next;
+    added = true;
+
+done:
+    return added;
+}
+
+/* Returns the only keyword below the node. Each node below has 
+ * only one keyword below it too, so this is just a matter of 
+ * following the first child down until reaching the keyword. 
+ */
+static size_t keyword_trie_find_only_keyword(keyword_trie_st const * const trie, size_t node_index)
+{
+    while (trie->nodes[node_index].keyword_index == NO_KEYWORD)
+    {
+        size_t child_index;
+
+        for (child_index = trie->nodes[node_index].first_child;
+             trie->nodes[child_index].num_keywords == 0;
+             child_index = trie->nodes[child_index].next_sibling)
+        {
+        }
+        node_index = child_index;
+    }
+
+    return trie->nodes[node_index].keyword_index;
+}
+
+void keyword_trie_lookup(keyword_trie_st const * const trie,
+                         char const * const word,
+                         size_t const length,
+                         keyword_match_st * const match)
+{
+    size_t node_index;
+    size_t keyword_index;
+
+    match->keyword = NULL;
+    match->id = 0;
+    match->next = NULL;
+    match->num_matches = 0;
+
+    if (length == 0 || !keyword_trie_find_node(trie, word, length, &node_index))
+    {
+        match->result = keyword_match_none;
+        goto done;
+    }
+    match->num_matches = trie->nodes[node_index].num_keywords;
+    /* A keyword typed in full is chosen over the longer keywords 
+     * it is an abbreviation of. 
+     */
+    keyword_index = trie->nodes[node_index].keyword_index;
+    if (keyword_index == NO_KEYWORD)
+    {
+        if (match->num_matches > 1)
+        {
+            match->result = keyword_match_ambiguous;
+            goto done;
+        }
+        keyword_index = keyword_trie_find_only_keyword(trie, node_index);
+    }
+    match->result = keyword_match_unique;
+    match->keyword = keyword_trie_get_text(trie, keyword_index);
+    match->id = trie->keywords[keyword_index].id;
+    match->next = trie->keywords[keyword_index].next;
+
+done:
+    return;
+}
+
+keyword_match_result_t keyword_trie_resolve(keyword_trie_st const * const trie,
+                                            size_t const argc,
+                                            char const * const * const argv,
+                                            keyword_match_st * const matches,
+                                            size_t * const num_resolved)
+{
+    keyword_match_result_t result;
+    keyword_trie_st const * current_trie = trie;
+    size_t index;
+
+    result = keyword_match_unique;
+    for (index = 0; index < argc && current_trie != NULL; index++)
+    {
+        keyword_trie_lookup(current_trie, argv[index], strlen(argv[index]), &matches[index]);
+        if (matches[index].result != keyword_match_unique)
+        {
+            result = matches[index].result;
+            break;
+        }
+        current_trie = matches[index].next;
+    }
+    *num_resolved = index;
+
+    return result;
+}
+
+static void add_possible_words(keyword_trie_st const * const trie,
+                               size_t const node_index,
+                               completion_context_st * const completion_context)
+{
+    size_t child_index;
+
+    if (trie->nodes[node_index].keyword_index != NO_KEYWORD)
+    {
+        completion_context->possible_word_add_fn(completion_context,
+                                                 keyword_trie_get_text(trie, trie->nodes[node_index].keyword_index));
+    }
+    for (child_index = trie->nodes[node_index].first_child;
+         child_index != NO_NODE;
+         child_index = trie->nodes[child_index].next_sibling)
+    {
+        add_possible_words(trie, child_index, completion_context);
+    }
+}
+
+/* The tokens before the current one in the command at the cursor 
+ * are resolved in turn, starting with the trie passed as the 
+ * user context, to find the trie for the current token. 
+ */
+int do_keyword_completion(completion_context_st * const completion_context,
+                          void * const user_context)
+{
+    keyword_trie_st const * trie = user_context;
+    token_segment_st segment;
+    size_t const current_token_index = completion_context->tokens_get_current_token_index_fn(completion_context);
+    char const * const current_token = completion_context->tokens_get_current_token_fn(completion_context);
+    size_t index;
+    size_t node_index;
+
+    if (current_token == NULL)
+    {
+        goto done;
+    }
+    completion_context->tokens_get_current_segment_fn(completion_context, &segment);
+    for (index = segment.first_token_index; index < current_token_index && trie != NULL; index++)
+    {
+        char const * const token = completion_context->tokens_get_token_at_index_fn(completion_context, index);
+        keyword_match_st match;
+
+        keyword_trie_lookup(trie, token, strlen(token), &match);
+        trie = match.next;
+    }
+    if (trie == NULL)
+    {
+        goto done;
+    }
+
+    if (!keyword_trie_find_node(trie, current_token, strlen(current_token), &node_index))
+    {
+        goto done;
+    }
+    if (trie->nodes[node_index].num_keywords == 1)
+    {
+        char * unique_match;
+        char const * const keyword = keyword_trie_get_text(trie, keyword_trie_find_only_keyword(trie, node_index));
+
+        /* Follow the keyword with a space, ready for the next. */
+        if (asprintf(&unique_match, "%s ", keyword) >= 0)
+        {
+            completion_context->unique_match_set_fn(completion_context, unique_match);
+            free(unique_match);
+        }
+    }
+    add_possible_words(trie, node_index, completion_context);
+
+done:
+    return 0;
+}
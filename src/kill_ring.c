@@ -0,0 +1,103 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include "kill_ring.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+void kill_ring_init(kill_ring_st * const kill_ring)
+{
+    kill_ring->write_offset = 0;
+    kill_ring->oldest = 0;
+    kill_ring->num_kills = 0;
+}
+
+static bool kill_ring_overlaps_a_kill(kill_ring_st const * const kill_ring, size_t const offset, size_t const length)
+{
+    bool overlaps = false;
+    size_t index;
+
+    for (index = 0; index < kill_ring->num_kills; index++)
+    {
+        kill_st const * const kill = &kill_ring->kills[(kill_ring->oldest + index) % KILL_RING_MAXIMUM_KILLS];
+
+        if (kill->offset < offset + length && offset < kill->offset + kill->length)
+        {
+            overlaps = true;
+            break;
+        }
+    }
+
+    return overlaps;
+}
+
+static void kill_ring_forget_oldest(kill_ring_st * const kill_ring)
+{
+    kill_ring->oldest = (kill_ring->oldest + 1) % KILL_RING_MAXIMUM_KILLS;
+    kill_ring->num_kills--;
+}
+
+void kill_ring_add(kill_ring_st * const kill_ring, char const * const text, size_t const length)
+{
+    size_t offset;
+    kill_st * kill;
+
+    /* Text too large for the arena can't be kept. */
+    if (length == 0 || length > KILL_RING_SIZE)
+    {
+        goto done;
+    }
+
+    offset = kill_ring->write_offset;
+    if (offset + length > KILL_RING_SIZE)
+    {
+        offset = 0;
+    }
+    while (kill_ring->num_kills > 0 
+           && (kill_ring->num_kills == KILL_RING_MAXIMUM_KILLS || kill_ring_overlaps_a_kill(kill_ring, offset, length)))
+    {
+        kill_ring_forget_oldest(kill_ring);
+    }
+
+    memcpy(&kill_ring->text[offset], text, length);
+    kill = &kill_ring->kills[(kill_ring->oldest + kill_ring->num_kills) % KILL_RING_MAXIMUM_KILLS];
+    kill->offset = offset;
+    kill->length = length;
+    kill_ring->num_kills++;
+    kill_ring->write_offset = offset + length;
+
+done:
+    return;
+}
+
+size_t kill_ring_get_num_kills(kill_ring_st const * const kill_ring)
+{
+    return kill_ring->num_kills;
+}
+
+/* Returns the text of a kill, which isn't NUL terminated, or 
+ * NULL if there are not that many kills. An age of 0 gets the 
+ * most recent kill. 
+ */
+char const * kill_ring_get(kill_ring_st const * const kill_ring, size_t const age, size_t * const length)
+{
+    char const * text;
+    kill_st const * kill;
+
+    if (age >= kill_ring->num_kills)
+    {
+        text = NULL;
+        *length = 0;
+        goto done;
+    }
+    kill = &kill_ring->kills[(kill_ring->oldest + kill_ring->num_kills - 1 - age) % KILL_RING_MAXIMUM_KILLS];
+    text = &kill_ring->text[kill->offset];
+    *length = kill->length;
+
+done:
+    return text;
+}
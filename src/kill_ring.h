@@ -0,0 +1,45 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#ifndef __KILL_RING_H__
+#define __KILL_RING_H__
+
+#include <stddef.h>
+
+#define KILL_RING_SIZE 2048 /* Bytes of killed text that are kept. */
+#define KILL_RING_MAXIMUM_KILLS 16
+
+typedef struct kill_st kill_st;
+struct kill_st
+{
+    size_t offset; /* Where the text is in the kill ring's arena. */
+    size_t length;
+};
+
+typedef struct kill_ring_st kill_ring_st;
+/* The text most recently deleted by the kill commands. The text 
+ * is kept in a fixed size circular arena that is part of the 
+ * structure, so killing and yanking never allocate memory. 
+ * Each kill is kept in one piece, so it can be yanked with a 
+ * single insert. A kill that won't fit before the end of the 
+ * arena starts again at the beginning, and older kills are 
+ * forgotten as new ones overwrite them. 
+ */
+struct kill_ring_st
+{
+    char text[KILL_RING_SIZE];
+    size_t write_offset; /* Where the next kill will be written. */
+    kill_st kills[KILL_RING_MAXIMUM_KILLS]; /* Circular, oldest first. */
+    size_t oldest;
+    size_t num_kills;
+};
+
+void kill_ring_init(kill_ring_st * const kill_ring);
+void kill_ring_add(kill_ring_st * const kill_ring, char const * const text, size_t const length);
+size_t kill_ring_get_num_kills(kill_ring_st const * const kill_ring);
+char const * kill_ring_get(kill_ring_st const * const kill_ring, size_t const age, size_t * const length);
+
+#endif /* __KILL_RING_H__ */
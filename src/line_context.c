@@ -14,120 +14,125 @@
 #include <stdio.h>
 #include <ctype.h>
 
-static void restore_cursor_position(line_context_st * const line_ctx, size_t const original_cursor_position);
-
-/* Write a char at the current cursor position to the 
- * terminal. If inserting the character, write out all 
- * subsequent characters to keep the display up to date. 
+/* Bring the terminal up to date after replacing 
+ * chars_deleted characters at the cursor with the inserted 
+ * characters just before it. Everything after the inserted 
+ * characters is written out in one go, then the cursor is put 
+ * back after the inserted characters. 
  */
-static void terminal_write_char(line_context_st * const line_ctx, int const ch, bool const insert_mode)
+static void terminal_replace_chars(line_context_st * const line_ctx, 
+                                   char const * const inserted, 
+                                   size_t const chars_inserted, 
+                                   size_t const chars_deleted)
 {
-    char const char_to_write = line_ctx->mask_character != '\0' ? line_ctx->mask_character : ch;
     terminal_cursor_st * const terminal_cursor = &line_ctx->terminal_cursor;
+    size_t const trailing_length = line_ctx->line_length - line_ctx->edit_index;
+    size_t chars_to_blank;
+    size_t index;
 
-    terminal_put(terminal_cursor, 
-                 char_to_write, 
-                 line_ctx->terminal_fd, 
-                 line_ctx->terminal_width);
-    /* if in insert mode, any chars after the one just written
-     * will need to be written out.
-     */
-    if (insert_mode)
-    {
-        size_t const trailing_length = line_ctx->line_length - line_ctx->edit_index;
-
-        if (trailing_length > 0)
-        {
-            size_t const original_cursor_index = line_ctx->edit_index;
-
-            terminal_puts(terminal_cursor, 
-                          &line_ctx->edit_buffer[line_ctx->edit_index], 
-                          line_ctx->mask_character,
-                          line_ctx->terminal_fd,
-                          line_ctx->terminal_width);
-            /* Update the current edit position to match the physical 
-             * cursor position. 
-             */
-            line_ctx->edit_index = strlen(line_ctx->edit_buffer); 
-            /* And now restore edit position and cursor back to the original
-             * editing location. 
-             */
-            restore_cursor_position(line_ctx, original_cursor_index);
-        }
-    }
-}
-
-static bool check_line_buffer_size(line_context_st * const line_ctx, size_t const space_required)
-{
-    bool buffer_size_ok;
-    size_t new_buffer_size;
-
-    /* Check that there is room for 'characters_to_add' 
-     * characters. 
-     */
-    if (line_ctx->maximum_line_length > 0 && line_ctx->line_length == line_ctx->maximum_line_length)
+    terminal_write(terminal_cursor, 
+                   inserted, 
+                   chars_inserted, 
+                   line_ctx->mask_character, 
+                   line_ctx->output, 
+                   line_ctx->terminal_width);
+    if (chars_deleted == chars_inserted)
     {
-        buffer_size_ok = false;
+        /* Overwritten in place, so the rest of the line hasn't 
+         * moved. 
+         */
         goto done;
     }
-    if (line_ctx->line_length + 1 + space_required <= line_ctx->buffer_size)
+    if (trailing_length == 0 && chars_deleted > chars_inserted)
     {
-        buffer_size_ok = true;
+        terminal_delete_line_from_cursor_to_end(terminal_cursor, line_ctx->output);
         goto done;
     }
 
-    new_buffer_size = line_ctx->line_length + 1 + space_required + line_ctx->size_increment;
-
-    line_ctx->edit_buffer = realloc(line_ctx->edit_buffer, new_buffer_size);
-    if (line_ctx->edit_buffer == NULL)
+    terminal_puts(terminal_cursor, 
+                  gap_buffer_get_string_from(&line_ctx->edit_buffer, line_ctx->edit_index), 
+                  line_ctx->mask_character,
+                  line_ctx->output,
+                  line_ctx->terminal_width);
+    /* Remove what is left of the old line from the end by 
+     * replacing it with spaces. 
+     */
+    chars_to_blank = chars_deleted > chars_inserted ? chars_deleted - chars_inserted : 0;
+    for (index = 0; index < chars_to_blank; index++)
     {
-        line_ctx->buffer_size = 0;
-        buffer_size_ok = false;
-        goto done; 
+        terminal_put(terminal_cursor, ' ', line_ctx->output, line_ctx->terminal_width);
     }
-    line_ctx->buffer_size = new_buffer_size;
-    buffer_size_ok = true; 
+    /* Move the terminal cursor back to match the editing 
+     * position. 
+     */
+    terminal_move_cursor_left_n_columns(terminal_cursor, 
+                                        trailing_length + chars_to_blank,
+                                        line_ctx->output,
+                                        line_ctx->terminal_width);
 
 done:
-    return buffer_size_ok;
+    return;
 }
 
-static bool line_ctx_write_char(line_context_st * const line_ctx, int const ch, bool const insert_mode)
+/* Replace up to chars_to_delete characters at the cursor with 
+ * the first 'length' characters of 'data', leaving the cursor 
+ * after the inserted characters. Deleting or inserting any 
+ * number of characters takes a single change to the edit 
+ * buffer, and a single update of the terminal. 
+ */
+static void replace_chars_at_cursor(line_context_st * const line_ctx, 
+                                    size_t chars_to_delete, 
+                                    char const * const data, 
+                                    size_t length, 
+                                    bool const update_terminal)
 {
-    bool char_was_written;
-    size_t const trailing_length = line_ctx->line_length - line_ctx->edit_index;
-    bool const line_length_will_increase = insert_mode || (line_ctx->edit_index >= line_ctx->line_length);
+    size_t length_after_delete;
 
-    if (line_length_will_increase)
+    chars_to_delete = MIN(chars_to_delete, line_ctx->line_length - line_ctx->edit_index);
+    length_after_delete = line_ctx->line_length - chars_to_delete;
+    if (line_ctx->maximum_line_length > 0)
     {
-        if (!check_line_buffer_size(line_ctx, 1))
-        {
-            char_was_written = false;
-            goto done;
-        }
-    }
+        size_t const space_available = line_ctx->maximum_line_length > length_after_delete 
+            ? line_ctx->maximum_line_length - length_after_delete 
+            : 0;
 
-    if (insert_mode)
+        length = MIN(length, space_available);
+    }
+    if (chars_to_delete == 0 && length == 0)
     {
-        if (trailing_length > 0)
-        {
-            memmove(&line_ctx->edit_buffer[line_ctx->edit_index + 1], &line_ctx->edit_buffer[line_ctx->edit_index], trailing_length);
-        }
+        goto done;
     }
 
-    line_ctx->edit_buffer[line_ctx->edit_index] = ch;
-    line_ctx->edit_index++;
+    tokens_line_changed(&line_ctx->tokens, line_ctx->edit_index);
+    undo_log_begin_group(&line_ctx->undo_log);
+    if (chars_to_delete > 0)
+    {
+        /* The gap is about to be moved here anyway, so this costs 
+         * nothing extra. 
+         */
+        undo_log_record(&line_ctx->undo_log, 
+                        undo_operation_delete, 
+                        line_ctx->edit_index, 
+                        gap_buffer_get_string_from(&line_ctx->edit_buffer, line_ctx->edit_index), 
+                        chars_to_delete);
+    }
+    gap_buffer_delete(&line_ctx->edit_buffer, line_ctx->edit_index, chars_to_delete);
+    if (length > 0 && !gap_buffer_insert(&line_ctx->edit_buffer, line_ctx->edit_index, data, length))
+    {
+        length = 0;
+    }
+    undo_log_record(&line_ctx->undo_log, undo_operation_insert, line_ctx->edit_index, data, length);
+    undo_log_end_group(&line_ctx->undo_log);
+    line_ctx->line_length = length_after_delete + length;
+    line_ctx->edit_index += length;
 
-    if (line_length_will_increase)
+    if (update_terminal)
     {
-        line_ctx->line_length++;
-        /* keep the line NUL terminated */
-        line_ctx->edit_buffer[line_ctx->line_length] = '\0';
+        terminal_replace_chars(line_ctx, data, length, chars_to_delete);
     }
-    char_was_written = true;
 
 done:
-    return char_was_written;
+    return;
 }
 
 void delete_from_start_to_cursor(line_context_st * const line_ctx)
@@ -137,10 +142,7 @@ void delete_from_start_to_cursor(line_context_st * const line_ctx)
 
 void delete_from_cursor_to_end(line_context_st * const line_ctx)
 {
-    line_ctx->line_length = line_ctx->edit_index;
-    line_ctx->edit_buffer[line_ctx->line_length] = '\0'; 
-
-    terminal_delete_line_from_cursor_to_end(&line_ctx->terminal_cursor, line_ctx->terminal_fd);
+    delete_chars_to_the_right(line_ctx, line_ctx->line_length - line_ctx->edit_index);
 }
 
 static void restore_cursor_position(line_context_st * const line_ctx, size_t const original_cursor_position)
@@ -156,58 +158,57 @@ void redisplay_line(line_context_st * const line_ctx)
     size_t const original_cursor_index = line_ctx->edit_index;
     terminal_cursor_st * const terminal_cursor = &line_ctx->terminal_cursor; 
 
-    tty_put(line_ctx->terminal_fd, '\n');
+    tty_put(line_ctx->output, '\n');
 
     terminal_cursor_reset(terminal_cursor);
 
     terminal_puts(terminal_cursor, 
                   line_ctx->prompt, 
                   '\0', 
-                  line_ctx->terminal_fd,
+                  line_ctx->output,
                   line_ctx->terminal_width);
 
     terminal_puts(terminal_cursor, 
-                  line_ctx->edit_buffer, 
+                  line_context_get_line(line_ctx), 
                   line_ctx->mask_character, 
-                  line_ctx->terminal_fd,
+                  line_ctx->output,
                   line_ctx->terminal_width);
     /* The terminal cursor will now be at the end of the line, so 
      * update the editing position to match. 
      */
-    line_ctx->edit_index = strlen(line_ctx->edit_buffer);
+    line_ctx->edit_index = line_ctx->line_length;
 
     restore_cursor_position(line_ctx, original_cursor_index);
 }
 
 bool line_context_init(line_context_st * const line_context,
                        size_t const initial_size, 
-                       size_t const size_increment,
                        size_t const maximum_line_length,
-                       int const terminal_fd,
+                       output_queue_st * const output,
                        size_t const terminal_width,
                        int const mask_character,
                        char const * const prompt)
 {
     bool init_ok;
 
-    /* don't allow a zero increment. Default to 1 if specified. */
-    line_context->size_increment = size_increment == 0 ? 1 : size_increment;
-    line_context->buffer_size = initial_size;
-    /* free any old line_buffer */
-    free(line_context->edit_buffer);
-    line_context->edit_buffer = (char *)malloc(line_context->buffer_size);
-    if (line_context->edit_buffer == NULL)
+    /* Reuse the buffer from the previous line if there is one. */
+    if (line_context->edit_buffer.buffer != NULL)
+    {
+        gap_buffer_clear(&line_context->edit_buffer);
+        undo_log_clear(&line_context->undo_log);
+    }
+    else if (!gap_buffer_init(&line_context->edit_buffer, initial_size))
     {
         init_ok = false;
         goto done;
     }
+    tokens_line_changed(&line_context->tokens, 0);
     line_context->any_chars_read = false;
     line_context->line_length = 0;
-    line_context->edit_buffer[line_context->line_length] = '\0';
     line_context->maximum_line_length = maximum_line_length;
     line_context->edit_index = 0; 
 
-    line_context->terminal_fd = terminal_fd;
+    line_context->output = output;
     line_context->terminal_width = terminal_width;
 
     line_context->mask_character = mask_character;
@@ -223,9 +224,111 @@ done:
 
 void line_context_teardown(line_context_st * const line_context)
 {
-    /* free any old line_buffer */
-    free(line_context->edit_buffer);
-    line_context->edit_buffer = NULL;
+    gap_buffer_teardown(&line_context->edit_buffer);
+    undo_log_teardown(&line_context->undo_log);
+    tokens_teardown(&line_context->tokens);
+}
+
+/* Called once a line is finished with. */
+void line_context_trim(line_context_st * const line_context, size_t const maximum_idle_size)
+{
+    gap_buffer_trim(&line_context->edit_buffer, maximum_idle_size);
+    undo_log_trim(&line_context->undo_log, maximum_idle_size);
+    tokens_trim(&line_context->tokens, maximum_idle_size);
+}
+
+static void line_context_set_text(line_context_st * const line_ctx, char const * const text, size_t const length)
+{
+    gap_buffer_clear(&line_ctx->edit_buffer);
+    undo_log_clear(&line_ctx->undo_log);
+    tokens_line_changed(&line_ctx->tokens, 0);
+    line_ctx->line_length = gap_buffer_insert(&line_ctx->edit_buffer, 0, text, length) ? length : 0;
+}
+
+/* Start editing a different line, such as another row of a 
+ * multi-line block. If 'draw' is set the prompt and text are 
+ * written out, otherwise the line must already be displayed. 
+ * Either way the terminal cursor must be at the start of the 
+ * prompt. The cursor is left at edit_index. 
+ */
+void line_context_load(line_context_st * const line_ctx, 
+                       char const * const prompt, 
+                       char const * const text, 
+                       size_t const length, 
+                       size_t const screen_lines, 
+                       size_t const edit_index, 
+                       bool const draw)
+{
+    terminal_cursor_st * const terminal_cursor = &line_ctx->terminal_cursor;
+
+    line_context_set_text(line_ctx, text, length);
+    line_ctx->prompt = prompt;
+    line_ctx->edit_index = 0;
+    terminal_cursor_init(terminal_cursor);
+    terminal_cursor->num_rows = MAX(screen_lines, 1);
+
+    if (draw)
+    {
+        terminal_puts(terminal_cursor, prompt, '\0', line_ctx->output, line_ctx->terminal_width);
+        terminal_write(terminal_cursor, 
+                       text, 
+                       line_ctx->line_length, 
+                       line_ctx->mask_character, 
+                       line_ctx->output, 
+                       line_ctx->terminal_width);
+        line_ctx->edit_index = line_ctx->line_length;
+        move_cursor_left_n_columns(line_ctx, line_ctx->line_length - MIN(edit_index, line_ctx->line_length));
+    }
+    else
+    {
+        terminal_move_cursor_right_n_columns(terminal_cursor, strlen(prompt), line_ctx->output, line_ctx->terminal_width);
+        move_cursor_right_n_columns(line_ctx, edit_index);
+    }
+}
+
+/* Replace the line without updating the terminal. */
+void line_context_set_line(line_context_st * const line_ctx, char const * const text)
+{
+    line_context_set_text(line_ctx, text, strlen(text));
+    line_ctx->edit_index = line_ctx->line_length;
+}
+
+/* Returns the line as a NUL terminated string. The string is 
+ * only valid until the line is next modified. 
+ */
+char const * line_context_get_line(line_context_st * const line_ctx)
+{
+    return gap_buffer_get_string(&line_ctx->edit_buffer);
+}
+
+/* Returns the line from index to the end as a NUL terminated 
+ * string. Like line_context_get_line(), the string is only 
+ * valid until the line is next modified. 
+ */
+char const * line_context_get_line_from(line_context_st * const line_ctx, size_t const index)
+{
+    return gap_buffer_get_string_from(&line_ctx->edit_buffer, index);
+}
+
+/* Returns the tokens in the line, with the token at the cursor 
+ * as the current token. Only the part of the line that has been 
+ * edited since the last call is tokenised again, so asking for 
+ * the tokens again while the line is unchanged costs next to 
+ * nothing. The tokens after the current token are only found if 
+ * they are asked for. Returns NULL if there wasn't enough memory. 
+ */
+tokens_st * line_context_get_tokens(line_context_st * const line_ctx)
+{
+    tokens_st * tokens = &line_ctx->tokens;
+    char const * const line = line_context_get_line(line_ctx);
+
+    if (!tokens_update(tokens, line, line_ctx->line_length, &line_ctx->token_class, line_ctx->edit_index)
+        || !tokens_set_cursor(tokens, line, line_ctx->edit_index))
+    {
+        tokens = NULL;
+    }
+
+    return tokens;
 }
 
 void move_cursor_right_n_columns(line_context_st * const line_ctx, size_t columns)
@@ -238,7 +341,7 @@ void move_cursor_right_n_columns(line_context_st * const line_ctx, size_t column
 
         terminal_move_cursor_right_n_columns(&line_ctx->terminal_cursor, 
                                              columns_to_move, 
-                                             line_ctx->terminal_fd,
+                                             line_ctx->output,
                                              line_ctx->terminal_width);
 
     }
@@ -254,17 +357,11 @@ void move_cursor_left_n_columns(line_context_st * const line_ctx, size_t const c
 
         terminal_move_cursor_left_n_columns(&line_ctx->terminal_cursor, 
                                             columns_to_move, 
-                                            line_ctx->terminal_fd,
+                                            line_ctx->output,
                                             line_ctx->terminal_width);
     }
 }
 
-static void delete_edit_line(line_context_st * const line_ctx)
-{
-    move_cursor_left_n_columns(line_ctx, line_ctx->edit_index);
-    delete_from_cursor_to_end(line_ctx);
-}
-
 /*
  * replace_edit_line: 
  * Replace the whole line except for the leading prompt with the
@@ -272,45 +369,13 @@ static void delete_edit_line(line_context_st * const line_ctx)
 */
 void replace_edit_line(line_context_st * const line_ctx, char const * const replacement)
 {
-    delete_edit_line(line_ctx);
-    write_string(line_ctx, replacement, true, true);
+    move_cursor_left_n_columns(line_ctx, line_ctx->edit_index);
+    replace_chars_at_cursor(line_ctx, line_ctx->line_length, replacement, strlen(replacement), true);
 }
 
 void delete_char_to_the_right(line_context_st * const line_ctx, bool const update_display)
 {
-    if (line_ctx->edit_index < line_ctx->line_length)
-    {
-        size_t const trailing_chars = line_ctx->line_length - line_ctx->edit_index;
-
-        line_ctx->line_length--;
-        memmove(&line_ctx->edit_buffer[line_ctx->edit_index], &line_ctx->edit_buffer[line_ctx->edit_index + 1], trailing_chars);
-        line_ctx->edit_buffer[line_ctx->line_length] = '\0';
-
-        if (update_display)
-        {
-            terminal_cursor_st * const terminal_cursor = &line_ctx->terminal_cursor;
-
-            terminal_puts(terminal_cursor, 
-                          &line_ctx->edit_buffer[line_ctx->edit_index], 
-                          line_ctx->mask_character,
-                          line_ctx->terminal_fd,
-                          line_ctx->terminal_width);
-            /* Remove the remaining char from the end of the line by 
-             * replacing it with a space. 
-             */
-            terminal_put(terminal_cursor, 
-                         ' ', 
-                         line_ctx->terminal_fd,
-                         line_ctx->terminal_width);
-            /* Move the terminal cursor back to match the editing 
-             * position. 
-             */
-            terminal_move_cursor_left_n_columns(terminal_cursor, 
-                                                trailing_chars,
-                                                line_ctx->terminal_fd,
-                                                line_ctx->terminal_width);
-        }
-    }
+    replace_chars_at_cursor(line_ctx, 1, NULL, 0, update_display);
 }
 
 void delete_char_to_the_left(line_context_st * const line_ctx)
@@ -328,12 +393,7 @@ void delete_char_to_the_left(line_context_st * const line_ctx)
 
 void delete_chars_to_the_right(line_context_st * const line_ctx, size_t const chars_to_delete)
 {
-    size_t count;
-
-    for (count = 0; count < chars_to_delete; count++)
-    {
-        delete_char_to_the_right(line_ctx, true);
-    }
+    replace_chars_at_cursor(line_ctx, chars_to_delete, NULL, 0, true);
 }
 
 void delete_chars_to_the_left(line_context_st * const line_ctx, size_t const chars_to_delete)
@@ -345,58 +405,98 @@ void delete_chars_to_the_left(line_context_st * const line_ctx, size_t const cha
 /* Write a char at the current cursor position. */
 void write_char(line_context_st * const line_ctx, int const ch, bool const insert_mode, bool const update_terminal)
 {
-    if (line_ctx_write_char(line_ctx, ch, insert_mode))
-    {
-        if (update_terminal)
-        {
-            terminal_write_char(line_ctx, ch, insert_mode);
-        }
-    }
+    char const char_to_write = ch;
+
+    replace_chars_at_cursor(line_ctx, insert_mode ? 0 : 1, &char_to_write, 1, update_terminal);
 }
 
 /* Write a string at the current cursor position. */
 void write_string(line_context_st * const line_ctx, char const * const string, bool insert_mode, bool const update_terminal)
 {
-    char const * pch = string;
+    size_t const length = strlen(string);
 
-    while (*pch)
-    {
-        write_char(line_ctx, *pch, insert_mode, update_terminal);
-        pch++;
-    }
+    replace_chars_at_cursor(line_ctx, insert_mode ? 0 : length, string, length, update_terminal);
+}
+
+/* Replace characters at the cursor with 'length' characters 
+ * from 'data', which needn't be NUL terminated. 
+ */
+void replace_chars(line_context_st * const line_ctx, size_t const chars_to_delete, char const * const data, size_t const length)
+{
+    replace_chars_at_cursor(line_ctx, chars_to_delete, data, length, true);
 }
 
-static void delete_to_end_of_word(line_context_st * const line_ctx, bool const update_terminal)
+static size_t get_index_of_end_of_word(line_context_st * const line_ctx)
 {
+    size_t index;
+
     /* TODO - Use field separators rather than isspace? Use 
      * isalnum() instead of !isspace()? 
      */
-    while (line_ctx->edit_buffer[line_ctx->edit_index] != '\0' && !isspace(line_ctx->edit_buffer[line_ctx->edit_index]))
+    for (index = line_ctx->edit_index; index < line_ctx->line_length; index++)
     {
-        delete_char_to_the_right(line_ctx, update_terminal);
+        if (isspace((int)gap_buffer_get_char(&line_ctx->edit_buffer, index)))
+        {
+            break;
+        }
     }
+
+    return index;
 }
 
 void complete_word(line_context_st * const line_ctx, char const * const completion, bool const update_terminal)
 {
-    /* Remove any chars at the end of the word, then write the 
-     * supplied completion suffix at the current cursor position 
+    /* Replace any chars at the end of the word with the supplied 
+     * completion suffix. 
      */
-    delete_to_end_of_word(line_ctx, update_terminal);
-    write_string(line_ctx, completion, true, update_terminal);
+    replace_chars_at_cursor(line_ctx, 
+                            get_index_of_end_of_word(line_ctx) - line_ctx->edit_index, 
+                            completion, 
+                            strlen(completion), 
+                            update_terminal);
 }
 
-void free_saved_string(char const * * const saved_line)
+void saved_line_save(saved_line_st * const saved_line, line_context_st * const line_ctx)
 {
-    FREE_CONST(*saved_line);
-    *saved_line = NULL;
+    size_t const size_required = line_ctx->line_length + 1;
+
+    if (size_required > saved_line->buffer_size)
+    {
+        size_t const new_buffer_size = MAX(size_required, saved_line->buffer_size * 2);
+        char * const new_buffer = realloc(saved_line->buffer, new_buffer_size);
+
+        if (new_buffer == NULL)
+        {
+            saved_line->is_valid = false;
+            goto done;
+        }
+        saved_line->buffer = new_buffer;
+        saved_line->buffer_size = new_buffer_size;
+    }
+    memcpy(saved_line->buffer, line_context_get_line(line_ctx), size_required);
+    saved_line->is_valid = true;
+
+done:
+    return;
+}
+
+/* Returns NULL if there is no saved line. */
+char const * saved_line_get(saved_line_st const * const saved_line)
+{
+    return saved_line->is_valid ? saved_line->buffer : NULL;
+}
+
+void saved_line_clear(saved_line_st * const saved_line)
+{
+    saved_line->is_valid = false;
 }
 
-void save_string(line_context_st * const line_ctx, char const * * const destination)
+void saved_line_free(saved_line_st * const saved_line)
 {
-    /* Free any old string at the destination. */
-    free_saved_string(destination);
-    *destination = strdup(line_ctx->edit_buffer);
+    free(saved_line->buffer);
+    saved_line->buffer = NULL;
+    saved_line->buffer_size = 0;
+    saved_line->is_valid = false;
 }
 
 /* Transpose two characters at the cursor position. */
@@ -416,94 +516,62 @@ void transpose_characters(line_context_st * const line_ctx)
     }
     if (line_ctx->edit_index == line_ctx->line_length)
     {
-        first_char = line_ctx->edit_buffer[line_ctx->edit_index - 2];
-        second_char = line_ctx->edit_buffer[line_ctx->edit_index - 1];
+        first_char = gap_buffer_get_char(&line_ctx->edit_buffer, line_ctx->edit_index - 2);
+        second_char = gap_buffer_get_char(&line_ctx->edit_buffer, line_ctx->edit_index - 1);
         columns_to_move_left = 2;
     }
     else
     {
-        first_char = line_ctx->edit_buffer[line_ctx->edit_index - 1];
-        second_char = line_ctx->edit_buffer[line_ctx->edit_index];
+        first_char = gap_buffer_get_char(&line_ctx->edit_buffer, line_ctx->edit_index - 1);
+        second_char = gap_buffer_get_char(&line_ctx->edit_buffer, line_ctx->edit_index);
         columns_to_move_left = 1;
     }
 
     move_cursor_left_n_columns(line_ctx, columns_to_move_left);
+    undo_log_begin_group(&line_ctx->undo_log);
     write_char(line_ctx, second_char, false, true);
     write_char(line_ctx, first_char, false, true);
+    undo_log_end_group(&line_ctx->undo_log);
 
 done:
     return;
 }
 
-static bool is_word_separator(char const ch)
-{
-    /* XXX - Also check user supplied field separators? */
-    return isalnum((int)ch) == 0;
-}
-
+/* Moves back over any word separators, then to the start of the 
+ * word before them. 
+ */
 size_t get_index_of_start_of_previous_word(line_context_st * const line_ctx)
 {
+    char const * const text = gap_buffer_get_text_before(&line_ctx->edit_buffer, line_ctx->edit_index);
     size_t index;
 
-    if (line_ctx->edit_index > 0)
-    {
-        /* Move left passed word separators. */
-        for (index = line_ctx->edit_index - 1; index != 0; index--)
-        {
-            if (!is_word_separator(line_ctx->edit_buffer[index]))
-            {
-                break;
-            }
-        }
-        /* Skip left until the next character to the left is a word 
-         * separator. 
-         */
-        for (; index > 0; index--)
-        {
-            if (is_word_separator(line_ctx->edit_buffer[index - 1]))
-            {
-                break;
-            }
-        }
-    }
-    else
-    {
-        index = 0;
-    }
+    index = word_class_skip_backward(&line_ctx->word_class, text, line_ctx->edit_index, false);
+    index = word_class_skip_backward(&line_ctx->word_class, text, index, true);
 
     return index;
 }
 
+/* Moves past the character under the cursor and any word 
+ * separators after it, then to the end of the word after them. 
+ */
 size_t get_index_of_end_of_next_word(line_context_st * const line_ctx)
 {
-    size_t index;
+    size_t const length = line_ctx->line_length - line_ctx->edit_index;
+    char const * text;
+    size_t offset;
 
-    if (line_ctx->edit_index < line_ctx->line_length)
-    {
-        /* Move right passed word separators. */
-        for (index = line_ctx->edit_index + 1; index < line_ctx->line_length; index++)
-        {
-            if (!is_word_separator(line_ctx->edit_buffer[index]))
-            {
-                break;
-            }
-        }
-        /* Move right until we hit a word separator. 
-         */
-        for (; index < line_ctx->line_length; index++)
-        {
-            if (is_word_separator(line_ctx->edit_buffer[index]))
-            {
-                break;
-            }
-        }
-    }
-    else
+    if (length == 0)
     {
-        index = line_ctx->line_length;
+        offset = 0;
+        goto done;
     }
+    text = gap_buffer_get_string_from(&line_ctx->edit_buffer, line_ctx->edit_index);
+    offset = 1;
+    offset += word_class_skip_forward(&line_ctx->word_class, &text[offset], length - offset, false);
+    offset += word_class_skip_forward(&line_ctx->word_class, &text[offset], length - offset, true);
 
-    return index;
+done:
+    return line_ctx->edit_index + offset;
 }
 
 void move_left_to_beginning_of_word(line_context_st * const line_ctx)
@@ -546,4 +614,68 @@ void delete_to_next_word(line_context_st * const line_ctx)
     }
 }
 
+static void move_cursor_to_index(line_context_st * const line_ctx, size_t const index)
+{
+    if (index < line_ctx->edit_index)
+    {
+        move_cursor_left_n_columns(line_ctx, line_ctx->edit_index - index);
+    }
+    else
+    {
+        move_cursor_right_n_columns(line_ctx, index - line_ctx->edit_index);
+    }
+}
 
+/* Make the edit described by the record, or reverse it if 
+ * 'reverse' is true. 
+ */
+static void apply_undo_record(line_context_st * const line_ctx, undo_record_st const * const record, bool const reverse)
+{
+    bool const insert = (record->operation == undo_operation_insert) != reverse;
+
+    move_cursor_to_index(line_ctx, record->index);
+    if (insert)
+    {
+        replace_chars_at_cursor(line_ctx, 0, undo_log_get_text(&line_ctx->undo_log, record), record->length, true);
+    }
+    else
+    {
+        replace_chars_at_cursor(line_ctx, record->length, NULL, 0, true);
+    }
+}
+
+void undo_edit(line_context_st * const line_ctx)
+{
+    undo_record_st const * record;
+
+    line_ctx->undo_log.suspended = true;
+    do
+    {
+        record = undo_log_undo(&line_ctx->undo_log);
+        if (record == NULL)
+        {
+            break;
+        }
+        apply_undo_record(line_ctx, record, true);
+    }
+    while (record->joined_to_previous);
+    line_ctx->undo_log.suspended = false;
+}
+
+void redo_edit(line_context_st * const line_ctx)
+{
+    undo_record_st const * record;
+
+    line_ctx->undo_log.suspended = true;
+    do
+    {
+        record = undo_log_redo(&line_ctx->undo_log);
+        if (record == NULL)
+        {
+            break;
+        }
+        apply_undo_record(line_ctx, record, false);
+    }
+    while (undo_log_redo_is_joined(&line_ctx->undo_log));
+    line_ctx->undo_log.suspended = false;
+}
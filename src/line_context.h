@@ -10,6 +10,12 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "output_queue.h"
+#include "gap_buffer.h"
+#include "undo_log.h"
+#include "word_class.h"
+#include "tokenise.h"
+
 typedef struct terminal_cursor_st terminal_cursor_st;
 struct terminal_cursor_st
 {
@@ -18,19 +24,34 @@ struct terminal_cursor_st
     size_t num_rows; /* The number of rows on the terminal the line occupies. */
 }; 
 
+typedef struct saved_line_st saved_line_st;
+/* A copy of a line. The memory is kept for reuse once the copy 
+ * is no longer needed. 
+ */
+struct saved_line_st
+{
+    char * buffer;
+    size_t buffer_size;
+    bool is_valid; /* false if there is currently no saved line. */
+};
+
 typedef struct line_context_st line_context_st;
 /* This structure mostly contains variables that are only 
- * needed during a single call to readline(). 
+ * needed during a single call to readline(). The edit buffer is 
+ * kept between calls though, so that a line can be edited 
+ * without any memory being allocated. 
  */
 struct line_context_st
 {
-    size_t size_increment;
-    char * edit_buffer; /* Storage for the line being edited. */
-    size_t buffer_size; /* Amount of memory alloced for the line. */
+    gap_buffer_st edit_buffer; /* Storage for the line being edited. */
+    undo_log_st undo_log; /* The edits made to the line, so they can be undone. */
+    word_class_st word_class; /* The characters that make up words. */
+    token_class_st token_class; /* How each character is treated when tokenising the line. */
+    tokens_st tokens; /* The tokens in the line, kept up to date as the line is edited. */
     size_t line_length; /* Current length of the line. */
     size_t maximum_line_length;
     size_t edit_index; /* Location of the cursor in the line. */
-    int terminal_fd; /* The file descriptor to write to when updating the terminal. */
+    output_queue_st * output; /* Where to write to when updating the terminal. */
     size_t terminal_width;
     int mask_character; /* if non-zero, the character to write to the terminal instead of the actual character entered. */
     char const * prompt;
@@ -41,13 +62,24 @@ struct line_context_st
 
 bool line_context_init(line_context_st * const line_context,
                        size_t const initial_size, 
-                       size_t const size_increment,
                        size_t const maximum_line_length,
-                       int const terminal_fd,
+                       output_queue_st * const output,
                        size_t const terminal_width,
                        int const mask_character,
                        char const * const prompt);
 void line_context_teardown(line_context_st * const line_context);
+void line_context_trim(line_context_st * const line_context, size_t const maximum_idle_size);
+void line_context_load(line_context_st * const line_ctx, 
+                       char const * const prompt, 
+                       char const * const text, 
+                       size_t const length, 
+                       size_t const screen_lines, 
+                       size_t const edit_index, 
+                       bool const draw);
+void line_context_set_line(line_context_st * const line_ctx, char const * const text);
+char const * line_context_get_line(line_context_st * const line_ctx);
+char const * line_context_get_line_from(line_context_st * const line_ctx, size_t const index);
+tokens_st * line_context_get_tokens(line_context_st * const line_ctx);
 
 void move_cursor_right_n_columns(line_context_st * const line_ctx, size_t columns);
 void move_cursor_left_n_columns(line_context_st * const line_ctx, size_t const columns);
@@ -59,15 +91,20 @@ void delete_chars_to_the_left(line_context_st * const line_ctx, size_t const cha
 
 void write_char(line_context_st * const line_ctx, int const ch, bool const insert_mode, bool const update_terminal);
 void write_string(line_context_st * const line_ctx, char const * const string, bool insert_mode, bool const update_terminal);
+void replace_chars(line_context_st * const line_ctx, size_t const chars_to_delete, char const * const data, size_t const length);
 
 void complete_word(line_context_st * const line_ctx, char const * const completion, bool const update_terminal);
 void replace_edit_line(line_context_st * const line_ctx, char const * const replacement);
 void redisplay_line(line_context_st * const line_ctx);
-void free_saved_string(char const * * const saved_line);
-void save_string(line_context_st * const line_ctx, char const * * const destination); 
+void saved_line_save(saved_line_st * const saved_line, line_context_st * const line_ctx);
+char const * saved_line_get(saved_line_st const * const saved_line);
+void saved_line_clear(saved_line_st * const saved_line);
+void saved_line_free(saved_line_st * const saved_line);
 void delete_from_cursor_to_end(line_context_st * const line_ctx);
 void delete_from_start_to_cursor(line_context_st * const line_ctx);
 void transpose_characters(line_context_st * const line_ctx);
+void undo_edit(line_context_st * const line_ctx);
+void redo_edit(line_context_st * const line_ctx);
 
 size_t get_index_of_start_of_previous_word(line_context_st * const line_ctx);
 size_t get_index_of_end_of_next_word(line_context_st * const line_ctx);
@@ -0,0 +1,363 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include "multi_line.h"
+#include "terminal.h"
+#include "terminal_cursor.h"
+#include "utils.h"
+
+#include <string.h>
+
+#define DEFAULT_CONTINUATION_PROMPT "> "
+
+/* 
+ * A block of input that needs more than one line is kept as 
+ * rows. Only the row containing the cursor is edited in the line 
+ * context. The other rows stay on the terminal as they were 
+ * drawn, so moving between rows only moves the cursor, and a 
+ * row is only redrawn when the row above it grows onto more 
+ * terminal lines. 
+ */
+
+bool multi_line_in_use(readline_st const * const readline_ctx)
+{
+    return rows_get_num_rows(&readline_ctx->rows) > 1;
+}
+
+static char const * get_row_prompt(readline_st const * const readline_ctx, size_t const row_index)
+{
+    char const * prompt;
+
+    if (row_index == 0)
+    {
+        prompt = readline_ctx->first_row_prompt;
+    }
+    else if (readline_ctx->continuation_prompt != NULL)
+    {
+        prompt = readline_ctx->continuation_prompt;
+    }
+    else
+    {
+        prompt = DEFAULT_CONTINUATION_PROMPT;
+    }
+
+    return prompt;
+}
+
+/* Copy the row being edited back into the rows. */
+static void save_current_row(readline_st * const readline_ctx)
+{
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+    row_st * const row = rows_get_row(&readline_ctx->rows, readline_ctx->current_row);
+
+    rows_set_text(&readline_ctx->rows, 
+                  readline_ctx->current_row, 
+                  line_context_get_line(line_ctx), 
+                  line_ctx->line_length);
+    row->screen_lines = MAX(row->screen_lines, line_ctx->terminal_cursor.num_rows);
+}
+
+/* Returns true if the user callback says the input entered so 
+ * far isn't complete. 
+ */
+bool multi_line_need_more_input(readline_st * const readline_ctx)
+{
+    bool need_more_input;
+    char const * input;
+
+    if (readline_ctx->continuation_callback == NULL)
+    {
+        need_more_input = false;
+        goto done;
+    }
+    if (multi_line_in_use(readline_ctx))
+    {
+        save_current_row(readline_ctx);
+        input = rows_get_all_text(&readline_ctx->rows);
+    }
+    else
+    {
+        input = line_context_get_line(&readline_ctx->line_context);
+    }
+    need_more_input = readline_ctx->continuation_callback(input, readline_ctx->user_context);
+
+done:
+    return need_more_input;
+}
+
+/* The number of terminal lines taken up by the rows from first 
+ * up to but not including last. 
+ */
+static size_t get_screen_lines_between_rows(readline_st * const readline_ctx, size_t const first, size_t const last)
+{
+    size_t screen_lines = 0;
+    size_t index;
+
+    for (index = first; index < last; index++)
+    {
+        screen_lines += rows_get_row(&readline_ctx->rows, index)->screen_lines;
+    }
+
+    return screen_lines;
+}
+
+static void move_to_row(readline_st * const readline_ctx, size_t const row_index, size_t const edit_index)
+{
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+    row_st const * row;
+
+    save_current_row(readline_ctx);
+
+    /* Go to the start of the current row, then up or down to the 
+     * start of the new one. 
+     */
+    terminal_move_physical_cursor_up(line_ctx->output, line_ctx->terminal_cursor.row);
+    tty_put(line_ctx->output, '\r');
+    if (row_index < readline_ctx->current_row)
+    {
+        terminal_move_physical_cursor_up(line_ctx->output, 
+                                         get_screen_lines_between_rows(readline_ctx, row_index, readline_ctx->current_row));
+    }
+    else
+    {
+        terminal_move_physical_cursor_down(line_ctx->output, 
+                                           get_screen_lines_between_rows(readline_ctx, readline_ctx->current_row, row_index));
+    }
+
+    readline_ctx->current_row = row_index;
+    row = rows_get_row(&readline_ctx->rows, row_index);
+    line_context_load(line_ctx, 
+                      get_row_prompt(readline_ctx, row_index), 
+                      rows_get_text(&readline_ctx->rows, row_index), 
+                      row->length, 
+                      row->screen_lines, 
+                      edit_index, 
+                      false);
+}
+
+/* Called when ENTER is pressed and more input is needed. Opens a 
+ * new row if on the last row, otherwise moves to the next one. 
+ */
+void multi_line_start_next_row(readline_st * const readline_ctx)
+{
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+
+    if (!multi_line_in_use(readline_ctx))
+    {
+        /* Everything so far becomes the first row. */
+        rows_clear(&readline_ctx->rows);
+        if (!rows_append(&readline_ctx->rows, line_context_get_line(line_ctx), line_ctx->line_length))
+        {
+            goto done;
+        }
+        rows_get_row(&readline_ctx->rows, 0)->screen_lines = line_ctx->terminal_cursor.num_rows;
+        readline_ctx->first_row_prompt = line_ctx->prompt;
+        readline_ctx->current_row = 0;
+    }
+
+    if (readline_ctx->current_row + 1 < rows_get_num_rows(&readline_ctx->rows))
+    {
+        move_to_row(readline_ctx, readline_ctx->current_row + 1, line_ctx->edit_index);
+        goto done;
+    }
+
+    save_current_row(readline_ctx);
+    if (!rows_append(&readline_ctx->rows, "", 0))
+    {
+        goto done;
+    }
+    move_cursor_right_n_columns(line_ctx, line_ctx->line_length - line_ctx->edit_index);
+    tty_put(line_ctx->output, '\n');
+    readline_ctx->current_row++;
+    line_context_load(line_ctx, get_row_prompt(readline_ctx, readline_ctx->current_row), "", 0, 1, 0, true);
+
+done:
+    return;
+}
+
+/* Called once the block is complete. Leaves the cursor at the 
+ * end of the last row, and the whole block in the line context. 
+ */
+void multi_line_finish(readline_st * const readline_ctx)
+{
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+    size_t const last_row = rows_get_num_rows(&readline_ctx->rows) - 1;
+
+    if (!multi_line_in_use(readline_ctx))
+    {
+        goto done;
+    }
+    if (readline_ctx->current_row != last_row)
+    {
+        move_to_row(readline_ctx, last_row, rows_get_row(&readline_ctx->rows, last_row)->length);
+    }
+    else
+    {
+        save_current_row(readline_ctx);
+    }
+    move_cursor_right_n_columns(line_ctx, line_ctx->line_length - line_ctx->edit_index);
+    line_context_set_line(line_ctx, rows_get_all_text(&readline_ctx->rows));
+
+done:
+    return;
+}
+
+/* Returns true if the key was used to move between rows, rather 
+ * than being left for moving through the history. 
+ */
+bool multi_line_move_up(readline_st * const readline_ctx)
+{
+    bool const in_use = multi_line_in_use(readline_ctx);
+
+    if (in_use && readline_ctx->current_row > 0)
+    {
+        move_to_row(readline_ctx, readline_ctx->current_row - 1, readline_ctx->line_context.edit_index);
+    }
+
+    return in_use;
+}
+
+bool multi_line_move_down(readline_st * const readline_ctx)
+{
+    bool const in_use = multi_line_in_use(readline_ctx);
+
+    if (in_use && readline_ctx->current_row + 1 < rows_get_num_rows(&readline_ctx->rows))
+    {
+        move_to_row(readline_ctx, readline_ctx->current_row + 1, readline_ctx->line_context.edit_index);
+    }
+
+    return in_use;
+}
+
+/* Draw a row that isn't being edited, starting from the 
+ * beginning of a terminal line. Returns the number of times the 
+ * row wrapped onto the next terminal line. 
+ */
+static size_t draw_row(readline_st * const readline_ctx, size_t const row_index)
+{
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+    row_st * const row = rows_get_row(&readline_ctx->rows, row_index);
+    terminal_cursor_st terminal_cursor;
+
+    terminal_cursor_init(&terminal_cursor);
+    terminal_puts(&terminal_cursor, 
+                  get_row_prompt(readline_ctx, row_index), 
+                  '\0', 
+                  line_ctx->output, 
+                  line_ctx->terminal_width);
+    terminal_write(&terminal_cursor, 
+                   rows_get_text(&readline_ctx->rows, row_index), 
+                   row->length, 
+                   line_ctx->mask_character, 
+                   line_ctx->output, 
+                   line_ctx->terminal_width);
+    terminal_delete_to_end_of_line(line_ctx->output);
+    row->screen_lines = terminal_cursor.num_rows;
+
+    return terminal_cursor.row;
+}
+
+/* Draw the rows after the current one, starting from the end of 
+ * the current row. Returns the number of terminal lines moved 
+ * down. 
+ */
+static size_t draw_following_rows(readline_st * const readline_ctx)
+{
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+    size_t lines_moved = 0;
+    size_t index;
+
+    for (index = readline_ctx->current_row + 1; index < rows_get_num_rows(&readline_ctx->rows); index++)
+    {
+        tty_put(line_ctx->output, '\n');
+        lines_moved += 1 + draw_row(readline_ctx, index);
+    }
+
+    return lines_moved;
+}
+
+/* Put the cursor back where it was in the current row after 
+ * drawing the rows below it. 
+ */
+static void return_to_current_row(readline_st * const readline_ctx, size_t const lines_moved, size_t const edit_index)
+{
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+
+    terminal_move_physical_cursor_up(line_ctx->output, lines_moved);
+    tty_put(line_ctx->output, '\r');
+    terminal_move_physical_cursor_right(line_ctx->output, line_ctx->terminal_cursor.column);
+    move_cursor_left_n_columns(line_ctx, line_ctx->line_length - edit_index);
+}
+
+/* Called after each key. If the row being edited has grown onto 
+ * more terminal lines it will have written over the row below, 
+ * so the rows below are drawn again, one line further down. 
+ */
+void multi_line_update_display(readline_st * const readline_ctx)
+{
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+    size_t const edit_index = line_ctx->edit_index;
+    row_st * row;
+
+    if (!multi_line_in_use(readline_ctx))
+    {
+        goto done;
+    }
+    row = rows_get_row(&readline_ctx->rows, readline_ctx->current_row);
+    if (line_ctx->terminal_cursor.num_rows <= row->screen_lines)
+    {
+        goto done;
+    }
+    row->screen_lines = line_ctx->terminal_cursor.num_rows;
+    if (readline_ctx->current_row + 1 == rows_get_num_rows(&readline_ctx->rows))
+    {
+        goto done;
+    }
+
+    move_cursor_right_n_columns(line_ctx, line_ctx->line_length - line_ctx->edit_index);
+    terminal_delete_to_end_of_line(line_ctx->output);
+    return_to_current_row(readline_ctx, draw_following_rows(readline_ctx), edit_index);
+
+done:
+    return;
+}
+
+/* Draw the whole block again after other output, such as a list 
+ * of completions, has been written below it. 
+ */
+void multi_line_redisplay(readline_st * const readline_ctx)
+{
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+    size_t const current_row = readline_ctx->current_row;
+    size_t const edit_index = line_ctx->edit_index;
+    size_t index;
+
+    if (!multi_line_in_use(readline_ctx))
+    {
+        redisplay_line(line_ctx);
+        goto done;
+    }
+
+    save_current_row(readline_ctx);
+    for (index = 0; index < current_row; index++)
+    {
+        tty_put(line_ctx->output, '\n');
+        draw_row(readline_ctx, index);
+    }
+    tty_put(line_ctx->output, '\n');
+    line_context_load(line_ctx, 
+                      get_row_prompt(readline_ctx, current_row), 
+                      rows_get_text(&readline_ctx->rows, current_row), 
+                      rows_get_row(&readline_ctx->rows, current_row)->length, 
+                      1, 
+                      line_ctx->line_length, 
+                      true);
+    rows_get_row(&readline_ctx->rows, current_row)->screen_lines = line_ctx->terminal_cursor.num_rows;
+    return_to_current_row(readline_ctx, draw_following_rows(readline_ctx), edit_index);
+
+done:
+    return;
+}
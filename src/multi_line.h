@@ -0,0 +1,23 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#ifndef __MULTI_LINE_H__
+#define __MULTI_LINE_H__
+
+#include "readline_context.h"
+
+#include <stdbool.h>
+
+bool multi_line_in_use(readline_st const * const readline_ctx);
+bool multi_line_need_more_input(readline_st * const readline_ctx);
+void multi_line_start_next_row(readline_st * const readline_ctx);
+void multi_line_finish(readline_st * const readline_ctx);
+bool multi_line_move_up(readline_st * const readline_ctx);
+bool multi_line_move_down(readline_st * const readline_ctx);
+void multi_line_update_display(readline_st * const readline_ctx);
+void multi_line_redisplay(readline_st * const readline_ctx);
+
+#endif /* __MULTI_LINE_H__ */
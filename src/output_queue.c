@@ -0,0 +1,347 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include "output_queue.h"
+#include "utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+
+#define INITIAL_OUTPUT_QUEUE_SIZE 256
+#define TELNET_IAC_CHARACTER 255
+
+void output_queue_init(output_queue_st * const output_queue, int const fd)
+{
+    output_queue->fd = fd;
+    output_queue->buffer = NULL;
+    output_queue->buffer_size = 0;
+    output_queue->read_index = 0;
+    output_queue->write_index = 0;
+    output_queue->limit = 0;
+    output_queue->wait_when_full = true;
+    output_queue->overflowed = false;
+    output_queue->telnet_encoding = false;
+}
+
+void output_queue_teardown(output_queue_st * const output_queue)
+{
+    free(output_queue->buffer);
+    output_queue->buffer = NULL;
+    output_queue->buffer_size = 0;
+    output_queue->read_index = 0;
+    output_queue->write_index = 0;
+}
+
+/* Discard anything queued and start writing to a different file 
+ * descriptor. The buffer is kept. 
+ */
+void output_queue_reset(output_queue_st * const output_queue, int const fd)
+{
+    output_queue->fd = fd;
+    output_queue->read_index = 0;
+    output_queue->write_index = 0;
+    output_queue->limit = 0;
+    output_queue->wait_when_full = true;
+    output_queue->overflowed = false;
+    output_queue->telnet_encoding = false;
+}
+
+/* Give back any memory beyond maximum_idle_size, provided 
+ * nothing is queued. 
+ */
+void output_queue_trim(output_queue_st * const output_queue, size_t const maximum_idle_size)
+{
+    if (output_queue_get_length(output_queue) == 0 && output_queue->buffer_size > maximum_idle_size)
+    {
+        char * const new_buffer = realloc(output_queue->buffer, maximum_idle_size);
+
+        if (new_buffer != NULL || maximum_idle_size == 0)
+        {
+            output_queue->buffer = new_buffer;
+            output_queue->buffer_size = maximum_idle_size;
+        }
+    }
+}
+
+size_t output_queue_get_length(output_queue_st const * const output_queue)
+{
+    return output_queue->write_index - output_queue->read_index;
+}
+
+bool output_queue_is_full(output_queue_st const * const output_queue)
+{
+    return output_queue->limit > 0 && output_queue_get_length(output_queue) >= output_queue->limit;
+}
+
+static size_t output_queue_get_room(output_queue_st const * const output_queue)
+{
+    size_t room;
+
+    if (output_queue->limit == 0)
+    {
+        room = SIZE_MAX;
+    }
+    else if (output_queue_is_full(output_queue))
+    {
+        room = 0;
+    }
+    else
+    {
+        room = output_queue->limit - output_queue_get_length(output_queue);
+    }
+
+    return room;
+}
+
+/* Returns true if there is room to queue 'required' characters, 
+ * making room by writing out the queue if the queue waits when 
+ * full. If there isn't room the output is dropped, and that is 
+ * recorded. 
+ */
+static bool output_queue_wait_for_room(output_queue_st * const output_queue, size_t const required)
+{
+    bool have_room = output_queue_get_room(output_queue) >= required;
+
+    if (!have_room && output_queue->wait_when_full)
+    {
+        output_queue_flush(output_queue, true);
+        have_room = output_queue_get_room(output_queue) >= required;
+    }
+    if (!have_room)
+    {
+        output_queue->overflowed = true;
+    }
+
+    return have_room;
+}
+
+static bool output_queue_make_space(output_queue_st * const output_queue, size_t const space_required)
+{
+    bool have_space;
+    size_t const queued = output_queue_get_length(output_queue);
+    size_t new_buffer_size;
+    char * new_buffer;
+
+    if (output_queue->write_index + space_required <= output_queue->buffer_size)
+    {
+        have_space = true;
+        goto done;
+    }
+
+    /* Move what is still queued to the start of the buffer before 
+     * resorting to making it bigger. 
+     */
+    if (output_queue->read_index > 0)
+    {
+        memmove(output_queue->buffer, &output_queue->buffer[output_queue->read_index], queued);
+        output_queue->read_index = 0;
+        output_queue->write_index = queued;
+        if (queued + space_required <= output_queue->buffer_size)
+        {
+            have_space = true;
+            goto done;
+        }
+    }
+
+    new_buffer_size = output_queue->buffer_size > 0 ? output_queue->buffer_size : INITIAL_OUTPUT_QUEUE_SIZE;
+    while (new_buffer_size < queued + space_required)
+    {
+        new_buffer_size *= 2;
+    }
+    new_buffer = realloc(output_queue->buffer, new_buffer_size);
+    if (new_buffer == NULL)
+    {
+        have_space = false;
+        goto done;
+    }
+    output_queue->buffer = new_buffer;
+    output_queue->buffer_size = new_buffer_size;
+    have_space = true;
+
+done:
+    return have_space;
+}
+
+/* Queue the data exactly as is, regardless of the encoding. 
+ * Returns false if not all of it could be queued. 
+ */
+bool output_queue_write_raw(output_queue_st * const output_queue, char const * const data, size_t const length)
+{
+    bool queued_all;
+    size_t index = 0;
+
+    while (index < length)
+    {
+        size_t to_queue;
+
+        if (!output_queue_wait_for_room(output_queue, 1))
+        {
+            queued_all = false;
+            goto done;
+        }
+        to_queue = MIN(length - index, output_queue_get_room(output_queue));
+        if (!output_queue_make_space(output_queue, to_queue))
+        {
+            queued_all = false;
+            goto done;
+        }
+        memcpy(&output_queue->buffer[output_queue->write_index], &data[index], to_queue);
+        output_queue->write_index += to_queue;
+        index += to_queue;
+    }
+    queued_all = true;
+
+done:
+    return queued_all;
+}
+
+/* Queue either all of the characters or none of them. */
+static bool output_queue_put_all_raw(output_queue_st * const output_queue, char const * const data, size_t const length)
+{
+    bool queued;
+
+    if (!output_queue_wait_for_room(output_queue, length) || !output_queue_make_space(output_queue, length))
+    {
+        queued = false;
+        goto done;
+    }
+    memcpy(&output_queue->buffer[output_queue->write_index], data, length);
+    output_queue->write_index += length;
+    queued = true;
+
+done:
+    return queued;
+}
+
+/* A telnet client expects new lines as CR LF, and a 255 
+ * character to be escaped so that it isn't taken as IAC. The 
+ * pair is queued as one, as half of it would be misread. 
+ */
+static bool output_queue_put_telnet(output_queue_st * const output_queue, char const ch)
+{
+    char sequence[2];
+    size_t length = 0;
+
+    if (ch == '\n')
+    {
+        sequence[length++] = '\r';
+    }
+    else if ((unsigned char)ch == TELNET_IAC_CHARACTER)
+    {
+        sequence[length++] = ch;
+    }
+    sequence[length++] = ch;
+
+    return output_queue_put_all_raw(output_queue, sequence, length);
+}
+
+/* Returns false if not all of the data could be queued. */
+bool output_queue_write(output_queue_st * const output_queue, char const * const data, size_t const length)
+{
+    bool queued_all;
+
+    if (output_queue->telnet_encoding)
+    {
+        size_t index;
+
+        queued_all = true;
+        for (index = 0; index < length && queued_all; index++)
+        {
+            queued_all = output_queue_put_telnet(output_queue, data[index]);
+        }
+    }
+    else
+    {
+        queued_all = output_queue_write_raw(output_queue, data, length);
+    }
+
+    return queued_all;
+}
+
+void output_queue_put(output_queue_st * const output_queue, char const ch)
+{
+    if (output_queue->telnet_encoding)
+    {
+        output_queue_put_telnet(output_queue, ch);
+    }
+    else
+    {
+        output_queue_put_all_raw(output_queue, &ch, 1);
+    }
+}
+
+static bool wait_for_file_to_be_writable(int const fd)
+{
+    struct pollfd poll_fd;
+    int poll_result;
+
+    poll_fd.fd = fd;
+    poll_fd.events = POLLOUT;
+
+    do
+    {
+        poll_result = poll(&poll_fd, 1, -1);
+    }
+    while (poll_result == -1 && errno == EINTR);
+
+    return poll_result > 0;
+}
+
+/* Write out as much of the queued output as possible. If 
+ * wait_until_writable is false this never blocks provided the 
+ * file descriptor is non-blocking. 
+ */
+output_queue_flush_result_t output_queue_flush(output_queue_st * const output_queue, bool const wait_until_writable)
+{
+    output_queue_flush_result_t result;
+
+    while (output_queue_get_length(output_queue) > 0)
+    {
+        ssize_t const bytes_written = write(output_queue->fd,
+                                            &output_queue->buffer[output_queue->read_index],
+                                            output_queue_get_length(output_queue));
+
+        if (bytes_written > 0)
+        {
+            output_queue->read_index += bytes_written;
+        }
+        else if (bytes_written == -1 && errno == EINTR)
+        {
+            /* Try again. */
+        }
+        else if (bytes_written == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            if (!wait_until_writable || !wait_for_file_to_be_writable(output_queue->fd))
+            {
+                result = output_queue_flush_result_pending;
+                goto done;
+            }
+        }
+        else
+        {
+            /* Nothing more is going to get written, so discard 
+             * whatever is queued. 
+             */
+            output_queue->read_index = output_queue->write_index;
+            result = output_queue_flush_result_error;
+            goto done;
+        }
+    }
+    result = output_queue_flush_result_done;
+
+done:
+    if (output_queue_get_length(output_queue) == 0)
+    {
+        output_queue->read_index = 0;
+        output_queue->write_index = 0;
+    }
+
+    return result;
+}
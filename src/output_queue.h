@@ -0,0 +1,52 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#ifndef __OUTPUT_QUEUE_H__
+#define __OUTPUT_QUEUE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum output_queue_flush_result_t
+{
+    output_queue_flush_result_done, /* All queued output has been written. */
+    output_queue_flush_result_pending, /* The file descriptor isn't accepting any more output for now. */
+    output_queue_flush_result_error
+} output_queue_flush_result_t;
+
+typedef struct output_queue_st output_queue_st;
+/* Output destined for the terminal is queued here and written out 
+ * in as few writes as possible. 
+ */
+struct output_queue_st
+{
+    int fd;
+    char * buffer;
+    size_t buffer_size;
+    size_t read_index; /* Start of the output still to be written. */
+    size_t write_index; /* Where the next queued character goes. */
+    size_t limit; /* The most that is queued at once. 0 means no limit. */
+    bool wait_when_full; /* Wait to write out some of the queue rather than drop output beyond the limit. */
+    bool overflowed; /* Output was dropped because the queue was full. */
+    bool telnet_encoding; /* Output is going to a telnet client rather than a terminal. */
+};
+
+void output_queue_init(output_queue_st * const output_queue, int const fd);
+void output_queue_teardown(output_queue_st * const output_queue);
+void output_queue_reset(output_queue_st * const output_queue, int const fd);
+
+void output_queue_put(output_queue_st * const output_queue, char const ch);
+bool output_queue_write(output_queue_st * const output_queue, char const * const data, size_t const length);
+bool output_queue_write_raw(output_queue_st * const output_queue, char const * const data, size_t const length);
+
+void output_queue_trim(output_queue_st * const output_queue, size_t const maximum_idle_size);
+
+size_t output_queue_get_length(output_queue_st const * const output_queue);
+bool output_queue_is_full(output_queue_st const * const output_queue);
+
+output_queue_flush_result_t output_queue_flush(output_queue_st * const output_queue, bool const wait_until_writable);
+
+#endif /* __OUTPUT_QUEUE_H__ */
@@ -6,6 +6,7 @@
 
 #include "print_words_in_columns.h"
 #include "terminal.h"
+#include "utils.h"
 
 #include <stddef.h>
 #include <string.h>
@@ -28,17 +29,24 @@ static size_t get_longest_word_length(unsigned int const word_count, char const
     return longest_word_length;
 }
 
-static void pad_column(int const out_fd, unsigned int const width_printed, unsigned int const column_width)
+static void pad_column(output_queue_st * const output, unsigned int const width_printed, unsigned int const column_width)
 {
+    static char const spaces[] = "                                ";
     unsigned int printed = width_printed;
 
-    while (printed++ < column_width)
+    /* Written a block at a time rather than a character at a time, 
+     * as a long list of words is mostly padding. 
+     */
+    while (printed < column_width)
     {
-        tty_put(out_fd, ' ');
+        unsigned int const to_print = MIN(column_width - printed, sizeof spaces - 1);
+
+        tty_write(output, spaces, to_print);
+        printed += to_print;
     }
 }
 
-static void print_row(int const out_fd,
+static void print_row(output_queue_st * const output,
                       unsigned int const row,
                       unsigned int const rows,
                       unsigned int const word_count,
@@ -49,24 +57,20 @@ static void print_row(int const out_fd,
 
     for (word_index = row; word_index < word_count; word_index += rows)
     {
-        size_t char_index;
         size_t word_length;
         char const * current_word;
 
         current_word = words[word_index];
         word_length = strlen(current_word);
-        for (char_index = 0; char_index < word_length; char_index++)
-        {
-            tty_put(out_fd, current_word[char_index]);
-        }
+        tty_write(output, current_word, word_length);
         if (word_index + rows < word_count)
         {
-            pad_column(out_fd, word_length, column_width);
+            pad_column(output, word_length, column_width);
         }
     }
 }
 
-void print_words_in_columns(int const out_fd, int const terminal_width, unsigned int const word_count, char const * * const words)
+void print_words_in_columns(output_queue_st * const output, int const terminal_width, unsigned int const word_count, char const * * const words)
 {
     unsigned int row;
     unsigned int rows;
@@ -80,13 +84,13 @@ void print_words_in_columns(int const out_fd, int const terminal_width, unsigned
     words_per_row = terminal_width / column_width;
     rows = 1 + (word_count / words_per_row);
 
-    tty_put(out_fd, '\n');
+    tty_put(output, '\n');
     for (row = 0; row < rows; row++)
     {
-        print_row(out_fd, row, rows, word_count, words, column_width);
+        print_row(output, row, rows, word_count, words, column_width);
         if (row < rows - 1)
         {
-            tty_put(out_fd, '\n');
+            tty_put(output, '\n');
         }
     }
 }
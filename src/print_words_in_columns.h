@@ -7,6 +7,8 @@
 #ifndef __PRINT_WORDS_IN_COLUMNS_H__
 #define __PRINT_WORDS_IN_COLUMNS_H__
 
-void print_words_in_columns(int const out_fd, int const terminal_width, unsigned int const word_count, char const * * const words);
+#include "output_queue.h"
+
+void print_words_in_columns(output_queue_st * const output, int const terminal_width, unsigned int const word_count, char const * * const words);
 
 #endif /* __PRINT_WORDS_IN_COLUMNS_H__ */
@@ -7,13 +7,139 @@
 #include "read_char.h"
 #include "terminal.h"
 
-int read_char_from_input(int const input_fd, unsigned int const maximum_seconds_to_wait, readline_status_t * const readline_status)
+#include <unistd.h>
+#include <errno.h>
+
+/* A change to the client's window size takes effect straight 
+ * away, including in the middle of a line. 
+ */
+static void update_terminal_width(readline_st * const readline_ctx)
+{
+    if (readline_ctx->telnet.window_size_changed)
+    {
+        readline_ctx->telnet.window_size_changed = false;
+        readline_ctx->line_context.terminal_width = readline_ctx->telnet.width;
+    }
+}
+
+readline_status_t read_input_into_buffer(readline_st * const readline_ctx)
+{
+    readline_status_t status;
+    size_t space_available;
+    char * const destination = input_buffer_get_write_space(&readline_ctx->input_buffer, &space_available);
+    ssize_t bytes_read;
+
+    do
+    {
+        bytes_read = read(readline_ctx->in_fd, destination, space_available);
+    }
+    while (bytes_read == -1 && errno == EINTR);
+
+    if (bytes_read > 0 && readline_ctx->telnet_enabled)
+    {
+        size_t const bytes_of_input = telnet_filter_input(&readline_ctx->telnet,
+                                                          destination,
+                                                          bytes_read,
+                                                          &readline_ctx->output_queue);
+
+        update_terminal_width(readline_ctx);
+        if (bytes_of_input > 0)
+        {
+            input_buffer_commit_write(&readline_ctx->input_buffer, bytes_of_input);
+            status = readline_status_continue;
+        }
+        else
+        {
+            /* There was nothing but telnet commands. */
+            status = readline_status_would_block;
+        }
+    }
+    else if (bytes_read > 0)
+    {
+        input_buffer_commit_write(&readline_ctx->input_buffer, bytes_read);
+        status = readline_status_continue;
+    }
+    else if (bytes_read == 0)
+    {
+        status = readline_status_eof;
+    }
+    else if (errno == EAGAIN || errno == EWOULDBLOCK)
+    {
+        status = readline_status_would_block;
+    }
+    else
+    {
+        status = readline_status_error;
+    }
+
+    return status;
+}
+
+/* Characters from a telnet client go through the input buffer 
+ * so that the telnet commands can be removed first. 
+ */
+static readline_status_t read_char_via_input_buffer(readline_st * const readline_ctx, 
+                                                    unsigned int const maximum_seconds_to_wait, 
+                                                    int * const ch)
+{
+    readline_status_t status;
+
+    /* Only called once the buffer is empty, so there is nothing 
+     * to keep. 
+     */
+    input_buffer_mark(&readline_ctx->input_buffer);
+    do
+    {
+        if (!tty_wait_until_readable(readline_ctx->in_fd, maximum_seconds_to_wait))
+        {
+            status = readline_status_timed_out;
+            goto done;
+        }
+        status = read_input_into_buffer(readline_ctx);
+    }
+    while (status == readline_status_would_block
+           || (status == readline_status_continue && !input_buffer_get_char(&readline_ctx->input_buffer, ch)));
+
+done:
+    return status;
+}
+
+int read_char_from_input(readline_st * const readline_ctx, unsigned int const maximum_seconds_to_wait, readline_status_t * const readline_status)
 {
     int ch;
     readline_status_t status;
     tty_get_result_t tty_get_result;
 
-    tty_get_result = tty_get(input_fd, maximum_seconds_to_wait, &ch);
+    /* Use up any characters that have already been read before 
+     * reading any more from the input. 
+     */
+    if (input_buffer_get_char(&readline_ctx->input_buffer, &ch))
+    {
+        status = readline_status_continue;
+        goto done;
+    }
+
+    if (readline_ctx->non_blocking)
+    {
+        /* The caller will read more input once the input file 
+         * descriptor is readable. 
+         */
+        status = readline_status_would_block;
+        goto done;
+    }
+
+    /* Make sure that the user can see everything before waiting 
+     * for them to type something. 
+     */
+    output_queue_flush(&readline_ctx->output_queue, true);
+
+    if (readline_ctx->telnet_enabled)
+    {
+        status = read_char_via_input_buffer(readline_ctx, maximum_seconds_to_wait, &ch);
+        goto done;
+    }
+
+    tty_get_result = tty_get(readline_ctx->in_fd, maximum_seconds_to_wait, &ch);
     switch (tty_get_result)
     {
         case tty_get_result_eof:
@@ -8,9 +8,12 @@
 #define __READ_CHAR_H__
 
 #include "readline_status.h"
+#include "readline_context.h"
 
-int read_char_from_input(int const input_fd,
+int read_char_from_input(readline_st * const readline_ctx,
                          unsigned int const maximum_seconds_to_wait,
                          readline_status_t * const readline_status);
 
+readline_status_t read_input_into_buffer(readline_st * const readline_ctx);
+
 #endif /* __READ_CHAR_H__ */
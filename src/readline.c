@@ -15,18 +15,39 @@
 #include "read_char.h"
 #include "handlers.h"
 #include "terminal_cursor.h"
+#include "multi_line.h"
+#include "utils.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <string.h>
 
-#define INITIAL_LINE_BUFFER_SIZE 10
-#define LINE_BUFFER_SIZE_INCREMENT 5
+#define INITIAL_LINE_BUFFER_SIZE 80
+/* Buffers are kept between lines so that editing a line doesn't 
+ * need any memory to be allocated, but no more than this is kept 
+ * once a line is finished, so that one very long line doesn't tie 
+ * up memory for the life of the context. 
+ */
+#define MAXIMUM_IDLE_BUFFER_SIZE 1024
+#define DEFAULT_TELNET_WIDTH 80 /* Used until the client reports its window size. */
 
 #define BACKSPACE 127
 #define ESC 27
 
+typedef struct line_destination_st line_destination_st;
+/* Where a finished line is delivered. Only one of allocated_line, 
+ * buffer and borrowed_line is set. 
+ */
+struct line_destination_st
+{
+    char * * allocated_line; /* The caller gets a copy that it must free. */
+    char * buffer; /* The line is copied into a buffer owned by the caller. */
+    size_t buffer_size;
+    char const * * borrowed_line; /* The caller gets a pointer to the edit buffer itself. */
+    size_t * length; /* If not NULL, set to the length of the line. */
+};
+
 
 static readline_status_t handle_new_input_from_terminal(readline_st * const readline_ctx, int const ch)
 {
@@ -53,6 +74,17 @@ static readline_status_t handle_new_input_from_terminal(readline_st * const read
             }
             break;
     }
+    /* Not counted if an escape sequence is incomplete, as it will 
+     * be handled again once the rest of it arrives. 
+     */
+    if (status != readline_status_would_block)
+    {
+        readline_ctx->key_count++;
+    }
+    if (status == readline_status_continue)
+    {
+        multi_line_update_display(readline_ctx);
+    }
 
     return status;
 }
@@ -64,7 +96,15 @@ static readline_status_t handle_new_input_from_file(readline_st * const readline
     switch (ch)
     {
         case '\n':
-            status = readline_status_done;
+            if (multi_line_need_more_input(readline_ctx))
+            {
+                write_char(&readline_ctx->line_context, '\n', true, false);
+                status = readline_status_continue;
+            }
+            else
+            {
+                status = readline_status_done;
+            }
             break;
         default:
             handle_regular_char(readline_ctx, ch, false);
@@ -108,29 +148,71 @@ static unsigned int get_read_timeout(readline_st * const readline_ctx)
     return timeout_seconds;
 }
 
+/* Completion and help callbacks write straight to out_fd, so 
+ * anything already queued must be written first. In non-blocking 
+ * mode that can't be waited for, so the key is left until 
+ * readline_process_writable() has drained the queue, and only this 
+ * session is held up. 
+ */
+static bool key_must_wait_for_output(readline_st * const readline_ctx, int const ch)
+{
+    bool must_wait;
+    bool const is_completion_key = ch == '\t'
+        && readline_ctx->completion_callback != NULL
+        && readline_ctx->mask_character == '\0';
+    bool const is_help_key = readline_ctx->help_key != '\0'
+        && ch == (int)readline_ctx->help_key
+        && readline_ctx->help_callback != NULL;
+
+    if (!readline_ctx->non_blocking || !readline_ctx->is_a_terminal || (!is_completion_key && !is_help_key))
+    {
+        must_wait = false;
+        goto done;
+    }
+    must_wait = output_queue_flush(&readline_ctx->output_queue, false) == output_queue_flush_result_pending;
+    readline_ctx->waiting_for_output = must_wait;
+
+done:
+    return must_wait;
+}
+
+/* Input isn't processed while the output is backed up. */
+static bool output_is_holding_up_input(readline_st const * const readline_ctx)
+{
+    output_queue_st const * const output_queue = &readline_ctx->output_queue;
+
+    return output_queue_is_full(output_queue)
+        || (readline_ctx->waiting_for_output && output_queue_get_length(output_queue) > 0);
+}
+
 static readline_status_t get_and_process_new_input(readline_st * const readline_ctx)
 {
     readline_status_t status;
     int ch;
     unsigned int const timeout_seconds = get_read_timeout(readline_ctx);
 
-    ch = read_char_from_input(readline_ctx->in_fd,
+    readline_ctx->waiting_for_output = false;
+    ch = read_char_from_input(readline_ctx,
                               timeout_seconds,
                               &status);
     if (status != readline_status_continue)
     {
         goto done;
     }
+    if (key_must_wait_for_output(readline_ctx, ch))
+    {
+        /* The caller puts the key back. */
+        status = readline_status_would_block;
+        goto done;
+    }
     status = process_new_input(readline_ctx, ch);
 
 done:
     return status;
 }
 
-static readline_status_t edit_input(readline_st * const readline_ctx)
+static void display_prompt(readline_st * const readline_ctx)
 {
-    readline_status_t status = readline_status_continue;
-
     if (readline_ctx->is_a_terminal)
     {
         line_context_st * const line_ctx = &readline_ctx->line_context;
@@ -138,9 +220,16 @@ static readline_status_t edit_input(readline_st * const readline_ctx)
         terminal_puts(&line_ctx->terminal_cursor, 
                       line_ctx->prompt, 
                       '\0',
-                      line_ctx->terminal_fd,
+                      line_ctx->output,
                       line_ctx->terminal_width);
     }
+}
+
+static readline_status_t edit_input(readline_st * const readline_ctx)
+{
+    readline_status_t status = readline_status_continue;
+
+    display_prompt(readline_ctx);
 
     do
     {
@@ -161,14 +250,24 @@ static bool readline_init(readline_st * const readline_ctx,
 
     readline_ctx->maximum_seconds_to_wait_for_char = timeout_seconds;
 
-    if (readline_ctx->is_a_terminal)
+    if (readline_ctx->telnet_enabled)
+    {
+        terminal_width = readline_ctx->telnet.width > 0 ? readline_ctx->telnet.width : DEFAULT_TELNET_WIDTH;
+        readline_ctx->telnet.window_size_changed = false;
+
+        history_reset(readline_ctx->history);
+
+        /* There is no local terminal to set up. */
+        readline_ctx->terminal_was_modified = false;
+    }
+    else if (readline_ctx->is_a_terminal)
     {
         terminal_width = terminal_get_width(readline_ctx->out_fd);
 
         history_reset(readline_ctx->history);
 
-        readline_ctx->previous_terminal_settings = terminal_prepare();
-        readline_ctx->terminal_was_modified = true;
+        readline_ctx->terminal_was_modified = terminal_prepare(readline_ctx->in_fd, 
+                                                               &readline_ctx->previous_terminal_settings);
     }
     else
     {
@@ -176,13 +275,23 @@ static bool readline_init(readline_st * const readline_ctx,
         terminal_width = 0; /* Should be unused in non-tty mode. */
     }
 
-    free_saved_string(&readline_ctx->saved_line); 
+    if (readline_ctx->line_is_lent)
+    {
+        /* The caller has finished with the line now, so the buffer 
+         * can be trimmed as it would have been at the end of the 
+         * last line. 
+         */
+        line_context_trim(line_ctx, MAXIMUM_IDLE_BUFFER_SIZE);
+        readline_ctx->line_is_lent = false;
+    }
+    saved_line_clear(&readline_ctx->saved_line); 
+    rows_clear(&readline_ctx->rows);
+    readline_ctx->waiting_for_output = false;
 
     if (!line_context_init(line_ctx,
                            INITIAL_LINE_BUFFER_SIZE,
-                           LINE_BUFFER_SIZE_INCREMENT,
                            readline_ctx->maximum_line_length,
-                           readline_ctx->out_fd,
+                           &readline_ctx->output_queue,
                            terminal_width,
                            readline_ctx->mask_character,
                            prompt))
@@ -204,12 +313,27 @@ static void readline_cleanup(readline_st * const readline_ctx)
 
     if (readline_ctx->terminal_was_modified)
     {
-        terminal_restore(readline_ctx->previous_terminal_settings);
-        readline_ctx->previous_terminal_settings = NULL;
+        terminal_restore(&readline_ctx->previous_terminal_settings);
+        readline_ctx->terminal_was_modified = false;
     }
 
-    line_context_teardown(line_ctx);
-    free_saved_string(&readline_ctx->saved_line);
+    /* A line lent to the caller must stay put until the next 
+     * line is started. 
+     */
+    if (!readline_ctx->line_is_lent)
+    {
+        line_context_trim(line_ctx, MAXIMUM_IDLE_BUFFER_SIZE);
+    }
+    rows_trim(&readline_ctx->rows, MAXIMUM_IDLE_BUFFER_SIZE);
+    arena_trim(&readline_ctx->arena, MAXIMUM_IDLE_BUFFER_SIZE);
+    saved_line_clear(&readline_ctx->saved_line);
+    /* In non-blocking mode anything that can't be written now 
+     * stays queued until the output is writable again. 
+     */
+    output_queue_flush(&readline_ctx->output_queue, !readline_ctx->non_blocking);
+    output_queue_trim(&readline_ctx->output_queue, MAXIMUM_IDLE_BUFFER_SIZE);
+    readline_ctx->output_queue.wait_when_full = true;
+    readline_ctx->non_blocking = false;
 }
 
 static readline_result_t readline_status_to_result(readline_status_t const readline_status, bool * const should_return_line)
@@ -227,6 +351,8 @@ static readline_result_t readline_status_to_result(readline_status_t const readl
         }
         case readline_status_continue:  /* Shouldn't happen, but if it does, call it an error. */
             /* drop through */
+        case readline_status_would_block:
+            /* drop through */
         case readline_status_error:
             readline_result = readline_result_error;
             break;
@@ -250,40 +376,73 @@ static readline_result_t readline_status_to_result(readline_status_t const readl
     return readline_result;
 }
 
-readline_result_t readline(readline_st * const readline_ctx, unsigned int const timeout_seconds, char const * const prompt, char * * const line)
+/* line is NULL if there is no line to return. */
+static void deliver_line(readline_st * const readline_ctx, 
+                         line_destination_st const * const destination, 
+                         char const * const line, 
+                         size_t const length)
 {
-    readline_status_t readline_status;
-    readline_result_t readline_result;
-    line_context_st * const line_ctx = &readline_ctx->line_context;
-    bool should_return_line = false;
+    if (destination->allocated_line != NULL)
+    {
+        *destination->allocated_line = line != NULL ? strdup(line) : NULL;
+    }
+    else if (destination->buffer != NULL)
+    {
+        if (destination->buffer_size > 0)
+        {
+            /* Like snprintf(), the line is truncated to fit, and the 
+             * length returned is that of the whole line. 
+             */
+            size_t bytes_to_copy = 0;
 
-    if (!readline_init(readline_ctx, prompt, timeout_seconds))
+            if (line != NULL)
+            {
+                bytes_to_copy = MIN(length, destination->buffer_size - 1);
+                memcpy(destination->buffer, line, bytes_to_copy);
+            }
+            destination->buffer[bytes_to_copy] = '\0';
+        }
+    }
+    else if (destination->borrowed_line != NULL)
     {
-        readline_result = readline_result_error;
-        goto done;
+        *destination->borrowed_line = line;
+        readline_ctx->line_is_lent = line != NULL;
     }
+    if (destination->length != NULL)
+    {
+        *destination->length = line != NULL ? length : 0;
+    }
+}
 
-    readline_status = edit_input(readline_ctx);
+/* Called once editing of a line has finished for whatever 
+ * reason. Hands the line back to the caller if appropriate. 
+ */
+static readline_result_t readline_complete(readline_st * const readline_ctx, 
+                                           readline_status_t const readline_status, 
+                                           line_destination_st const * const destination)
+{
+    readline_result_t readline_result;
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+    bool should_return_line;
 
     readline_result = readline_status_to_result(readline_status, &should_return_line);
 
-done:
     if (should_return_line)
     {
         bool const should_add_to_history = readline_ctx->history_enabled &&
             readline_ctx->is_a_terminal &&
-            readline_ctx->mask_character == '\0';
+            readline_ctx->mask_character == '\0' &&
+            !multi_line_in_use(readline_ctx);
 
         if (should_add_to_history)
         {
-            history_add(readline_ctx->history, line_ctx->edit_buffer);
+            history_add(readline_ctx->history, line_context_get_line(line_ctx));
         }
-        *line = line_ctx->edit_buffer;
-        line_ctx->edit_buffer = NULL;
+        deliver_line(readline_ctx, destination, line_context_get_line(line_ctx), line_ctx->line_length);
     }
     else
     {
-        *line = NULL;
+        deliver_line(readline_ctx, destination, NULL, 0);
     }
 
     readline_cleanup(readline_ctx);
@@ -291,34 +450,358 @@ done:
     return readline_result;
 }
 
-static tokens_st * parse_tokens_from_line(char const * const line, char const * const field_separators)
+static readline_result_t readline_to_destination(readline_st * const readline_ctx, 
+                                                 unsigned int const timeout_seconds, 
+                                                 char const * const prompt, 
+                                                 line_destination_st const * const destination)
+{
+    readline_status_t readline_status;
+
+    if (!readline_init(readline_ctx, prompt, timeout_seconds))
+    {
+        readline_status = readline_status_error;
+        goto done;
+    }
+
+    readline_status = edit_input(readline_ctx);
+
+done:
+    return readline_complete(readline_ctx, readline_status, destination);
+}
+
+readline_result_t readline(readline_st * const readline_ctx, unsigned int const timeout_seconds, char const * const prompt, char * * const line)
 {
-    tokens_st * tokens;
+    /* The edit buffer is kept for the next line, so the caller 
+     * gets a copy. 
+     */
+    line_destination_st const destination = { .allocated_line = line };
+
+    return readline_to_destination(readline_ctx, timeout_seconds, prompt, &destination);
+}
 
-    tokens = tokenise_line(line, 0, 0, false, field_separators);
+readline_result_t readline_into(readline_st * const readline_ctx, 
+                                unsigned int const timeout_seconds, 
+                                char const * const prompt, 
+                                char * const buffer, 
+                                size_t const buffer_size, 
+                                size_t * const length)
+{
+    line_destination_st const destination = { .buffer = buffer, .buffer_size = buffer_size, .length = length };
 
-    return tokens;
+    return readline_to_destination(readline_ctx, timeout_seconds, prompt, &destination);
 }
 
-static args_st * get_args_from_tokens(tokens_st const * const tokens)
+readline_result_t readline_borrow(readline_st * const readline_ctx, 
+                                  unsigned int const timeout_seconds, 
+                                  char const * const prompt, 
+                                  char const * * const line, 
+                                  size_t * const length)
 {
+    line_destination_st const destination = { .borrowed_line = line, .length = length };
+
+    return readline_to_destination(readline_ctx, timeout_seconds, prompt, &destination);
+}
+
+readline_result_t readline_begin(readline_st * const readline_ctx, char const * const prompt)
+{
+    readline_result_t readline_result;
+
+    /* Characters are only read from the input when 
+     * readline_process_ready() is called, so there is no timeout. 
+     */
+    if (!readline_init(readline_ctx, prompt, 0))
+    {
+        line_destination_st const destination = { .allocated_line = NULL };
+
+        readline_result = readline_complete(readline_ctx, readline_status_error, &destination);
+        goto done;
+    }
+    readline_ctx->non_blocking = true;
+    readline_ctx->output_queue.wait_when_full = false;
+
+    display_prompt(readline_ctx);
+    output_queue_flush(&readline_ctx->output_queue, false);
+
+    readline_result = readline_result_success;
+
+done:
+    return readline_result;
+}
+
+void readline_get_fds(readline_st const * const readline_ctx, readline_fds_st * const fds)
+{
+    output_queue_st const * const output_queue = &readline_ctx->output_queue;
+    /* Stop taking input from a user that isn't reading the output. */
+    bool const accept_input = !output_is_holding_up_input(readline_ctx);
+
+    fds->read_fd = accept_input ? readline_ctx->in_fd : -1;
+    fds->write_fd = output_queue_get_length(output_queue) > 0 ? readline_ctx->out_fd : -1;
+    fds->input_pending = accept_input && input_buffer_has_unprocessed_input(&readline_ctx->input_buffer);
+}
+
+/* Lets the application have its output queued in sequence with 
+ * the output from the context. 
+ */
+bool readline_write_output(readline_st * const readline_ctx, char const * const data, size_t const length)
+{
+    bool const queued_all = output_queue_write(&readline_ctx->output_queue, data, length);
+
+    if (!readline_ctx->non_blocking)
+    {
+        output_queue_flush(&readline_ctx->output_queue, true);
+    }
+
+    return queued_all;
+}
+
+readline_result_t readline_process_writable(readline_st * const readline_ctx)
+{
+    readline_result_t readline_result;
+    output_queue_flush_result_t flush_result;
+
+    flush_result = output_queue_flush(&readline_ctx->output_queue, false);
+    if (flush_result == output_queue_flush_result_done && readline_ctx->output_queue.overflowed)
+    {
+        /* Some of the output was dropped, so the terminal may not 
+         * match the line any more. Now that there is room, show the 
+         * line again. 
+         */
+        readline_ctx->output_queue.overflowed = false;
+        if (readline_ctx->non_blocking)
+        {
+            multi_line_redisplay(readline_ctx);
+            /* A line too long to fit isn't shown again and again. */
+            readline_ctx->output_queue.overflowed = false;
+            flush_result = output_queue_flush(&readline_ctx->output_queue, false);
+        }
+    }
+
+    switch (flush_result)
+    {
+        case output_queue_flush_result_done:
+            readline_result = readline_result_success;
+            break;
+        case output_queue_flush_result_pending:
+            readline_result = readline_result_pending;
+            break;
+        case output_queue_flush_result_error:
+        default:
+            readline_result = readline_result_error;
+            break;
+    }
+
+    return readline_result;
+}
+
+/* Process the characters already read from the input until 
+ * either the line is done or more characters are needed. 
+ */
+static readline_status_t process_buffered_input(readline_st * const readline_ctx)
+{
+    readline_status_t status;
+
+    do
+    {
+        if (output_is_holding_up_input(readline_ctx))
+        {
+            /* Leave the rest of the input until the output has 
+             * drained. 
+             */
+            status = readline_status_would_block;
+            break;
+        }
+        input_buffer_mark(&readline_ctx->input_buffer);
+        status = get_and_process_new_input(readline_ctx);
+        if (status == readline_status_would_block && readline_ctx->waiting_for_output)
+        {
+            /* The key is processed again once the output has 
+             * drained. 
+             */
+            input_buffer_put_back_to_mark(&readline_ctx->input_buffer);
+        }
+        else if (status == readline_status_would_block)
+        {
+            /* Part of a key sequence may have been consumed. Put it 
+             * back so that the whole sequence gets decoded once the 
+             * rest of it arrives. 
+             */
+            input_buffer_rewind_to_mark(&readline_ctx->input_buffer);
+        }
+    }
+    while (status == readline_status_continue);
+
+    return status;
+}
+
+/* Only a single read() is done per call so this won't block 
+ * even if the input file descriptor is in blocking mode, 
+ * provided it was reported as readable. 
+ */
+static readline_result_t process_ready(readline_st * const readline_ctx, line_destination_st const * const destination)
+{
+    readline_status_t status;
+    readline_result_t readline_result;
+
+    if (!readline_ctx->non_blocking)
+    {
+        deliver_line(readline_ctx, destination, NULL, 0);
+        readline_result = readline_result_error;
+        goto done;
+    }
+
+    output_queue_flush(&readline_ctx->output_queue, false);
+
+    /* There may be input left over from a previous line. */
+    if (input_buffer_has_unprocessed_input(&readline_ctx->input_buffer))
+    {
+        status = process_buffered_input(readline_ctx);
+    }
+    else
+    {
+        status = readline_status_would_block;
+    }
+    if (status == readline_status_would_block && !output_is_holding_up_input(readline_ctx))
+    {
+        status = read_input_into_buffer(readline_ctx);
+        if (status == readline_status_continue)
+        {
+            status = process_buffered_input(readline_ctx);
+        }
+    }
+
+    if (status == readline_status_would_block)
+    {
+        output_queue_flush(&readline_ctx->output_queue, false);
+        deliver_line(readline_ctx, destination, NULL, 0);
+        readline_result = readline_result_pending;
+        goto done;
+    }
+
+    /* Any output left over is flushed by readline_cleanup(). */
+    readline_result = readline_complete(readline_ctx, status, destination);
+
+done:
+    return readline_result;
+}
+
+readline_result_t readline_process_ready(readline_st * const readline_ctx, char * * const line)
+{
+    line_destination_st const destination = { .allocated_line = line };
+
+    return process_ready(readline_ctx, &destination);
+}
+
+readline_result_t readline_process_ready_into(readline_st * const readline_ctx, 
+                                              char * const buffer, 
+                                              size_t const buffer_size, 
+                                              size_t * const length)
+{
+    line_destination_st const destination = { .buffer = buffer, .buffer_size = buffer_size, .length = length };
+
+    return process_ready(readline_ctx, &destination);
+}
+
+readline_result_t readline_process_ready_borrow(readline_st * const readline_ctx, 
+                                                char const * * const line, 
+                                                size_t * const length)
+{
+    line_destination_st const destination = { .borrowed_line = line, .length = length };
+
+    return process_ready(readline_ctx, &destination);
+}
+
+static bool parse_tokens_from_line(tokens_st * const tokens, char const * const line, token_class_st const * const token_class)
+{
+    return tokenise_line(tokens, line, 0, 0, false, token_class);
+}
+
+/* The args are copied straight from the line, or from the token 
+ * text for those with quotes or escapes, into a block that is 
+ * allocated once it is known how big it must be. 
+ */
+static bool get_args_from_tokens(tokens_st const * const tokens, 
+                                 char const * const line, 
+                                 size_t const extra_size_per_arg, 
+                                 args_st * const args)
+{
+    bool got_args;
     size_t index;
-    args_st * args;
+    size_t strings_length;
+    token_span_st span;
     size_t const token_count = tokens_get_num_tokens(tokens);
 
-    args = args_alloc(token_count + 1);   /* include 1 for the NULL terminator */
-    if (args == NULL)
+    strings_length = 0;
+    for (index = 0; index < token_count; index++)
+    {
+        tokens_get_token_span(tokens, line, index, &span);
+        strings_length += span.length;
+    }
+    if (!args_alloc(args, token_count, strings_length, token_count * extra_size_per_arg))
     {
+        got_args = false;
         goto done;
     }
     for (index = 0; index < token_count; index++)
     {
-        args_add_arg(args, tokens_get_token_at_index(tokens, index));
+        tokens_get_token_span(tokens, line, index, &span);
+        args_add_arg(args, span.text, span.length);
+    }
+    got_args = true;
+
+done:
+    return got_args;
+}
+
+/* Read a line and split it into args, with room in the args block 
+ * for 'extra_size_per_arg' bytes of other data for each arg. 
+ * args->argv is NULL if there are no args. The line is still lent 
+ * afterwards, so that its tokens can be looked at, until 
+ * release_args_line() is called. 
+ */
+static readline_result_t read_args(readline_st * const readline_ctx, 
+                                   unsigned int const timeout_seconds, 
+                                   char const * const prompt, 
+                                   size_t const extra_size_per_arg, 
+                                   args_st * const args, 
+                                   char const * * const line, 
+                                   size_t * const length)
+{
+    readline_result_t result;
+    line_context_st * const line_ctx = &readline_ctx->line_context;
+    tokens_st * const tokens = &line_ctx->tokens;
+
+    args->argc = 0;
+    args->argv = NULL;
+    /* The line is borrowed rather than copied, as it is only 
+     * needed until the args have been made from it. 
+     */
+    result = readline_borrow(readline_ctx, timeout_seconds, prompt, line, length);
+    if (*line == NULL)
+    {
+        goto done;
+    }
+
+    if (!parse_tokens_from_line(tokens, *line, &line_ctx->token_class))
+    {
+        goto done;
     }
-    args_add_arg(args, NULL);
+
+    get_args_from_tokens(tokens, *line, extra_size_per_arg, args);
 
 done:
-    return args;
+    return result;
+}
+
+static void release_args_line(readline_st * const readline_ctx)
+{
+    if (readline_ctx->line_is_lent)
+    {
+        /* The args are copies, so the line and its tokens are no 
+         * longer needed. 
+         */
+        readline_ctx->line_is_lent = false;
+        line_context_trim(&readline_ctx->line_context, MAXIMUM_IDLE_BUFFER_SIZE);
+    }
 }
 
 /* this version of readline returns a set of args rather than 
@@ -331,41 +814,61 @@ readline_result_t readline_args(readline_st * const readline_ctx,
                                 char const * * * argv)
 {
     readline_result_t result;
-    char * line;
-    tokens_st * tokens = NULL;
-    args_st * args;
+    char const * line;
+    size_t length;
+    args_st args;
 
-    result = readline(readline_ctx, timeout_seconds, prompt, &line);
-    if (line == NULL)
-    {
-        args = NULL;
-        goto done;
-    }
+    result = read_args(readline_ctx, timeout_seconds, prompt, 0, &args, &line, &length);
+    *argc = args.argc;
+    *argv = args_release(&args);
+    release_args_line(readline_ctx);
 
-    tokens = parse_tokens_from_line(line, readline_ctx->field_separators);
-    if (tokens == NULL)
-    {
-        args = NULL;
-        goto done;
-    }
+    return result;
+}
 
-    args = get_args_from_tokens(tokens);
+/* The args are matched against the grammar, and where each one is 
+ * in the line is taken from its token while the line is still 
+ * lent. 
+ */
+readline_result_t readline_command(readline_st * const readline_ctx, 
+                                   unsigned int const timeout_seconds, 
+                                   char const * const prompt, 
+                                   command_grammar_st const * const grammar, 
+                                   size_t * const argc, 
+                                   char const * * * argv, 
+                                   command_st * const command)
+{
+    readline_result_t result;
+    char const * line;
+    size_t length;
+    args_st args;
+    tokens_st const * const tokens = &readline_ctx->line_context.tokens;
+    size_t index;
 
-done:
+    result = read_args(readline_ctx, timeout_seconds, prompt, sizeof(command_arg_st), &args, &line, &length);
+    command_grammar_parse(grammar, args.argc, (char const * const *)args.argv, args.extra, command);
+    for (index = 0; index < command->error_index && index < args.argc; index++)
+    {
+        token_span_st span;
 
-    free(line);
-    tokens_free(tokens);
-    if (args != NULL)
+        tokens_get_token_span(tokens, line, index, &span);
+        command->args[index].line_index = span.line_index;
+        command->args[index].length = tokens_get_token_line_length(tokens, index);
+    }
+    if (command->error_index < args.argc)
     {
-        *argc = args->argc;
-        *argv = args->argv;
-        args->argv = NULL;
+        token_span_st span;
+
+        tokens_get_token_span(tokens, line, command->error_index, &span);
+        command->error_line_index = span.line_index;
     }
     else
     {
-        *argv = NULL;
+        command->error_line_index = line != NULL ? length : 0;
     }
-    args_free(args);
+    *argc = args.argc;
+    *argv = args_release(&args);
+    release_args_line(readline_ctx);
 
     return result;
 }
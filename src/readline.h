@@ -8,7 +8,7 @@
 #define __READLINE_PRIVATE_H__
 
 #include "../include/readline.h"
-#include "args.h"
+#include "arena.h"
 #include "line_context.h"
 #include "tokenise.h"
 
@@ -18,12 +18,19 @@
 #define ISCTL(x)        ((x) && (x) < 0x20)
 
 typedef struct private_completion_context_st private_completion_context_st;
+/* Everything the context refers to is allocated from the arena, 
+ * which is reset once the completion is finished. 
+ */
 struct private_completion_context_st
 {
-    args_st * possible_words;
+    arena_st * arena;
+    char const * * possible_words;
+    size_t num_possible_words;
+    size_t possible_words_size; /* The number of words there is space for. */
     char const * unique_match;  /* if non-NULL, will override any possible words */
     size_t completion_start_index;
     tokens_st * tokens; 
+    char const * line; /* The line the token spans refer to. */
 
     completion_context_st public_context;
 }; 
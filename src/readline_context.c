@@ -11,6 +11,8 @@
 #include <unistd.h>
 #include <string.h>
 
+#define DEFAULT_UNDO_LIMIT 4096
+
 static readline_st * readline_context_alloc(void)
 {
     readline_st * readline_ctx;
@@ -23,9 +25,14 @@ static readline_st * readline_context_alloc(void)
 static void readline_context_free(readline_st * const readline_ctx)
 {
     FREE_CONST(readline_ctx->field_separators);
+    FREE_CONST(readline_ctx->word_characters);
+    FREE_CONST(readline_ctx->continuation_prompt);
+    rows_teardown(&readline_ctx->rows);
+    arena_teardown(&readline_ctx->arena);
     line_context_teardown(&readline_ctx->line_context);
+    output_queue_teardown(&readline_ctx->output_queue);
     history_free(readline_ctx->history);
-    free_saved_string(&readline_ctx->saved_line);
+    saved_line_free(&readline_ctx->saved_line);
     free(readline_ctx);
 }
 
@@ -35,6 +42,41 @@ void toggle_insert_mode(readline_st * const readline_ctx)
     /* TODO - Change the cursor shape according to current mode. */
 }
 
+/* The state a context starts each session in. Used both for new 
+ * contexts and for those being reset. 
+ */
+static void readline_context_set_defaults(readline_st * const readline_ctx, 
+                                          void * const user_context, 
+                                          int const input_fd, 
+                                          int const output_fd)
+{
+    readline_ctx->insert_mode = true;
+
+    readline_ctx->user_context = user_context;
+    readline_ctx->out_fd = output_fd;
+    readline_ctx->in_fd = input_fd;
+    readline_ctx->non_blocking = false;
+    readline_ctx->waiting_for_output = false;
+    input_buffer_init(&readline_ctx->input_buffer);
+    readline_ctx->telnet_enabled = false;
+    readline_ctx->maximum_seconds_to_wait_for_char = 0;
+    readline_ctx->maximum_line_length = 0;
+    readline_ctx->mask_character = '\0';
+    readline_ctx->key_count = 0;
+    kill_ring_init(&readline_ctx->kill_ring);
+    readline_ctx->yank_age = 0;
+    readline_ctx->yanked_length = 0;
+    readline_ctx->yank_key_count = 0;
+    readline_ctx->continuation_callback = NULL;
+    readline_ctx->current_row = 0;
+    readline_ctx->first_row_prompt = NULL;
+    word_class_init(&readline_ctx->line_context.word_class, NULL, NULL);
+    token_class_init(&readline_ctx->line_context.token_class, NULL);
+    readline_ctx->is_a_terminal = isatty(readline_ctx->in_fd);
+    readline_ctx->history_enabled = true;
+    readline_ctx->check_timeout_before_any_chars_read = true;
+}
+
 readline_st * readline_context_create(void * const user_context, 
                                       completion_callback_fn const completion_callback,
                                       help_callback_fn const help_callback,
@@ -50,23 +92,56 @@ readline_st * readline_context_create(void * const user_context,
     {
         goto done;
     }
-    readline_ctx->insert_mode = true;
-
-    readline_ctx->user_context = user_context;
     readline_ctx->completion_callback = completion_callback;
     readline_ctx->help_callback = help_callback;
     readline_ctx->help_key = help_key;
-    readline_ctx->out_fd = output_fd;
-    readline_ctx->in_fd = input_fd;
-    readline_ctx->is_a_terminal = isatty(readline_ctx->in_fd);
+    output_queue_init(&readline_ctx->output_queue, output_fd);
+    undo_log_init(&readline_ctx->line_context.undo_log, DEFAULT_UNDO_LIMIT);
+    rows_init(&readline_ctx->rows);
+    arena_init(&readline_ctx->arena);
+    tokens_init(&readline_ctx->line_context.tokens);
     readline_ctx->history = history_alloc(history_size);
-    readline_ctx->history_enabled = true;
-    readline_ctx->check_timeout_before_any_chars_read = true;
+    readline_context_set_defaults(readline_ctx, user_context, input_fd, output_fd);
 
 done:
     return readline_ctx;
 }
 
+/* Returns the context to the state it was in when created, but 
+ * for a new session on different file descriptors. The completion 
+ * and help callbacks and the history size are unchanged, and the 
+ * memory held by the context is kept for the new session. 
+ */
+void readline_context_reset(readline_st * const readline_ctx, 
+                            void * const user_context, 
+                            int const input_fd, 
+                            int const output_fd)
+{
+    if (readline_ctx != NULL)
+    {
+        if (readline_ctx->terminal_was_modified)
+        {
+            terminal_restore(&readline_ctx->previous_terminal_settings);
+            readline_ctx->terminal_was_modified = false;
+        }
+        FREE_CONST(readline_ctx->field_separators);
+        readline_ctx->field_separators = NULL;
+        FREE_CONST(readline_ctx->word_characters);
+        readline_ctx->word_characters = NULL;
+        FREE_CONST(readline_ctx->continuation_prompt);
+        readline_ctx->continuation_prompt = NULL;
+
+        output_queue_reset(&readline_ctx->output_queue, output_fd);
+        undo_log_set_maximum_size(&readline_ctx->line_context.undo_log, DEFAULT_UNDO_LIMIT);
+        rows_clear(&readline_ctx->rows);
+        arena_reset(&readline_ctx->arena);
+        tokens_clear(&readline_ctx->line_context.tokens);
+        saved_line_clear(&readline_ctx->saved_line);
+        history_clear(readline_ctx->history);
+        readline_context_set_defaults(readline_ctx, user_context, input_fd, output_fd);
+    }
+}
+
 void readline_context_destroy(readline_st * const readline_ctx)
 {
     if (readline_ctx != NULL)
@@ -126,6 +201,31 @@ void readline_set_field_separators(readline_st * const readline_ctx, char const
         {
             readline_ctx->field_separators = NULL;
         }
+        word_class_init(&readline_ctx->line_context.word_class, 
+                        readline_ctx->word_characters, 
+                        readline_ctx->field_separators);
+        token_class_init(&readline_ctx->line_context.token_class, readline_ctx->field_separators);
+        /* The tokens must all be found again with the new separators. */
+        tokens_line_changed(&readline_ctx->line_context.tokens, 0);
+    }
+}
+
+void readline_set_word_characters(readline_st * const readline_ctx, char const * const word_characters)
+{
+    if (readline_ctx != NULL)
+    {
+        FREE_CONST(readline_ctx->word_characters);
+        if (word_characters != NULL)
+        {
+            readline_ctx->word_characters = strdup(word_characters);
+        }
+        else
+        {
+            readline_ctx->word_characters = NULL;
+        }
+        word_class_init(&readline_ctx->line_context.word_class, 
+                        readline_ctx->word_characters, 
+                        readline_ctx->field_separators);
     }
 }
 
@@ -148,6 +248,74 @@ size_t readline_set_maximum_line_length(readline_st * const readline_ctx, size_t
     return previous_maximum;
 }
 
+size_t readline_set_output_queue_limit(readline_st * const readline_ctx, size_t const limit)
+{
+    size_t previous_limit;
+
+    if (readline_ctx != NULL)
+    {
+        previous_limit = readline_ctx->output_queue.limit;
+
+        readline_ctx->output_queue.limit = limit;
+    }
+    else
+    {
+        previous_limit = 0;
+    }
+
+    return previous_limit;
+}
+
+size_t readline_set_undo_limit(readline_st * const readline_ctx, size_t const limit)
+{
+    size_t previous_limit;
+
+    if (readline_ctx != NULL)
+    {
+        previous_limit = undo_log_set_maximum_size(&readline_ctx->line_context.undo_log, limit);
+    }
+    else
+    {
+        previous_limit = 0;
+    }
+
+    return previous_limit;
+}
+
+void readline_set_continuation_callback(readline_st * const readline_ctx, 
+                                        continuation_callback_fn const continuation_callback, 
+                                        char const * const continuation_prompt)
+{
+    if (readline_ctx != NULL)
+    {
+        readline_ctx->continuation_callback = continuation_callback;
+        FREE_CONST(readline_ctx->continuation_prompt);
+        if (continuation_prompt != NULL)
+        {
+            readline_ctx->continuation_prompt = strdup(continuation_prompt);
+        }
+        else
+        {
+            readline_ctx->continuation_prompt = NULL;
+        }
+    }
+}
+
+void readline_enable_telnet(readline_st * const readline_ctx)
+{
+    if (readline_ctx != NULL && !readline_ctx->telnet_enabled)
+    {
+        readline_ctx->telnet_enabled = true;
+        /* The client is treated just like a terminal, except that 
+         * the terminal settings come from telnet negotiation. 
+         */
+        readline_ctx->is_a_terminal = true;
+        telnet_init(&readline_ctx->telnet);
+        readline_ctx->output_queue.telnet_encoding = true;
+        telnet_start_negotiation(&readline_ctx->output_queue);
+    }
+}
+
 void readline_set_initial_timeout_check(readline_st * const readline_ctx, bool const do_initial_check)
 {
     if (readline_ctx != NULL)
@@ -10,6 +10,12 @@
 #include "readline.h"
 #include "history.h"
 #include "terminal.h"
+#include "input_buffer.h"
+#include "output_queue.h"
+#include "telnet.h"
+#include "kill_ring.h"
+#include "rows.h"
+#include "arena.h"
 
 #include <stdbool.h>
 
@@ -21,27 +27,49 @@ struct readline_st
 {
     int out_fd; /* File descriptor to write to. */
     int in_fd; /* File descriptor to read from. */
+    bool non_blocking; /* true while a line started with readline_begin() is being edited. */
+    input_buffer_st input_buffer; /* Characters read from in_fd but not yet processed. */
+    output_queue_st output_queue; /* Output waiting to be written to out_fd. */
+    bool waiting_for_output; /* A key that writes straight to out_fd is waiting for the output queue to drain. */
+    bool telnet_enabled; /* in_fd and out_fd are a connection to a telnet client rather than a terminal. */
+    telnet_st telnet;
     unsigned int maximum_seconds_to_wait_for_char;
     bool check_timeout_before_any_chars_read; /* set to false if there is no timeout before the user starts entering characters. */
     size_t maximum_line_length;
 
     bool is_a_terminal;
     bool terminal_was_modified;
-    terminal_settings_st * previous_terminal_settings;
+    terminal_settings_st previous_terminal_settings;
 
     bool insert_mode; 
     int mask_character; /* if non-zero, the terminal writes out this character rather than the actual character. */
     char const * field_separators;
+    char const * word_characters; /* Characters other than letters and digits that are part of a word. */
 
     line_context_st line_context;
+    bool line_is_lent; /* The caller has been given a pointer to the line in line_context. */
+    unsigned long key_count; /* The number of keys handled so far. */
 
-    char const * saved_line;
+    kill_ring_st kill_ring; /* Text deleted by CTRL-K, CTRL-U, CTRL-W and ALT-D. */
+    size_t yank_age; /* How far back in the kill ring the text last yanked came from. */
+    size_t yanked_length;
+    unsigned long yank_key_count; /* key_count when text was last yanked. */
+
+    saved_line_st saved_line; /* The line being edited when the user started moving through the history. */
     bool history_enabled;
     history_st * history;
 
     void * user_context; /* user specific context passed back to the user when performing auto-complete or help */
     completion_callback_fn completion_callback;
     help_callback_fn help_callback;
+    continuation_callback_fn continuation_callback; /* If set, decides whether more lines of input are needed. */
+    char const * continuation_prompt;
+
+    arena_st arena; /* Temporary memory used while completing a word, giving help, etc. Reset once finished with. */
+
+    rows_st rows; /* The lines of input that needed more than one line. */
+    size_t current_row; /* The row being edited in line_context. */
+    char const * first_row_prompt;
     char help_key; /* If set, would usually be to '?'. Calls the help callback if that's not NULL. */
 };
 
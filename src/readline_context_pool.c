@@ -0,0 +1,124 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include "readline.h"
+
+#include <stdlib.h>
+
+/* Contexts that have been finished with are kept, up to a limit, 
+ * and handed out again after being reset, so that sessions that 
+ * come and go don't need a context to be created and destroyed 
+ * each time. 
+ */
+struct readline_context_pool_st
+{
+    completion_callback_fn completion_callback;
+    help_callback_fn help_callback;
+    char help_key;
+    size_t history_size;
+
+    readline_st * * idle_contexts;
+    size_t num_idle_contexts;
+    size_t maximum_idle_contexts;
+};
+
+readline_context_pool_st * readline_context_pool_create(size_t const maximum_idle_contexts, 
+                                                        completion_callback_fn const completion_callback, 
+                                                        help_callback_fn const help_callback, 
+                                                        char const help_key, 
+                                                        size_t const history_size)
+{
+    readline_context_pool_st * pool;
+
+    pool = calloc(1, sizeof *pool);
+    if (pool == NULL)
+    {
+        goto done;
+    }
+    if (maximum_idle_contexts > 0)
+    {
+        pool->idle_contexts = calloc(maximum_idle_contexts, sizeof *pool->idle_contexts);
+        if (pool->idle_contexts == NULL)
+        {
+            free(pool);
+            pool = NULL;
+            goto done;
+        }
+    }
+    pool->maximum_idle_contexts = maximum_idle_contexts;
+    pool->completion_callback = completion_callback;
+    pool->help_callback = help_callback;
+    pool->help_key = help_key;
+    pool->history_size = history_size;
+
+done:
+    return pool;
+}
+
+void readline_context_pool_destroy(readline_context_pool_st * const pool)
+{
+    if (pool != NULL)
+    {
+        size_t index;
+
+        for (index = 0; index < pool->num_idle_contexts; index++)
+        {
+            readline_context_destroy(pool->idle_contexts[index]);
+        }
+        free(pool->idle_contexts);
+        free(pool);
+    }
+}
+
+/* Returns an idle context if there is one, otherwise a new one. */
+readline_st * readline_context_pool_get(readline_context_pool_st * const pool, 
+                                        void * const user_context, 
+                                        int const input_fd, 
+                                        int const output_fd)
+{
+    readline_st * readline_ctx;
+
+    if (pool->num_idle_contexts > 0)
+    {
+        pool->num_idle_contexts--;
+        readline_ctx = pool->idle_contexts[pool->num_idle_contexts];
+        readline_context_reset(readline_ctx, user_context, input_fd, output_fd);
+    }
+    else
+    {
+        readline_ctx = readline_context_create(user_context, 
+                                               pool->completion_callback, 
+                                               pool->help_callback, 
+                                               pool->help_key, 
+                                               input_fd, 
+                                               output_fd, 
+                                               pool->history_size);
+    }
+
+    return readline_ctx;
+}
+
+/* Hand back a context from readline_context_pool_get(). It's 
+ * destroyed if the pool already holds as many idle contexts as 
+ * it is allowed. 
+ */
+void readline_context_pool_put(readline_context_pool_st * const pool, readline_st * const readline_ctx)
+{
+    if (readline_ctx == NULL)
+    {
+        goto done;
+    }
+    if (pool->num_idle_contexts == pool->maximum_idle_contexts)
+    {
+        readline_context_destroy(readline_ctx);
+        goto done;
+    }
+    pool->idle_contexts[pool->num_idle_contexts] = readline_ctx;
+    pool->num_idle_contexts++;
+
+done:
+    return;
+}
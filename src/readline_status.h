@@ -15,7 +15,8 @@ enum readline_status_t
     readline_status_continue,
     readline_status_ctrl_c,
     readline_status_timed_out,
-    readline_status_eof
+    readline_status_eof,
+    readline_status_would_block /* No more input is available without blocking. */
 }; 
 
 
@@ -0,0 +1,174 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include "rows.h"
+#include "utils.h"
+
+#include <stdlib.h>
+
+#define ROWS_MINIMUM_SIZE 4
+#define ROWS_INITIAL_TEXT_SIZE 160
+
+void rows_init(rows_st * const rows)
+{
+    rows->text.buffer = NULL;
+    rows->text.buffer_size = 0;
+    rows->text.gap_start = 0;
+    rows->text.gap_end = 0;
+    rows->rows = NULL;
+    rows->rows_size = 0;
+    rows->num_rows = 0;
+}
+
+void rows_teardown(rows_st * const rows)
+{
+    gap_buffer_teardown(&rows->text);
+    free(rows->rows);
+    rows_init(rows);
+}
+
+/* Remove all the rows, keeping the memory for the next block. */
+void rows_clear(rows_st * const rows)
+{
+    if (rows->text.buffer != NULL)
+    {
+        gap_buffer_clear(&rows->text);
+    }
+    rows->num_rows = 0;
+}
+
+void rows_trim(rows_st * const rows, size_t const maximum_idle_size)
+{
+    rows_clear(rows);
+    if (rows->text.buffer != NULL)
+    {
+        gap_buffer_trim(&rows->text, maximum_idle_size);
+    }
+    if (rows->rows_size * sizeof *rows->rows > maximum_idle_size)
+    {
+        free(rows->rows);
+        rows->rows = NULL;
+        rows->rows_size = 0;
+    }
+}
+
+size_t rows_get_num_rows(rows_st const * const rows)
+{
+    return rows->num_rows;
+}
+
+/* Returns NULL if there is no such row. */
+row_st * rows_get_row(rows_st * const rows, size_t const index)
+{
+    return index < rows->num_rows ? &rows->rows[index] : NULL;
+}
+
+/* Add a row to the end of the block. */
+bool rows_append(rows_st * const rows, char const * const text, size_t const length)
+{
+    bool appended;
+    size_t offset;
+    row_st * row;
+
+    if (rows->text.buffer == NULL && !gap_buffer_init(&rows->text, ROWS_INITIAL_TEXT_SIZE))
+    {
+        appended = false;
+        goto done;
+    }
+    if (rows->num_rows == rows->rows_size)
+    {
+        size_t const new_rows_size = MAX(rows->rows_size * 2, ROWS_MINIMUM_SIZE);
+        row_st * const new_rows = realloc(rows->rows, new_rows_size * sizeof *new_rows);
+
+        if (new_rows == NULL)
+        {
+            appended = false;
+            goto done;
+        }
+        rows->rows = new_rows;
+        rows->rows_size = new_rows_size;
+    }
+
+    offset = gap_buffer_get_length(&rows->text);
+    if (rows->num_rows > 0)
+    {
+        /* Separate this row from the one before. */
+        if (!gap_buffer_insert(&rows->text, offset, "\n", 1))
+        {
+            appended = false;
+            goto done;
+        }
+        offset++;
+    }
+    if (!gap_buffer_insert(&rows->text, offset, text, length))
+    {
+        appended = false;
+        goto done;
+    }
+    row = &rows->rows[rows->num_rows];
+    row->offset = offset;
+    row->length = length;
+    row->screen_lines = 1;
+    rows->num_rows++;
+    appended = true;
+
+done:
+    return appended;
+}
+
+/* Replace the text of a row. Only the text of the rows that 
+ * follow needs to move, and that is done by moving the gap. 
+ */
+bool rows_set_text(rows_st * const rows, size_t const index, char const * const text, size_t length)
+{
+    bool text_set;
+    row_st * const row = rows_get_row(rows, index);
+    size_t following_index;
+
+    if (row == NULL)
+    {
+        text_set = false;
+        goto done;
+    }
+    gap_buffer_delete(&rows->text, row->offset, row->length);
+    if (!gap_buffer_insert(&rows->text, row->offset, text, length))
+    {
+        /* The row is now empty. */
+        length = 0;
+        text_set = false;
+    }
+    else
+    {
+        text_set = true;
+    }
+    for (following_index = index + 1; following_index < rows->num_rows; following_index++)
+    {
+        rows->rows[following_index].offset = rows->rows[following_index].offset - row->length + length;
+    }
+    row->length = length;
+
+done:
+    return text_set;
+}
+
+/* Returns the text of a row. The text is followed by the '\n' 
+ * before the next row, or by a NUL for the last row, so 
+ * row->length characters should be used. 
+ */
+char const * rows_get_text(rows_st * const rows, size_t const index)
+{
+    row_st const * const row = rows_get_row(rows, index);
+
+    return row != NULL ? gap_buffer_get_string_from(&rows->text, row->offset) : NULL;
+}
+
+/* Returns the whole block as a NUL terminated string, with a 
+ * '\n' between each row. 
+ */
+char const * rows_get_all_text(rows_st * const rows)
+{
+    return rows->text.buffer != NULL ? gap_buffer_get_string(&rows->text) : "";
+}
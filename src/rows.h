@@ -0,0 +1,50 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#ifndef __ROWS_H__
+#define __ROWS_H__
+
+#include "gap_buffer.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct row_st row_st;
+struct row_st
+{
+    size_t offset; /* Where the row starts in the text. */
+    size_t length;
+    size_t screen_lines; /* The number of terminal lines the row was last drawn on. */
+};
+
+typedef struct rows_st rows_st;
+/* The rows of a block of input that is entered over several 
+ * lines. The text of all the rows is kept in a single gap buffer 
+ * with a '\n' between each row, so the whole block is available 
+ * as one string without any copying. The memory is kept between 
+ * blocks. 
+ */
+struct rows_st
+{
+    gap_buffer_st text;
+    row_st * rows;
+    size_t rows_size; /* The number of rows there is space for. */
+    size_t num_rows;
+};
+
+void rows_init(rows_st * const rows);
+void rows_teardown(rows_st * const rows);
+void rows_clear(rows_st * const rows);
+void rows_trim(rows_st * const rows, size_t const maximum_idle_size);
+
+size_t rows_get_num_rows(rows_st const * const rows);
+row_st * rows_get_row(rows_st * const rows, size_t const index);
+bool rows_append(rows_st * const rows, char const * const text, size_t const length);
+bool rows_set_text(rows_st * const rows, size_t const index, char const * const text, size_t const length);
+char const * rows_get_text(rows_st * const rows, size_t const index);
+char const * rows_get_all_text(rows_st * const rows);
+
+#endif /* __ROWS_H__ */
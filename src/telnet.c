@@ -0,0 +1,241 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include "telnet.h"
+#include "readline.h"
+
+/* Commands (RFC 854). */
+#define TELNET_SE 240
+#define TELNET_IP 244
+#define TELNET_SB 250
+#define TELNET_WILL 251
+#define TELNET_WONT 252
+#define TELNET_DO 253
+#define TELNET_DONT 254
+#define TELNET_IAC 255
+
+/* Options. */
+#define TELNET_OPTION_ECHO 1 /* RFC 857 */
+#define TELNET_OPTION_SGA 3 /* RFC 858 */
+#define TELNET_OPTION_NAWS 31 /* RFC 1073 */
+
+static void send_command(output_queue_st * const output, unsigned char const command, unsigned char const option)
+{
+    char const command_sequence[] = { (char)TELNET_IAC, (char)command, (char)option };
+
+    /* Written directly so that the IAC isn't escaped. */
+    output_queue_write_raw(output, command_sequence, sizeof command_sequence);
+}
+
+void telnet_init(telnet_st * const telnet)
+{
+    telnet->state = telnet_state_data;
+    telnet->subnegotiation_length = 0;
+    telnet->client_will_naws = false;
+    telnet->client_will_sga = false;
+    telnet->width = 0;
+    telnet->height = 0;
+    telnet->window_size_changed = false;
+}
+
+/* The server does the echoing and works a character at a time, 
+ * and would like to be told the size of the client's window. 
+ */
+void telnet_start_negotiation(output_queue_st * const output)
+{
+    send_command(output, TELNET_WILL, TELNET_OPTION_ECHO);
+    send_command(output, TELNET_WILL, TELNET_OPTION_SGA);
+    send_command(output, TELNET_DO, TELNET_OPTION_NAWS);
+}
+
+static void handle_option(telnet_st * const telnet, unsigned char const option, output_queue_st * const output)
+{
+    switch (telnet->command)
+    {
+        case TELNET_WILL:
+            if (option == TELNET_OPTION_NAWS)
+            {
+                /* The reply to our DO. */
+                telnet->client_will_naws = true;
+            }
+            else if (option == TELNET_OPTION_SGA)
+            {
+                if (!telnet->client_will_sga)
+                {
+                    telnet->client_will_sga = true;
+                    send_command(output, TELNET_DO, option);
+                }
+            }
+            else
+            {
+                send_command(output, TELNET_DONT, option);
+            }
+            break;
+        case TELNET_DO:
+            if (option != TELNET_OPTION_ECHO && option != TELNET_OPTION_SGA)
+            {
+                send_command(output, TELNET_WONT, option);
+            }
+            break;
+        case TELNET_WONT:
+            if (option == TELNET_OPTION_NAWS)
+            {
+                telnet->client_will_naws = false;
+            }
+            break;
+        case TELNET_DONT:
+        default:
+            /* Nothing can be done about a client that won't let 
+             * the server echo, so just carry on. 
+             */
+            break;
+    }
+}
+
+static void handle_subnegotiation(telnet_st * const telnet)
+{
+    if (telnet->subnegotiation_option == TELNET_OPTION_NAWS && telnet->subnegotiation_length == 4)
+    {
+        size_t const width = (telnet->subnegotiation[0] << 8) | telnet->subnegotiation[1];
+        size_t const height = (telnet->subnegotiation[2] << 8) | telnet->subnegotiation[3];
+
+        /* 0 means the client doesn't know. */
+        if (width > 0)
+        {
+            telnet->width = width;
+            telnet->height = height;
+            telnet->window_size_changed = true;
+        }
+    }
+}
+
+static void add_subnegotiation_byte(telnet_st * const telnet, unsigned char const ch)
+{
+    if (telnet->subnegotiation_length < sizeof telnet->subnegotiation)
+    {
+        telnet->subnegotiation[telnet->subnegotiation_length] = ch;
+    }
+    /* Still counted so that oversized parameters are ignored. */
+    telnet->subnegotiation_length++;
+}
+
+/* Returns the updated write index. */
+static size_t handle_data_character(telnet_st * const telnet, 
+                                    unsigned char const ch, 
+                                    char * const data, 
+                                    size_t write_index)
+{
+    if (ch == TELNET_IAC)
+    {
+        telnet->state = telnet_state_iac;
+    }
+    else if (ch == '\r')
+    {
+        data[write_index++] = '\n';
+        telnet->state = telnet_state_cr;
+    }
+    else
+    {
+        data[write_index++] = ch;
+    }
+
+    return write_index;
+}
+
+/* Strip the telnet protocol from the data received from the 
+ * client, leaving only the characters typed by the user, and 
+ * queue any replies required. 
+ * The data is filtered in place. Returns the number of 
+ * characters left. 
+ * Carriage returns sent by the client (as CR LF or CR NUL) are 
+ * converted to a single '\n'. 
+ */
+size_t telnet_filter_input(telnet_st * const telnet, 
+                           char * const data, 
+                           size_t const length, 
+                           output_queue_st * const output)
+{
+    size_t read_index;
+    size_t write_index = 0;
+
+    for (read_index = 0; read_index < length; read_index++)
+    {
+        unsigned char const ch = data[read_index];
+
+        switch (telnet->state)
+        {
+            case telnet_state_cr:
+                telnet->state = telnet_state_data;
+                if (ch != '\n' && ch != '\0')
+                {
+                    write_index = handle_data_character(telnet, ch, data, write_index);
+                }
+                break;
+            case telnet_state_data:
+                write_index = handle_data_character(telnet, ch, data, write_index);
+                break;
+            case telnet_state_iac:
+                telnet->state = telnet_state_data;
+                switch (ch)
+                {
+                    case TELNET_IAC: /* An escaped 255. */
+                        data[write_index++] = ch;
+                        break;
+                    case TELNET_IP:
+                        data[write_index++] = CTL('C');
+                        break;
+                    case TELNET_WILL:
+                    case TELNET_WONT:
+                    case TELNET_DO:
+                    case TELNET_DONT:
+                        telnet->command = ch;
+                        telnet->state = telnet_state_option;
+                        break;
+                    case TELNET_SB:
+                        telnet->state = telnet_state_subnegotiation_option;
+                        break;
+                    default:
+                        /* Other commands are of no interest. */
+                        break;
+                }
+                break;
+            case telnet_state_option:
+                handle_option(telnet, ch, output);
+                telnet->state = telnet_state_data;
+                break;
+            case telnet_state_subnegotiation_option:
+                telnet->subnegotiation_option = ch;
+                telnet->subnegotiation_length = 0;
+                telnet->state = telnet_state_subnegotiation;
+                break;
+            case telnet_state_subnegotiation:
+                if (ch == TELNET_IAC)
+                {
+                    telnet->state = telnet_state_subnegotiation_iac;
+                }
+                else
+                {
+                    add_subnegotiation_byte(telnet, ch);
+                }
+                break;
+            case telnet_state_subnegotiation_iac:
+                if (ch == TELNET_SE)
+                {
+                    handle_subnegotiation(telnet);
+                    telnet->state = telnet_state_data;
+                }
+                else
+                {
+                    /* IAC IAC is an escaped 255 in the parameters. */
+                    add_subnegotiation_byte(telnet, ch);
+                    telnet->state = telnet_state_subnegotiation;
+                }
+                break;
+        }
+    }
+
+    return write_index;
+}
@@ -0,0 +1,51 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#ifndef __TELNET_H__
+#define __TELNET_H__
+
+#include "output_queue.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum telnet_state_t
+{
+    telnet_state_data,
+    telnet_state_iac, /* Got IAC. */
+    telnet_state_option, /* Got IAC WILL/WONT/DO/DONT. */
+    telnet_state_subnegotiation_option, /* Got IAC SB. */
+    telnet_state_subnegotiation, /* Got IAC SB <option>. */
+    telnet_state_subnegotiation_iac, /* Got IAC within a subnegotiation. */
+    telnet_state_cr /* Got CR. Any LF or NUL following it is dropped. */
+} telnet_state_t;
+
+typedef struct telnet_st telnet_st;
+/* Protocol state for a session talking directly to a telnet 
+ * client rather than a terminal. 
+ */
+struct telnet_st
+{
+    telnet_state_t state;
+    unsigned char command; /* The WILL/WONT/DO/DONT being received. */
+    unsigned char subnegotiation_option;
+    unsigned char subnegotiation[4]; /* Enough for the NAWS parameters. */
+    size_t subnegotiation_length;
+    bool client_will_naws;
+    bool client_will_sga;
+    size_t width; /* As reported by NAWS. 0 if not known. */
+    size_t height;
+    bool window_size_changed; /* Set when a NAWS update arrives. Cleared by the reader. */
+};
+
+void telnet_init(telnet_st * const telnet);
+void telnet_start_negotiation(output_queue_st * const output);
+size_t telnet_filter_input(telnet_st * const telnet, 
+                           char * const data, 
+                           size_t const length, 
+                           output_queue_st * const output);
+
+#endif /* __TELNET_H__ */
@@ -11,36 +11,29 @@
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/ioctl.h>
 #include <sys/select.h>
 
 #define DEFAULT_SCREEN_COLUMNS 80
 
-typedef struct terminal_settings_st terminal_settings_st;
-struct terminal_settings_st
+void tty_put(output_queue_st * const output, char const ch)
 {
-    struct termios settings;
-};
+    output_queue_put(output, ch);
+}
 
-int tty_put(int const out_fd, char const ch)
+void tty_puts(output_queue_st * const output, char const * const string)
 {
-    return write(out_fd, &ch, sizeof ch);
+    output_queue_write(output, string, strlen(string));
 }
 
-void tty_puts(int const out_fd, char const * const string)
+void tty_write(output_queue_st * const output, char const * const data, size_t const length)
 {
-    char const * p = string;
-
-    while (*p != '\0')
-    {
-        char const char_to_put = *p;
-
-        tty_put(out_fd, char_to_put);
-        p++;
-    }
+    output_queue_write(output, data, length);
 }
 
-static bool wait_for_file_to_be_readable(int const fd, unsigned int const max_seconds_to_wait)
+/* A max_seconds_to_wait of 0 waits indefinitely. */
+bool tty_wait_until_readable(int const fd, unsigned int const max_seconds_to_wait)
 {
     int select_result;
     fd_set file_descriptor_set;
@@ -94,7 +87,7 @@ tty_get_result_t tty_get(int const in_fd, unsigned int const maximum_seconds_to_
 
     if (maximum_seconds_to_wait > 0)
     {
-        if (!wait_for_file_to_be_readable(in_fd, maximum_seconds_to_wait))
+        if (!tty_wait_until_readable(in_fd, maximum_seconds_to_wait))
         {
             read_result = tty_get_result_timeout;
             goto done;
@@ -170,20 +163,20 @@ static int setattr(int fd, int opt, const struct termios * arg)
     return result;
 }
 
-terminal_settings_st * terminal_prepare(void)
+/* Returns false if the terminal settings couldn't be read, in 
+ * which case there is nothing to restore. 
+ */
+bool terminal_prepare(int const fd, terminal_settings_st * const previous_terminal_settings)
 {
-    terminal_settings_st * previous_terminal_settings;
+    bool prepared;
     struct termios new_terminal_settings;
 
-    previous_terminal_settings = malloc(sizeof *previous_terminal_settings);
-    if (previous_terminal_settings == NULL)
-    {
-        goto done;
-    }
-
-    if (-1 == getattr(0, &previous_terminal_settings->settings))
+    previous_terminal_settings->fd = fd;
+    if (-1 == getattr(fd, &previous_terminal_settings->settings))
     {
         perror("Failed tcgetattr()");
+        prepared = false;
+        goto done;
     }
 
     /* Base the new settings off the original settings. */
@@ -195,24 +188,21 @@ terminal_settings_st * terminal_prepare(void)
     new_terminal_settings.c_cc[VMIN] = 1; /* one char minimum */
     new_terminal_settings.c_cc[VTIME] = 0; /* no timeout */
 
-    if (-1 == setattr(0, TCSADRAIN, &new_terminal_settings))
+    if (-1 == setattr(fd, TCSADRAIN, &new_terminal_settings))
     {
         perror("Failed tcsetattr(TCSADRAIN)");
     }
+    prepared = true;
 
 done:
-    return previous_terminal_settings;
+    return prepared;
 }
 
-void terminal_restore(terminal_settings_st * const previous_terminal_settings)
+void terminal_restore(terminal_settings_st const * const previous_terminal_settings)
 {
-    if (previous_terminal_settings != NULL)
+    if (-1 == setattr(previous_terminal_settings->fd, TCSADRAIN, &previous_terminal_settings->settings))
     {
-        if (-1 == setattr(0, TCSADRAIN, &previous_terminal_settings->settings))
-        {
-            perror("Failed tcsetattr(TCSADRAIN)");
-        }
-        free(previous_terminal_settings);
+        perror("Failed tcsetattr(TCSADRAIN)");
     }
 }
 
@@ -233,7 +223,7 @@ size_t terminal_get_width(int const out_fd)
     return width;
 }
 
-static bool move_physical_cursor(int const out_fd, size_t const amount_to_move, char const direction)
+static bool move_physical_cursor(output_queue_st * const output, size_t const amount_to_move, char const direction)
 {
     bool cursor_moved;
 
@@ -243,35 +233,34 @@ static bool move_physical_cursor(int const out_fd, size_t const amount_to_move,
 
         snprintf(buffer, sizeof buffer, "\033[%zu%c", amount_to_move, direction);
 
-        // TODO: check for write error
-        tty_puts(out_fd, buffer);
+        tty_puts(output, buffer);
     }
     cursor_moved = true;
 
     return cursor_moved;
 }
 
-bool terminal_move_physical_cursor_up(int const out_fd, size_t const rows)
+bool terminal_move_physical_cursor_up(output_queue_st * const output, size_t const rows)
 {
-    return move_physical_cursor(out_fd, rows, 'A');
+    return move_physical_cursor(output, rows, 'A');
 }
 
-bool terminal_move_physical_cursor_down(int const out_fd, size_t const rows)
+bool terminal_move_physical_cursor_down(output_queue_st * const output, size_t const rows)
 {
-    return move_physical_cursor(out_fd, rows, 'B');
+    return move_physical_cursor(output, rows, 'B');
 }
 
-bool terminal_move_physical_cursor_right(int const out_fd, size_t const columns)
+bool terminal_move_physical_cursor_right(output_queue_st * const output, size_t const columns)
 {
-    return move_physical_cursor(out_fd, columns, 'C');
+    return move_physical_cursor(output, columns, 'C');
 }
 
-bool terminal_move_physical_cursor_left(int const out_fd, size_t const columns)
+bool terminal_move_physical_cursor_left(output_queue_st * const output, size_t const columns)
 {
-    return move_physical_cursor(out_fd, columns, 'D');
+    return move_physical_cursor(output, columns, 'D');
 }
 
-void terminal_delete_to_end_of_line(int const out_fd)
+void terminal_delete_to_end_of_line(output_queue_st * const output)
 {
-    tty_puts(out_fd, "\033[K");
+    tty_puts(output, "\033[K");
 }
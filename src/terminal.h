@@ -9,6 +9,9 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <termios.h>
+
+#include "output_queue.h"
 
 typedef enum tty_get_result_t
 {
@@ -18,21 +21,28 @@ typedef enum tty_get_result_t
 } tty_get_result_t;
 
 typedef struct terminal_settings_st terminal_settings_st;
-
-int tty_put(int const out_fd, char const c);
-void tty_puts(int const out_fd, char const * const string);
+struct terminal_settings_st
+{
+    int fd; /* The terminal the settings were read from. */
+    struct termios settings;
+};
+
+void tty_put(output_queue_st * const output, char const c);
+void tty_puts(output_queue_st * const output, char const * const string);
+void tty_write(output_queue_st * const output, char const * const data, size_t const length);
+bool tty_wait_until_readable(int const fd, unsigned int const max_seconds_to_wait);
 tty_get_result_t tty_get(int const in_fd, unsigned int const maximum_seconds_to_wait, int * const character_read);
 
-terminal_settings_st * terminal_prepare(void);
-void terminal_restore(terminal_settings_st * const previous_terminal_settings);
+bool terminal_prepare(int const fd, terminal_settings_st * const previous_terminal_settings);
+void terminal_restore(terminal_settings_st const * const previous_terminal_settings);
 
 size_t terminal_get_width(int const out_fd);
 
-bool terminal_move_physical_cursor_right(int const out_fd, size_t const columns);
-bool terminal_move_physical_cursor_left(int const out_fd, size_t const columns);
-bool terminal_move_physical_cursor_up(int const out_fd, size_t const rows);
-bool terminal_move_physical_cursor_down(int const out_fd, size_t const rows);
+bool terminal_move_physical_cursor_right(output_queue_st * const output, size_t const columns);
+bool terminal_move_physical_cursor_left(output_queue_st * const output, size_t const columns);
+bool terminal_move_physical_cursor_up(output_queue_st * const output, size_t const rows);
+bool terminal_move_physical_cursor_down(output_queue_st * const output, size_t const rows);
 
-void terminal_delete_to_end_of_line(int const out_fd);
+void terminal_delete_to_end_of_line(output_queue_st * const output);
 
 #endif /* __TERMINAL_H__ */
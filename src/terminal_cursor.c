@@ -8,20 +8,22 @@
 #include "terminal.h"
 #include "utils.h"
 
+#include <string.h>
+
 /* Write a character to the terminal, keeping note of which row 
  * and column the cursor is on. 
  */
 void terminal_put(terminal_cursor_st * const terminal_cursor, 
                   char const ch, 
-                  int const terminal_fd,
+                  output_queue_st * const output,
                   size_t const terminal_width)
 {
-    tty_put(terminal_fd, ch);
+    tty_put(output, ch);
     terminal_cursor->column++;
 
     if (terminal_cursor->column == terminal_width)
     {
-        tty_put(terminal_fd, '\n');
+        tty_put(output, '\n');
         /* The cursor will now be at the start of the next line, so 
          * update our variables to match. 
          */
@@ -35,29 +37,38 @@ void terminal_put(terminal_cursor_st * const terminal_cursor,
     }
 }
 
-void terminal_puts(terminal_cursor_st * const terminal_cursor, 
-                   char const * const string, 
-                   char const mask_character,
-                   int const terminal_fd,
-                   size_t const terminal_width)
+void terminal_write(terminal_cursor_st * const terminal_cursor, 
+                    char const * const data, 
+                    size_t const length, 
+                    char const mask_character,
+                    output_queue_st * const output,
+                    size_t const terminal_width)
 {
-    char const * p = string;
+    size_t index;
 
-    while (*p != '\0')
+    for (index = 0; index < length; index++)
     {
-        char const char_to_put = (mask_character != '\0') ? mask_character : *p;
+        char const char_to_put = (mask_character != '\0') ? mask_character : data[index];
 
         terminal_put(terminal_cursor, 
                      char_to_put, 
-                     terminal_fd,
+                     output,
                      terminal_width);
-        p++;
     }
 }
 
+void terminal_puts(terminal_cursor_st * const terminal_cursor, 
+                   char const * const string, 
+                   char const mask_character,
+                   output_queue_st * const output,
+                   size_t const terminal_width)
+{
+    terminal_write(terminal_cursor, string, strlen(string), mask_character, output, terminal_width);
+}
+
 void terminal_move_cursor_right_n_columns(terminal_cursor_st * const terminal_cursor, 
                                           size_t const columns,
-                                          int const terminal_fd,
+                                          output_queue_st * const output,
                                           size_t const terminal_width)
 {
     size_t const original_terminal_cursor_index = terminal_cursor->column;
@@ -76,26 +87,26 @@ void terminal_move_cursor_right_n_columns(terminal_cursor_st * const terminal_cu
      */
     if (rows_to_move > 0)
     {
-        terminal_move_physical_cursor_down(terminal_fd, rows_to_move);
+        terminal_move_physical_cursor_down(output, rows_to_move);
     }
     /* Update the physical cursor column */
     if (new_terminal_cursor_column > original_terminal_cursor_index)
     {
         size_t const chars_to_move = new_terminal_cursor_column - original_terminal_cursor_index;
 
-        terminal_move_physical_cursor_right(terminal_fd, chars_to_move);
+        terminal_move_physical_cursor_right(output, chars_to_move);
     }
     else if (new_terminal_cursor_column < original_terminal_cursor_index)
     {
         size_t const chars_to_move = original_terminal_cursor_index - new_terminal_cursor_column;
 
-        terminal_move_physical_cursor_left(terminal_fd, chars_to_move);
+        terminal_move_physical_cursor_left(output, chars_to_move);
     }
 }
 
 void terminal_move_cursor_left_n_columns(terminal_cursor_st * const terminal_cursor, 
                                          size_t const columns,
-                                         int const terminal_fd,
+                                         output_queue_st * const output,
                                          size_t const terminal_width)
 {
     size_t const original_screen_cursor_column = terminal_cursor->column;
@@ -125,50 +136,50 @@ void terminal_move_cursor_left_n_columns(terminal_cursor_st * const terminal_cur
      */
     if (rows_to_move > 0)
     {
-        terminal_move_physical_cursor_up(terminal_fd, rows_to_move);
+        terminal_move_physical_cursor_up(output, rows_to_move);
     }
     /* Update the physical cursor column */
     if (new_screen_cursor_index > original_screen_cursor_column)
     {
         size_t const chars_to_move = new_screen_cursor_index - original_screen_cursor_column;
 
-        terminal_move_physical_cursor_right(terminal_fd, chars_to_move);
+        terminal_move_physical_cursor_right(output, chars_to_move);
     }
     else if (new_screen_cursor_index < original_screen_cursor_column)
     {
         size_t const chars_to_move = original_screen_cursor_column - new_screen_cursor_index;
 
-        terminal_move_physical_cursor_left(terminal_fd, chars_to_move);
+        terminal_move_physical_cursor_left(output, chars_to_move);
     }
 }
 
-void terminal_delete_line_from_cursor_to_end(terminal_cursor_st * const terminal_cursor, int const terminal_fd)
+void terminal_delete_line_from_cursor_to_end(terminal_cursor_st * const terminal_cursor, output_queue_st * const output)
 {
     size_t screen_cursor_row;
     size_t rows_to_beginning_of_line = terminal_cursor->column;
     size_t rows_to_move_up;
     size_t columns_to_move_right;
 
-    terminal_delete_to_end_of_line(terminal_fd);
+    terminal_delete_to_end_of_line(output);
 
     /* Must also remove any other lines below this one. */
     for (screen_cursor_row = (terminal_cursor->row + 1);
          screen_cursor_row < terminal_cursor->num_rows;
          screen_cursor_row++)
     {
-        terminal_move_physical_cursor_down(terminal_fd, 1);
+        terminal_move_physical_cursor_down(output, 1);
         if (rows_to_beginning_of_line > 0)
         {
-            terminal_move_physical_cursor_left(terminal_fd, rows_to_beginning_of_line);
+            terminal_move_physical_cursor_left(output, rows_to_beginning_of_line);
             rows_to_beginning_of_line = 0;
         }
-        terminal_delete_to_end_of_line(terminal_fd);
+        terminal_delete_to_end_of_line(output);
     }
     rows_to_move_up = terminal_cursor->num_rows - terminal_cursor->row - 1;
     columns_to_move_right = terminal_cursor->column - rows_to_beginning_of_line;
 
-    terminal_move_physical_cursor_up(terminal_fd, rows_to_move_up);
-    terminal_move_physical_cursor_right(terminal_fd, columns_to_move_right);
+    terminal_move_physical_cursor_up(output, rows_to_move_up);
+    terminal_move_physical_cursor_right(output, columns_to_move_right);
 }
 
 void terminal_cursor_reset(terminal_cursor_st * const terminal_cursor)
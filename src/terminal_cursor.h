@@ -11,22 +11,28 @@
 
 void terminal_put(terminal_cursor_st * const terminal_cursor, 
                   char const ch, 
-                  int const terminal_fd,
+                  output_queue_st * const output,
                   size_t const terminal_width);
+void terminal_write(terminal_cursor_st * const terminal_cursor, 
+                    char const * const data, 
+                    size_t const length, 
+                    char const mask_character,
+                    output_queue_st * const output,
+                    size_t const terminal_width);
 void terminal_puts(terminal_cursor_st * const terminal_cursor, 
                    char const * const string, 
                    char const mask_character,
-                   int const terminal_fd,
+                   output_queue_st * const output,
                    size_t const terminal_width);
 void terminal_move_cursor_right_n_columns(terminal_cursor_st * const terminal_cursor, 
                                           size_t const columns,
-                                          int const terminal_fd,
+                                          output_queue_st * const output,
                                           size_t const terminal_width);
 void terminal_move_cursor_left_n_columns(terminal_cursor_st * const terminal_cursor, 
                                          size_t const columns,
-                                         int const terminal_fd,
+                                         output_queue_st * const output,
                                          size_t const terminal_width);
-void terminal_delete_line_from_cursor_to_end(terminal_cursor_st * const terminal_cursor, int const terminal_fd);
+void terminal_delete_line_from_cursor_to_end(terminal_cursor_st * const terminal_cursor, output_queue_st * const output);
 void terminal_cursor_init(terminal_cursor_st * const terminal_cursor);
 void terminal_cursor_reset(terminal_cursor_st * const terminal_cursor);
 
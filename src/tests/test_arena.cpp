@@ -0,0 +1,105 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include <CppUTest/TestHarness.h>
+
+extern "C"
+{
+#include "arena.h"
+};
+
+#include <stdint.h>
+#include <string.h>
+
+TEST_GROUP(arena)
+{
+    arena_st arena;
+
+    void setup()
+    {
+        arena_init(&arena);
+    }
+
+    void teardown()
+    {
+        arena_teardown(&arena);
+    }
+};
+
+TEST(arena, allocations_are_aligned_and_distinct)
+{
+    char * first;
+    char * second;
+
+    /* perform test */
+    first = (char *)arena_alloc(&arena, 3);
+    second = (char *)arena_alloc(&arena, 5);
+
+    /* check results */
+    CHECK_TRUE(first != NULL);
+    CHECK_TRUE(second != NULL);
+    CHECK_TRUE(second >= first + 3);
+    LONGS_EQUAL(0, (uintptr_t)first % 16);
+    LONGS_EQUAL(0, (uintptr_t)second % 16);
+}
+
+TEST(arena, strdup_partial_copies_part_of_string)
+{
+    char const * copy;
+
+    /* perform test */
+    copy = arena_strdup_partial(&arena, "abcdef", 1, 4);
+
+    /* check results */
+    STRCMP_EQUAL("bcd", copy);
+}
+
+TEST(arena, allocation_larger_than_a_chunk_succeeds)
+{
+    size_t const size = 100000;
+    char * memory;
+
+    /* perform test */
+    (void)arena_alloc(&arena, 10);
+    memory = (char *)arena_alloc(&arena, size);
+
+    /* check results */
+    CHECK_TRUE(memory != NULL);
+    memset(memory, 'x', size);
+}
+
+TEST(arena, reset_reuses_the_newest_chunk)
+{
+    void * first;
+    void * after_reset;
+    size_t index;
+
+    /* setup */
+    for (index = 0; index < 100; index++)
+    {
+        (void)arena_alloc(&arena, 100);
+    }
+    first = arena_alloc(&arena, 100);
+
+    /* perform test */
+    arena_reset(&arena);
+    after_reset = arena_alloc(&arena, 100);
+
+    /* check results */
+    CHECK_TRUE((char *)after_reset < (char *)first);
+}
+
+TEST(arena, trim_frees_large_chunk)
+{
+    /* setup */
+    (void)arena_alloc(&arena, 100000);
+
+    /* perform test */
+    arena_trim(&arena, 1024);
+
+    /* check results */
+    POINTERS_EQUAL(NULL, arena.chunks);
+}
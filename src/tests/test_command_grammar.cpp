@@ -0,0 +1,235 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include <CppUTest/TestHarness.h>
+
+#include <string.h>
+
+extern "C"
+{
+#include "readline.h"
+};
+
+enum
+{
+    id_show_interface,
+    id_show_version,
+    id_set_mtu,
+    id_ping,
+    id_ping_count
+};
+
+TEST_GROUP(command_grammar)
+{
+    command_grammar_st * grammar;
+    command_arg_st args[8];
+    command_st command;
+
+    void setup()
+    {
+        grammar = command_grammar_create();
+        CHECK(grammar != NULL);
+        CHECK_TRUE(command_grammar_add(grammar, "show interface <word>", id_show_interface));
+        CHECK_TRUE(command_grammar_add(grammar, "show version", id_show_version));
+        CHECK_TRUE(command_grammar_add(grammar, "set mtu <number>", id_set_mtu));
+        CHECK_TRUE(command_grammar_add(grammar, "ping <word>", id_ping));
+        CHECK_TRUE(command_grammar_add(grammar, "ping <word> count <number>", id_ping_count));
+    }
+
+    void teardown()
+    {
+        /* cleanup */
+        command_grammar_destroy(grammar);
+    }
+
+    void parse(size_t const argc, char const * const * const argv)
+    {
+        command_grammar_parse(grammar, argc, argv, args, &command);
+    }
+};
+
+TEST(command_grammar, command_is_identified)
+{
+    char const * argv[] = {"show", "interface", "eth0"};
+
+    /* perform test */
+    parse(3, argv);
+
+    /* check results */
+    LONGS_EQUAL(command_syntax_ok, command.syntax);
+    LONGS_EQUAL(id_show_interface, command.id);
+    LONGS_EQUAL(3, command.error_index);
+    POINTERS_EQUAL(args, command.args);
+    LONGS_EQUAL(command_arg_keyword, args[0].type);
+    LONGS_EQUAL(command_arg_keyword, args[1].type);
+    LONGS_EQUAL(command_arg_word, args[2].type);
+}
+
+TEST(command_grammar, keywords_can_be_abbreviated)
+{
+    char const * argv[] = {"sh", "ver"};
+
+    /* perform test */
+    parse(2, argv);
+
+    /* check results */
+    LONGS_EQUAL(command_syntax_ok, command.syntax);
+    LONGS_EQUAL(id_show_version, command.id);
+}
+
+TEST(command_grammar, number_arg_is_converted)
+{
+    char const * argv[] = {"set", "mtu", "1500"};
+
+    /* perform test */
+    parse(3, argv);
+
+    /* check results */
+    LONGS_EQUAL(command_syntax_ok, command.syntax);
+    LONGS_EQUAL(id_set_mtu, command.id);
+    LONGS_EQUAL(command_arg_number, args[2].type);
+    LONGS_EQUAL(1500, args[2].number);
+}
+
+TEST(command_grammar, number_with_leading_zero_is_decimal)
+{
+    char const * argv[] = {"set", "mtu", "08"};
+
+    /* perform test */
+    parse(3, argv);
+
+    /* check results */
+    LONGS_EQUAL(command_syntax_ok, command.syntax);
+    LONGS_EQUAL(8, args[2].number);
+}
+
+TEST(command_grammar, negative_number_is_converted)
+{
+    char const * argv[] = {"set", "mtu", "-20"};
+
+    /* perform test */
+    parse(3, argv);
+
+    /* check results */
+    LONGS_EQUAL(command_syntax_ok, command.syntax);
+    LONGS_EQUAL(-20, args[2].number);
+}
+
+TEST(command_grammar, hex_number_is_reported)
+{
+    char const * argv[] = {"set", "mtu", "0x5dc"};
+
+    /* perform test */
+    parse(3, argv);
+
+    /* check results */
+    LONGS_EQUAL(command_syntax_bad_number, command.syntax);
+    LONGS_EQUAL(2, command.error_index);
+}
+
+TEST(command_grammar, bad_number_is_reported)
+{
+    char const * argv[] = {"set", "mtu", "15OO"};
+
+    /* perform test */
+    parse(3, argv);
+
+    /* check results */
+    LONGS_EQUAL(command_syntax_bad_number, command.syntax);
+    LONGS_EQUAL(2, command.error_index);
+}
+
+TEST(command_grammar, unknown_word_is_reported)
+{
+    char const * argv[] = {"show", "ip", "route"};
+
+    /* perform test */
+    parse(3, argv);
+
+    /* check results */
+    LONGS_EQUAL(command_syntax_unknown_word, command.syntax);
+    LONGS_EQUAL(1, command.error_index);
+}
+
+TEST(command_grammar, ambiguous_word_is_reported)
+{
+    char const * argv[] = {"s", "version"};
+
+    /* perform test */
+    parse(2, argv);
+
+    /* check results */
+    LONGS_EQUAL(command_syntax_ambiguous_word, command.syntax);
+    LONGS_EQUAL(0, command.error_index);
+}
+
+TEST(command_grammar, incomplete_command_is_reported)
+{
+    char const * argv[] = {"show", "interface"};
+
+    /* perform test */
+    parse(2, argv);
+
+    /* check results */
+    LONGS_EQUAL(command_syntax_incomplete, command.syntax);
+    LONGS_EQUAL(2, command.error_index);
+}
+
+TEST(command_grammar, too_many_args_is_reported)
+{
+    char const * argv[] = {"show", "version", "now"};
+
+    /* perform test */
+    parse(3, argv);
+
+    /* check results */
+    LONGS_EQUAL(command_syntax_unknown_word, command.syntax);
+    LONGS_EQUAL(2, command.error_index);
+}
+
+TEST(command_grammar, longer_command_shares_start_of_shorter)
+{
+    char const * short_argv[] = {"ping", "host"};
+    char const * long_argv[] = {"ping", "host", "c", "3"};
+
+    /* perform test */
+    parse(2, short_argv);
+    LONGS_EQUAL(command_syntax_ok, command.syntax);
+    LONGS_EQUAL(id_ping, command.id);
+    parse(4, long_argv);
+
+    /* check results */
+    LONGS_EQUAL(command_syntax_ok, command.syntax);
+    LONGS_EQUAL(id_ping_count, command.id);
+    LONGS_EQUAL(3, args[3].number);
+}
+
+TEST(command_grammar, keyword_is_preferred_to_arg)
+{
+    char const * keyword_argv[] = {"show", "interface", "all"};
+    char const * word_argv[] = {"show", "interface", "eth0"};
+
+    /* setup */
+    CHECK_TRUE(command_grammar_add(grammar, "show interface all", id_show_version));
+
+    /* perform test */
+    parse(3, keyword_argv);
+    LONGS_EQUAL(id_show_version, command.id);
+    LONGS_EQUAL(command_arg_keyword, args[2].type);
+    parse(3, word_argv);
+
+    /* check results */
+    LONGS_EQUAL(id_show_interface, command.id);
+    LONGS_EQUAL(command_arg_word, args[2].type);
+}
+
+TEST(command_grammar, bad_syntax_is_rejected)
+{
+    CHECK_FALSE(command_grammar_add(grammar, "", id_ping));
+    CHECK_FALSE(command_grammar_add(grammar, "show <colour>", id_ping));
+    /* "ping" is already followed by a <word>. */
+    CHECK_FALSE(command_grammar_add(grammar, "ping <number>", id_ping));
+}
@@ -0,0 +1,196 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include <CppUTest/TestHarness.h>
+
+extern "C"
+{
+#include "gap_buffer.h"
+};
+
+#include <stdlib.h>
+#include <string.h>
+
+TEST_GROUP(gap_buffer)
+{
+    gap_buffer_st gap_buffer;
+
+    void setup()
+    {
+        CHECK_TRUE(gap_buffer_init(&gap_buffer, 4));
+    }
+
+    void teardown()
+    {
+        gap_buffer_teardown(&gap_buffer);
+    }
+
+    void insert(size_t const index, char const * const string)
+    {
+        CHECK_TRUE(gap_buffer_insert(&gap_buffer, index, string, strlen(string)));
+    }
+};
+
+TEST(gap_buffer, new_buffer_is_empty)
+{
+    /* check results */
+    LONGS_EQUAL(0, gap_buffer_get_length(&gap_buffer));
+    STRCMP_EQUAL("", gap_buffer_get_string(&gap_buffer));
+}
+
+TEST(gap_buffer, insert_beyond_initial_size_grows_buffer)
+{
+    /* perform test */
+    insert(0, "hello");
+    insert(5, " world");
+
+    /* check results */
+    LONGS_EQUAL(11, gap_buffer_get_length(&gap_buffer));
+    STRCMP_EQUAL("hello world", gap_buffer_get_string(&gap_buffer));
+}
+
+TEST(gap_buffer, insert_in_middle_after_growing)
+{
+    /* setup */
+    insert(0, "ac");
+
+    /* perform test */
+    insert(1, "bbbbbb");
+
+    /* check results */
+    STRCMP_EQUAL("abbbbbbc", gap_buffer_get_string(&gap_buffer));
+}
+
+TEST(gap_buffer, inserts_at_different_positions)
+{
+    /* perform test */
+    insert(0, "ad");
+    insert(1, "c");
+    insert(1, "b");
+    insert(4, "e");
+    insert(0, "_");
+
+    /* check results */
+    STRCMP_EQUAL("_abcde", gap_buffer_get_string(&gap_buffer));
+}
+
+TEST(gap_buffer, insert_beyond_end_fails)
+{
+    /* perform test */
+    CHECK_FALSE(gap_buffer_insert(&gap_buffer, 1, "a", 1));
+
+    /* check results */
+    LONGS_EQUAL(0, gap_buffer_get_length(&gap_buffer));
+}
+
+TEST(gap_buffer, delete_removes_characters)
+{
+    /* setup */
+    insert(0, "abcdef");
+
+    /* perform test */
+    gap_buffer_delete(&gap_buffer, 1, 2);
+
+    /* check results */
+    STRCMP_EQUAL("adef", gap_buffer_get_string(&gap_buffer));
+}
+
+TEST(gap_buffer, delete_past_end_is_truncated)
+{
+    /* setup */
+    insert(0, "abcdef");
+
+    /* perform test */
+    gap_buffer_delete(&gap_buffer, 4, 10);
+
+    /* check results */
+    STRCMP_EQUAL("abcd", gap_buffer_get_string(&gap_buffer));
+}
+
+TEST(gap_buffer, get_and_set_char_either_side_of_gap)
+{
+    /* setup */
+    insert(0, "abcd");
+    gap_buffer_get_string_from(&gap_buffer, 2);
+
+    /* perform test */
+    gap_buffer_set_char(&gap_buffer, 1, 'B');
+    gap_buffer_set_char(&gap_buffer, 2, 'C');
+
+    /* check results */
+    LONGS_EQUAL('a', gap_buffer_get_char(&gap_buffer, 0));
+    LONGS_EQUAL('B', gap_buffer_get_char(&gap_buffer, 1));
+    LONGS_EQUAL('C', gap_buffer_get_char(&gap_buffer, 2));
+    LONGS_EQUAL('d', gap_buffer_get_char(&gap_buffer, 3));
+    LONGS_EQUAL('\0', gap_buffer_get_char(&gap_buffer, 4));
+}
+
+TEST(gap_buffer, get_string_from_returns_the_tail)
+{
+    /* setup */
+    insert(0, "abcdef");
+
+    /* perform test */
+    STRCMP_EQUAL("def", gap_buffer_get_string_from(&gap_buffer, 3));
+
+    /* check results */
+    STRCMP_EQUAL("abcdef", gap_buffer_get_string(&gap_buffer));
+}
+
+TEST(gap_buffer, clear_keeps_memory)
+{
+    char * buffer;
+
+    /* setup */
+    insert(0, "abcdefgh");
+    buffer = gap_buffer.buffer;
+
+    /* perform test */
+    gap_buffer_clear(&gap_buffer);
+
+    /* check results */
+    LONGS_EQUAL(0, gap_buffer_get_length(&gap_buffer));
+    POINTERS_EQUAL(buffer, gap_buffer.buffer);
+    insert(0, "xyz");
+    STRCMP_EQUAL("xyz", gap_buffer_get_string(&gap_buffer));
+}
+
+TEST(gap_buffer, trim_gives_back_excess_memory)
+{
+    /* setup */
+    insert(0, "a string longer than the trimmed size");
+
+    /* perform test */
+    gap_buffer_trim(&gap_buffer, 8);
+
+    /* check results */
+    LONGS_EQUAL(0, gap_buffer_get_length(&gap_buffer));
+    LONGS_EQUAL(8, gap_buffer.buffer_size);
+    insert(0, "abc");
+    STRCMP_EQUAL("abc", gap_buffer_get_string(&gap_buffer));
+}
+
+TEST(gap_buffer, growth_is_geometric)
+{
+    size_t index;
+    size_t reallocs = 0;
+    size_t previous_size = gap_buffer.buffer_size;
+
+    /* perform test */
+    for (index = 0; index < 1024; index++)
+    {
+        insert(index, "x");
+        if (gap_buffer.buffer_size != previous_size)
+        {
+            reallocs++;
+            previous_size = gap_buffer.buffer_size;
+        }
+    }
+
+    /* check results */
+    LONGS_EQUAL(1024, gap_buffer_get_length(&gap_buffer));
+    CHECK(reallocs <= 10);
+}
@@ -231,6 +231,37 @@ TEST(history, history_size_honoured)
     STRCMP_EQUAL(NULL, second_entry_retrieved);
 }
 
+TEST(history, oldest_entries_reused_when_full)
+{
+    size_t maximum_size;
+    char const test_string1[] = "a";
+    char const test_string2[] = "bb";
+    char const test_string3[] = "a much longer string than the others";
+    char const test_string4[] = "c";
+    char const * first_entry_retrieved;
+    char const * second_entry_retrieved;
+    char const * third_entry_retrieved;
+
+    /* setup */
+    maximum_size = 2;
+    history = history_alloc(maximum_size);
+
+    /* perform_test */
+    (void)history_add(history, test_string1);
+    (void)history_add(history, test_string2);
+    (void)history_add(history, test_string3);
+    (void)history_add(history, test_string4);
+    /* Retrieve the entries. */
+    first_entry_retrieved = history_get_older_entry(history);
+    second_entry_retrieved = history_get_older_entry(history);
+    third_entry_retrieved = history_get_older_entry(history);
+
+    /* check_results */
+    STRCMP_EQUAL(test_string4, first_entry_retrieved);
+    STRCMP_EQUAL(test_string3, second_entry_retrieved);
+    STRCMP_EQUAL(NULL, third_entry_retrieved);
+}
+
 TEST(history, newer_entries_retrieved_successfully)
 {
     size_t maximum_size;
@@ -303,3 +334,31 @@ TEST(history, reset_returns_to_most_recent)
     CHECK_TRUE(at_most_recent);
 }
 
+
+TEST(history, clear_removes_all_entries)
+{
+    size_t maximum_size;
+    char const test_string1[] = "test_string1";
+    char const test_string2[] = "test_string2";
+    char const test_string3[] = "test_string3";
+    char const * entry;
+
+    /* setup */
+    maximum_size = 2;
+    history = history_alloc(maximum_size);
+    (void)history_add(history, test_string1);
+    (void)history_add(history, test_string2);
+
+    /* perform_test */
+    history_clear(history);
+    entry = history_get_older_entry(history);
+
+    /* check_results */
+    POINTERS_EQUAL(NULL, entry);
+    CHECK_TRUE(history_currently_at_most_recent(history));
+
+    /* Entries added after clearing reuse the old ones. */
+    CHECK_TRUE(history_add(history, test_string3));
+    STRCMP_EQUAL(test_string3, history_get_older_entry(history));
+    POINTERS_EQUAL(NULL, history_get_older_entry(history));
+}
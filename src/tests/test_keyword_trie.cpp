@@ -0,0 +1,382 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include <CppUTest/TestHarness.h>
+
+#include <stdio.h>
+#include <string.h>
+
+extern "C"
+{
+#include "readline.h"
+};
+
+enum
+{
+    id_show,
+    id_shutdown,
+    id_set,
+    id_interface,
+    id_ip,
+    id_int
+};
+
+TEST_GROUP(keyword_trie)
+{
+    keyword_trie_st * trie;
+
+    void setup()
+    {
+        trie = keyword_trie_create();
+        CHECK(trie != NULL);
+        CHECK_TRUE(keyword_trie_add(trie, "show", id_show, NULL));
+        CHECK_TRUE(keyword_trie_add(trie, "shutdown", id_shutdown, NULL));
+        CHECK_TRUE(keyword_trie_add(trie, "set", id_set, NULL));
+    }
+
+    void teardown()
+    {
+        /* cleanup */
+        keyword_trie_destroy(trie);
+    }
+
+    void lookup(char const * const word, keyword_match_st * const match)
+    {
+        keyword_trie_lookup(trie, word, strlen(word), match);
+    }
+};
+
+TEST(keyword_trie, full_keyword_matches)
+{
+    keyword_match_st match;
+
+    /* perform test */
+    lookup("show", &match);
+
+    /* check results */
+    LONGS_EQUAL(keyword_match_unique, match.result);
+    STRCMP_EQUAL("show", match.keyword);
+    LONGS_EQUAL(id_show, match.id);
+    LONGS_EQUAL(1, match.num_matches);
+}
+
+TEST(keyword_trie, unique_abbreviation_matches)
+{
+    keyword_match_st match;
+
+    /* perform test */
+    lookup("sho", &match);
+
+    /* check results */
+    LONGS_EQUAL(keyword_match_unique, match.result);
+    STRCMP_EQUAL("show", match.keyword);
+    LONGS_EQUAL(id_show, match.id);
+}
+
+TEST(keyword_trie, ambiguous_abbreviation_is_reported)
+{
+    keyword_match_st match;
+
+    /* perform test */
+    lookup("sh", &match);
+
+    /* check results */
+    LONGS_EQUAL(keyword_match_ambiguous, match.result);
+    LONGS_EQUAL(2, match.num_matches);
+    POINTERS_EQUAL(NULL, match.keyword);
+}
+
+TEST(keyword_trie, unknown_word_does_not_match)
+{
+    keyword_match_st match;
+
+    /* perform test */
+    lookup("shz", &match);
+
+    /* check results */
+    LONGS_EQUAL(keyword_match_none, match.result);
+    LONGS_EQUAL(0, match.num_matches);
+}
+
+TEST(keyword_trie, empty_word_does_not_match)
+{
+    keyword_match_st match;
+
+    /* perform test */
+    lookup("", &match);
+
+    /* check results */
+    LONGS_EQUAL(keyword_match_none, match.result);
+}
+
+TEST(keyword_trie, keyword_that_is_prefix_of_another_matches_itself)
+{
+    keyword_match_st match;
+
+    /* setup */
+    CHECK_TRUE(keyword_trie_add(trie, "int", id_int, NULL));
+    CHECK_TRUE(keyword_trie_add(trie, "interface", id_interface, NULL));
+
+    /* perform test */
+    lookup("int", &match);
+
+    /* check results */
+    LONGS_EQUAL(keyword_match_unique, match.result);
+    LONGS_EQUAL(id_int, match.id);
+    LONGS_EQUAL(2, match.num_matches);
+}
+
+TEST(keyword_trie, word_need_not_be_nul_terminated)
+{
+    keyword_match_st match;
+
+    /* perform test */
+    keyword_trie_lookup(trie, "setting", 3, &match);
+
+    /* check results */
+    LONGS_EQUAL(keyword_match_unique, match.result);
+    LONGS_EQUAL(id_set, match.id);
+}
+
+TEST(keyword_trie, adding_keyword_again_replaces_id)
+{
+    keyword_match_st match;
+
+    /* setup */
+    CHECK_TRUE(keyword_trie_add(trie, "set", id_ip, NULL));
+
+    /* perform test */
+    lookup("se", &match);
+
+    /* check results */
+    LONGS_EQUAL(keyword_match_unique, match.result);
+    LONGS_EQUAL(id_ip, match.id);
+    LONGS_EQUAL(1, match.num_matches);
+}
+
+TEST(keyword_trie, many_keywords)
+{
+    char keyword[16];
+    keyword_match_st match;
+    int index;
+
+    /* setup */
+    for (index = 0; index < 1000; index++)
+    {
+        snprintf(keyword, sizeof keyword, "kw%d", index);
+        CHECK_TRUE(keyword_trie_add(trie, keyword, index, NULL));
+    }
+
+    /* perform test */
+    lookup("kw999", &match);
+
+    /* check results */
+    LONGS_EQUAL(keyword_match_unique, match.result);
+    LONGS_EQUAL(999, match.id);
+    lookup("kw99", &match);
+    LONGS_EQUAL(keyword_match_unique, match.result);
+    LONGS_EQUAL(99, match.id);
+    lookup("kw9", &match);
+    LONGS_EQUAL(keyword_match_unique, match.result);
+    lookup("kw", &match);
+    LONGS_EQUAL(keyword_match_ambiguous, match.result);
+    LONGS_EQUAL(1000, match.num_matches);
+}
+
+TEST_GROUP(keyword_trie_resolve)
+{
+    keyword_trie_st * commands;
+    keyword_trie_st * show_keywords;
+
+    void setup()
+    {
+        commands = keyword_trie_create();
+        show_keywords = keyword_trie_create();
+        CHECK(commands != NULL && show_keywords != NULL);
+        CHECK_TRUE(keyword_trie_add(commands, "show", id_show, show_keywords));
+        CHECK_TRUE(keyword_trie_add(commands, "shutdown", id_shutdown, NULL));
+        CHECK_TRUE(keyword_trie_add(show_keywords, "interface", id_interface, NULL));
+        CHECK_TRUE(keyword_trie_add(show_keywords, "ip", id_ip, NULL));
+    }
+
+    void teardown()
+    {
+        /* cleanup */
+        keyword_trie_destroy(show_keywords);
+        keyword_trie_destroy(commands);
+    }
+};
+
+TEST(keyword_trie_resolve, abbreviations_resolved_through_tree)
+{
+    char const * argv[] = {"sho", "int", "eth0"};
+    keyword_match_st matches[3];
+    size_t num_resolved;
+
+    /* perform test */
+    LONGS_EQUAL(keyword_match_unique, keyword_trie_resolve(commands, 3, argv, matches, &num_resolved));
+
+    /* check results */
+    /* The interface name isn't a keyword, so is left alone. */
+    LONGS_EQUAL(2, num_resolved);
+    STRCMP_EQUAL("show", matches[0].keyword);
+    STRCMP_EQUAL("interface", matches[1].keyword);
+    LONGS_EQUAL(id_interface, matches[1].id);
+}
+
+TEST(keyword_trie_resolve, ambiguous_arg_is_reported)
+{
+    char const * argv[] = {"show", "i"};
+    keyword_match_st matches[2];
+    size_t num_resolved;
+
+    /* perform test */
+    LONGS_EQUAL(keyword_match_ambiguous, keyword_trie_resolve(commands, 2, argv, matches, &num_resolved));
+
+    /* check results */
+    LONGS_EQUAL(1, num_resolved);
+    LONGS_EQUAL(2, matches[1].num_matches);
+}
+
+TEST(keyword_trie_resolve, unknown_command_is_reported)
+{
+    char const * argv[] = {"reload"};
+    keyword_match_st matches[1];
+    size_t num_resolved;
+
+    /* perform test */
+    LONGS_EQUAL(keyword_match_none, keyword_trie_resolve(commands, 1, argv, matches, &num_resolved));
+
+    /* check results */
+    LONGS_EQUAL(0, num_resolved);
+}
+
+/* A completion context with the tokens given by the test. */
+static char const * const * completion_tokens;
+static size_t completion_num_tokens;
+static char possible_words[128];
+static char unique_match[32];
+
+static int add_possible_word(completion_context_st * const completion_context, char const * const possible_word)
+{
+    (void)completion_context;
+    strcat(possible_words, possible_word);
+    strcat(possible_words, ",");
+
+    return 0;
+}
+
+static int set_unique_match(completion_context_st * const completion_context, char const * const match)
+{
+    (void)completion_context;
+    strcpy(unique_match, match);
+
+    return 0;
+}
+
+static size_t get_current_token_index(completion_context_st * const completion_context)
+{
+    (void)completion_context;
+
+    return completion_num_tokens - 1;
+}
+
+static char const * get_current_token(completion_context_st * const completion_context)
+{
+    (void)completion_context;
+
+    return completion_tokens[completion_num_tokens - 1];
+}
+
+static char const * get_token_at_index(completion_context_st * const completion_context, size_t const index)
+{
+    (void)completion_context;
+
+    return index < completion_num_tokens ? completion_tokens[index] : NULL;
+}
+
+static void get_current_segment(completion_context_st * const completion_context, token_segment_st * const segment)
+{
+    (void)completion_context;
+    segment->first_token_index = 0;
+    segment->num_tokens = completion_num_tokens;
+    segment->first_token = completion_tokens[0];
+}
+
+TEST_GROUP(keyword_completion)
+{
+    keyword_trie_st * commands;
+    keyword_trie_st * show_keywords;
+    completion_context_st completion_context;
+
+    void setup()
+    {
+        commands = keyword_trie_create();
+        show_keywords = keyword_trie_create();
+        CHECK_TRUE(keyword_trie_add(commands, "show", id_show, show_keywords));
+        CHECK_TRUE(keyword_trie_add(commands, "shutdown", id_shutdown, NULL));
+        CHECK_TRUE(keyword_trie_add(show_keywords, "interface", id_interface, NULL));
+        CHECK_TRUE(keyword_trie_add(show_keywords, "ip", id_ip, NULL));
+
+        memset(&completion_context, 0, sizeof completion_context);
+        completion_context.possible_word_add_fn = add_possible_word;
+        completion_context.unique_match_set_fn = set_unique_match;
+        completion_context.tokens_get_current_token_index_fn = get_current_token_index;
+        completion_context.tokens_get_current_token_fn = get_current_token;
+        completion_context.tokens_get_token_at_index_fn = get_token_at_index;
+        completion_context.tokens_get_current_segment_fn = get_current_segment;
+        possible_words[0] = '\0';
+        unique_match[0] = '\0';
+    }
+
+    void teardown()
+    {
+        /* cleanup */
+        keyword_trie_destroy(show_keywords);
+        keyword_trie_destroy(commands);
+    }
+
+    void complete(size_t const num_tokens, char const * const * const tokens)
+    {
+        completion_tokens = tokens;
+        completion_num_tokens = num_tokens;
+        LONGS_EQUAL(0, do_keyword_completion(&completion_context, commands));
+    }
+};
+
+TEST(keyword_completion, abbreviation_lists_keywords)
+{
+    char const * tokens[] = {"sh"};
+
+    /* perform test */
+    complete(1, tokens);
+
+    /* check results */
+    STRCMP_EQUAL("shutdown,show,", possible_words);
+    STRCMP_EQUAL("", unique_match);
+}
+
+TEST(keyword_completion, unique_abbreviation_is_completed)
+{
+    char const * tokens[] = {"sho", "in"};
+
+    /* perform test */
+    complete(2, tokens);
+
+    /* check results */
+    STRCMP_EQUAL("interface ", unique_match);
+}
+
+TEST(keyword_completion, nothing_after_keyword_that_leads_nowhere)
+{
+    char const * tokens[] = {"shut", ""};
+
+    /* perform test */
+    complete(2, tokens);
+
+    /* check results */
+    STRCMP_EQUAL("", possible_words);
+}
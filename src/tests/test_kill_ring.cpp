@@ -0,0 +1,120 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include <CppUTest/TestHarness.h>
+
+extern "C"
+{
+#include "kill_ring.h"
+};
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+TEST_GROUP(kill_ring)
+{
+    kill_ring_st kill_ring;
+
+    void setup()
+    {
+        kill_ring_init(&kill_ring);
+    }
+
+    void teardown()
+    {
+    }
+
+    void add(char const * const text)
+    {
+        kill_ring_add(&kill_ring, text, strlen(text));
+    }
+
+    void check_kill(size_t const age, char const * const expected)
+    {
+        size_t length;
+        char const * const text = kill_ring_get(&kill_ring, age, &length);
+
+        CHECK_TRUE(text != NULL);
+        LONGS_EQUAL(strlen(expected), length);
+        CHECK_TRUE(memcmp(expected, text, length) == 0);
+    }
+};
+
+TEST(kill_ring, new_kill_ring_is_empty)
+{
+    size_t length;
+
+    /* check results */
+    LONGS_EQUAL(0, kill_ring_get_num_kills(&kill_ring));
+    POINTERS_EQUAL(NULL, kill_ring_get(&kill_ring, 0, &length));
+}
+
+TEST(kill_ring, newest_kill_has_age_0)
+{
+    /* perform test */
+    add("first");
+    add("second");
+
+    /* check results */
+    LONGS_EQUAL(2, kill_ring_get_num_kills(&kill_ring));
+    check_kill(0, "second");
+    check_kill(1, "first");
+}
+
+TEST(kill_ring, oldest_kills_forgotten_when_maximum_kills_reached)
+{
+    char text[10];
+    size_t i;
+
+    /* perform test */
+    for (i = 0; i < KILL_RING_MAXIMUM_KILLS + 2; i++)
+    {
+        snprintf(text, sizeof text, "%zu", i);
+        add(text);
+    }
+
+    /* check results */
+    LONGS_EQUAL(KILL_RING_MAXIMUM_KILLS, kill_ring_get_num_kills(&kill_ring));
+    check_kill(0, "17");
+    check_kill(KILL_RING_MAXIMUM_KILLS - 1, "2");
+}
+
+TEST(kill_ring, kill_wraps_to_start_of_arena_and_overwrites_oldest)
+{
+    char text[KILL_RING_SIZE / 2 + 1];
+
+    /* setup */
+    memset(text, 'a', sizeof text - 1);
+    text[sizeof text - 1] = '\0';
+    add("first");
+    add(text);
+
+    /* perform test */
+    text[0] = 'b';
+    add(text);
+
+    /* check results */
+    LONGS_EQUAL(1, kill_ring_get_num_kills(&kill_ring));
+    check_kill(0, text);
+}
+
+TEST(kill_ring, kill_larger_than_arena_is_ignored)
+{
+    char text[KILL_RING_SIZE + 2];
+
+    /* setup */
+    memset(text, 'a', sizeof text - 1);
+    text[sizeof text - 1] = '\0';
+    add("first");
+
+    /* perform test */
+    add(text);
+
+    /* check results */
+    LONGS_EQUAL(1, kill_ring_get_num_kills(&kill_ring));
+    check_kill(0, "first");
+}
@@ -0,0 +1,169 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include <CppUTest/TestHarness.h>
+
+extern "C"
+{
+#include "output_queue.h"
+};
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+TEST_GROUP(output_queue)
+{
+    int fds[2];
+    output_queue_st output_queue;
+
+    void setup()
+    {
+        if (pipe(fds) != 0)
+        {
+            FAIL("pipe failed");
+        }
+        fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+        output_queue_init(&output_queue, fds[1]);
+    }
+
+    void teardown()
+    {
+        output_queue_teardown(&output_queue);
+        close(fds[0]);
+        close(fds[1]);
+    }
+};
+
+TEST(output_queue, queued_output_is_written_by_flush)
+{
+    char read_buffer[16];
+    ssize_t bytes_read;
+    output_queue_flush_result_t result;
+
+    /* setup */
+    output_queue_write(&output_queue, "abc", 3);
+    output_queue_put(&output_queue, 'd');
+
+    /* perform test */
+    result = output_queue_flush(&output_queue, false);
+
+    /* check results */
+    LONGS_EQUAL(output_queue_flush_result_done, result);
+    LONGS_EQUAL(0, output_queue_get_length(&output_queue));
+    bytes_read = read(fds[0], read_buffer, sizeof read_buffer);
+    LONGS_EQUAL(4, bytes_read);
+    MEMCMP_EQUAL("abcd", read_buffer, 4);
+}
+
+TEST(output_queue, full_fd_leaves_output_queued)
+{
+    char chunk[4096];
+    output_queue_flush_result_t result;
+    size_t total_queued = 0;
+
+    /* setup */
+    memset(chunk, 'x', sizeof chunk);
+
+    /* perform test */
+    do
+    {
+        output_queue_write(&output_queue, chunk, sizeof chunk);
+        total_queued += sizeof chunk;
+        result = output_queue_flush(&output_queue, false);
+    }
+    while (result == output_queue_flush_result_done && total_queued < 16 * 1024 * 1024);
+
+    /* check results */
+    LONGS_EQUAL(output_queue_flush_result_pending, result);
+    CHECK(output_queue_get_length(&output_queue) > 0);
+}
+
+TEST(output_queue, queue_is_full_once_limit_queued)
+{
+    char chunk[10];
+
+    /* setup */
+    memset(chunk, 'x', sizeof chunk);
+    output_queue.limit = sizeof chunk;
+
+    /* perform test */
+    output_queue_write(&output_queue, chunk, sizeof chunk - 1);
+
+    /* check results */
+    CHECK_FALSE(output_queue_is_full(&output_queue));
+    output_queue_put(&output_queue, 'x');
+    CHECK_TRUE(output_queue_is_full(&output_queue));
+}
+
+TEST(output_queue, output_past_limit_is_dropped_if_not_waiting)
+{
+    char read_buffer[16];
+    ssize_t bytes_read;
+
+    /* setup */
+    output_queue.limit = 10;
+    output_queue.wait_when_full = false;
+
+    /* perform test */
+    CHECK_TRUE(output_queue_write(&output_queue, "abcdef", 6));
+    CHECK_FALSE(output_queue_write(&output_queue, "ghijkl", 6));
+    output_queue_put(&output_queue, 'm');
+
+    /* check results */
+    LONGS_EQUAL(10, output_queue_get_length(&output_queue));
+    CHECK_TRUE(output_queue.overflowed);
+    LONGS_EQUAL(output_queue_flush_result_done, output_queue_flush(&output_queue, false));
+    bytes_read = read(fds[0], read_buffer, sizeof read_buffer);
+    LONGS_EQUAL(10, bytes_read);
+    MEMCMP_EQUAL("abcdefghij", read_buffer, 10);
+}
+
+TEST(output_queue, output_past_limit_is_written_out_if_waiting)
+{
+    char read_buffer[32];
+    ssize_t bytes_read;
+
+    /* setup */
+    output_queue.limit = 10;
+
+    /* perform test */
+    CHECK_TRUE(output_queue_write(&output_queue, "abcdefghijklmnop", 16));
+
+    /* check results */
+    CHECK_FALSE(output_queue.overflowed);
+    LONGS_EQUAL(6, output_queue_get_length(&output_queue));
+    LONGS_EQUAL(output_queue_flush_result_done, output_queue_flush(&output_queue, false));
+    bytes_read = read(fds[0], read_buffer, sizeof read_buffer);
+    LONGS_EQUAL(16, bytes_read);
+    MEMCMP_EQUAL("abcdefghijklmnop", read_buffer, 16);
+}
+
+TEST(output_queue, telnet_escape_is_not_split_when_full)
+{
+    char chunk[9];
+    char read_buffer[16];
+    ssize_t bytes_read;
+
+    /* setup */
+    memset(chunk, 'x', sizeof chunk);
+    output_queue.limit = sizeof chunk + 1;
+    output_queue.wait_when_full = false;
+    output_queue.telnet_encoding = true;
+    CHECK_TRUE(output_queue_write(&output_queue, chunk, sizeof chunk));
+
+    /* perform test */
+    CHECK_FALSE(output_queue_write(&output_queue, "\xff", 1));
+    CHECK_FALSE(output_queue_write(&output_queue, "\n", 1));
+
+    /* check results */
+    CHECK_TRUE(output_queue.overflowed);
+    LONGS_EQUAL(sizeof chunk, output_queue_get_length(&output_queue));
+    LONGS_EQUAL(output_queue_flush_result_done, output_queue_flush(&output_queue, false));
+    bytes_read = read(fds[0], read_buffer, sizeof read_buffer);
+    LONGS_EQUAL(sizeof chunk, bytes_read);
+    MEMCMP_EQUAL(chunk, read_buffer, sizeof chunk);
+}
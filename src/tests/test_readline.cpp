@@ -9,6 +9,9 @@
 
 #include <unistd.h>
 #include <stdio.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
 extern "C"
 {
 #include "readline.h"
@@ -90,6 +93,100 @@ TEST(readline, empty_string_no_tty)
     child_process(stdin_pipe[0], stdout_pipe[1], "");
 }
 
+TEST(readline, args_are_returned_in_one_block)
+{
+    int stdin_pipe[2];
+    int stdout_pipe[2];
+    readline_st * readline_ctx;
+    readline_result_t result;
+    size_t argc;
+    char const * * argv;
+
+    /* setup */
+    pipe(stdin_pipe);
+    pipe(stdout_pipe);
+    mock().disable();
+    readline_ctx = readline_context_create(NULL, NULL, NULL, '\0', stdin_pipe[0], stdout_pipe[1], 0);
+    CHECK(readline_ctx != NULL);
+    dprintf(stdin_pipe[1], "show 'a b' c\\ d\n");
+
+    /* perform test */
+    result = readline_args(readline_ctx, 0, "", &argc, &argv);
+
+    /* check results */
+    LONGS_EQUAL(readline_result_success, result);
+    LONGS_EQUAL(3, argc);
+    STRCMP_EQUAL("show", argv[0]);
+    STRCMP_EQUAL("a b", argv[1]);
+    STRCMP_EQUAL("c d", argv[2]);
+    POINTERS_EQUAL(NULL, argv[3]);
+    /* The strings follow the array in the same block. */
+    CHECK((char const *)argv < argv[0] && argv[2] < (char const *)argv + 64);
+
+    /* cleanup */
+    free(argv);
+    readline_context_destroy(readline_ctx);
+    close(stdin_pipe[0]);
+    close(stdin_pipe[1]);
+    close(stdout_pipe[0]);
+    close(stdout_pipe[1]);
+}
+
+TEST(readline, command_is_matched_against_grammar)
+{
+    int stdin_pipe[2];
+    int stdout_pipe[2];
+    readline_st * readline_ctx;
+    command_grammar_st * grammar;
+    readline_result_t result;
+    size_t argc;
+    char const * * argv;
+    command_st command;
+
+    /* setup */
+    pipe(stdin_pipe);
+    pipe(stdout_pipe);
+    mock().disable();
+    readline_ctx = readline_context_create(NULL, NULL, NULL, '\0', stdin_pipe[0], stdout_pipe[1], 0);
+    CHECK(readline_ctx != NULL);
+    grammar = command_grammar_create();
+    CHECK_TRUE(command_grammar_add(grammar, "ping <word> count <number>", 7));
+    dprintf(stdin_pipe[1], "pi 'my host' co 3\n");
+    dprintf(stdin_pipe[1], "pi host co x\n");
+
+    /* perform test */
+    result = readline_command(readline_ctx, 0, "", grammar, &argc, &argv, &command);
+
+    /* check results */
+    LONGS_EQUAL(readline_result_success, result);
+    LONGS_EQUAL(command_syntax_ok, command.syntax);
+    LONGS_EQUAL(7, command.id);
+    LONGS_EQUAL(4, argc);
+    STRCMP_EQUAL("my host", argv[1]);
+    LONGS_EQUAL(command_arg_word, command.args[1].type);
+    /* The span is of the arg as it was typed, quotes and all. */
+    LONGS_EQUAL(3, command.args[1].line_index);
+    LONGS_EQUAL(9, command.args[1].length);
+    LONGS_EQUAL(3, command.args[3].number);
+    LONGS_EQUAL(17, command.error_line_index);
+    free(argv);
+
+    result = readline_command(readline_ctx, 0, "", grammar, &argc, &argv, &command);
+    LONGS_EQUAL(readline_result_success, result);
+    LONGS_EQUAL(command_syntax_bad_number, command.syntax);
+    LONGS_EQUAL(3, command.error_index);
+    LONGS_EQUAL(11, command.error_line_index);
+
+    /* cleanup */
+    free(argv);
+    command_grammar_destroy(grammar);
+    readline_context_destroy(readline_ctx);
+    close(stdin_pipe[0]);
+    close(stdin_pipe[1]);
+    close(stdout_pipe[0]);
+    close(stdout_pipe[1]);
+}
+
 static void write_control_sequence(int const fd, char control_char)
 {
     dprintf(fd, "%c", CTL(control_char));
@@ -298,3 +395,676 @@ TEST(readline, move_right_words_when_already_at_rightmost_has_no_effect)
     child_process(stdin_pipe[0], stdout_pipe[1], "abc def hij2");
 }
 
+static bool ends_with_backslash(char const * const input, void * const user_context)
+{
+    size_t const length = strlen(input);
+
+    (void)user_context;
+
+    return length > 0 && input[length - 1] == '\\';
+}
+
+static char const * const keywords[] = {"show", "shutdown", "interface"};
+
+static int complete_keywords(completion_context_st * const completion_context, void * const user_context)
+{
+    char const * const current_token = completion_context->tokens_get_current_token_fn(completion_context);
+    size_t index;
+
+    (void)user_context;
+
+    for (index = 0; index < sizeof keywords / sizeof keywords[0]; index++)
+    {
+        if (strncmp(keywords[index], current_token, strlen(current_token)) == 0)
+        {
+            completion_context->possible_word_add_fn(completion_context, keywords[index]);
+        }
+    }
+
+    return 0;
+}
+
+/* Added out of order, so that the common prefix is only right if 
+ * the words are sorted first. 
+ */
+static char const * const ports[] = {"port2", "pot", "port10"};
+
+static int complete_ports(completion_context_st * const completion_context, void * const user_context)
+{
+    size_t index;
+
+    (void)user_context;
+
+    for (index = 0; index < sizeof ports / sizeof ports[0]; index++)
+    {
+        completion_context->possible_word_add_fn(completion_context, ports[index]);
+    }
+
+    return 0;
+}
+
+static char help_tokens[64];
+
+/* Records the tokens seen by the help callback, separated by ','. */
+static int record_help_tokens(help_context_st * const help_context, void * const user_context)
+{
+    size_t index;
+
+    (void)user_context;
+
+    help_tokens[0] = '\0';
+    for (index = 0; index < help_context->num_tokens; index++)
+    {
+        if (index > 0)
+        {
+            strcat(help_tokens, ",");
+        }
+        strcat(help_tokens, help_context->tokens_get_token_at_index_fn(help_context, index));
+    }
+
+    return 0;
+}
+
+static int record_help_spans(help_context_st * const help_context, void * const user_context)
+{
+    token_span_st const * spans;
+    token_span_st current_span;
+    size_t num_spans;
+    size_t index;
+
+    (void)user_context;
+
+    help_tokens[0] = '\0';
+    num_spans = help_context->tokens_get_preceding_token_spans_fn(help_context, &spans);
+    for (index = 0; index < num_spans; index++)
+    {
+        strncat(help_tokens, spans[index].text, spans[index].length);
+        strcat(help_tokens, ",");
+    }
+    if (help_context->tokens_get_token_span_at_index_fn(help_context, help_context->current_token_index, &current_span))
+    {
+        strncat(help_tokens, current_span.text, current_span.length);
+    }
+
+    return 0;
+}
+
+static int record_help_segment(help_context_st * const help_context, void * const user_context)
+{
+    token_segment_st const * const segment = &help_context->current_segment;
+
+    (void)user_context;
+
+    snprintf(help_tokens, sizeof help_tokens, "%zu,%zu,%s",
+             segment->first_token_index, segment->num_tokens, segment->first_token);
+
+    return 0;
+}
+
+TEST_GROUP(readline_non_blocking)
+{
+    readline_st * readline_ctx;
+    int stdin_pipe[2];
+    int stdout_pipe[2];
+
+    void setup()
+    {
+        readline_ctx = NULL;
+        pipe(stdin_pipe);
+        pipe(stdout_pipe);
+        fcntl(stdin_pipe[0], F_SETFL, fcntl(stdin_pipe[0], F_GETFL) | O_NONBLOCK);
+    }
+
+    void teardown()
+    {
+        readline_context_destroy(readline_ctx);
+        close(stdin_pipe[0]);
+        close(stdin_pipe[1]);
+        close(stdout_pipe[0]);
+        close(stdout_pipe[1]);
+        mock().clear();
+    }
+
+    void create_context(void)
+    {
+        readline_ctx = readline_context_create(NULL,
+                                               NULL,
+                                               NULL,
+                                               '\0',
+                                               stdin_pipe[0],
+                                               stdout_pipe[1],
+                                               0);
+        CHECK(readline_ctx != NULL);
+        LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+    }
+
+    void check_pending(void)
+    {
+        char * line;
+
+        LONGS_EQUAL(readline_result_pending, readline_process_ready(readline_ctx, &line));
+        POINTERS_EQUAL(NULL, line);
+    }
+
+    void check_line(char const * const expected_line)
+    {
+        char * line;
+
+        LONGS_EQUAL(readline_result_success, readline_process_ready(readline_ctx, &line));
+        STRCMP_EQUAL(expected_line, line);
+        free(line);
+    }
+};
+
+TEST(readline_non_blocking, line_split_across_reads_no_tty)
+{
+    mock().disable();
+    create_context();
+
+    check_pending();
+    dprintf(stdin_pipe[1], "12");
+    check_pending();
+    dprintf(stdin_pipe[1], "34\n");
+    check_line("1234");
+}
+
+TEST(readline_non_blocking, escape_sequence_split_across_reads)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    create_context();
+
+    dprintf(stdin_pipe[1], "ab\033");
+    check_pending();
+    dprintf(stdin_pipe[1], "[");
+    check_pending();
+    dprintf(stdin_pipe[1], "D");
+    check_pending();
+    dprintf(stdin_pipe[1], "c\n");
+    check_line("acb");
+}
+
+TEST(readline_non_blocking, edits_in_middle_of_line)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    create_context();
+
+    /* Backspace, then delete, with the cursor between 'b' and 'c'. */
+    dprintf(stdin_pipe[1], "abcd\033[D\033[D\177\033[3~x\n");
+    check_line("axd");
+}
+
+TEST(readline_non_blocking, control_w_deletes_previous_word)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    create_context();
+
+    dprintf(stdin_pipe[1], "one two three\027\n");
+    check_line("one two ");
+}
+
+TEST(readline_non_blocking, alt_d_deletes_next_word)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    create_context();
+
+    dprintf(stdin_pipe[1], "one two three\001\033d\n");
+    check_line(" two three");
+}
+
+TEST(readline_non_blocking, control_u_deletes_to_start_of_line)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    create_context();
+
+    dprintf(stdin_pipe[1], "abc def\033[D\033[D\033[D\025\n");
+    check_line("def");
+}
+
+TEST(readline_non_blocking, undo_restores_text_deleted_by_control_u)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    create_context();
+
+    dprintf(stdin_pipe[1], "abc def\025\037\n");
+    check_line("abc def");
+}
+
+TEST(readline_non_blocking, undo_removes_typing_a_word_at_a_time)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    create_context();
+
+    dprintf(stdin_pipe[1], "show int\037x\n");
+    check_line("show x");
+}
+
+TEST(readline_non_blocking, undo_does_not_merge_transpose_into_delete)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    create_context();
+
+    /* Delete the 'c' of "abcd", then swap the 'b' and 'd'. */
+    dprintf(stdin_pipe[1], "abcd\001");
+    write_right_arrow_sequence(stdin_pipe[1]);
+    write_right_arrow_sequence(stdin_pipe[1]);
+    write_basic_escape_sequence(stdin_pipe[1], '3');
+    dprintf(stdin_pipe[1], "~\024\037\n");
+    check_line("abd");
+}
+
+TEST(readline_non_blocking, redo_reapplies_undone_edit)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    create_context();
+
+    dprintf(stdin_pipe[1], "abc def\027\037\037\033_\n");
+    check_line("abc def");
+}
+
+TEST(readline_non_blocking, control_y_yanks_text_deleted_by_control_k)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    create_context();
+
+    dprintf(stdin_pipe[1], "abc def\001\013x\031\031\n");
+    check_line("xabc defabc def");
+}
+
+TEST(readline_non_blocking, alt_y_replaces_yanked_text_with_previous_kill)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    create_context();
+
+    dprintf(stdin_pipe[1], "abc def\027\027\031\033y\n");
+    check_line("def");
+}
+
+TEST(readline_non_blocking, masked_text_is_not_saved_for_yanking)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    readline_ctx = readline_context_create(NULL, NULL, NULL, '\0', stdin_pipe[0], stdout_pipe[1], 0);
+    readline_set_mask_character(readline_ctx, '*');
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+
+    dprintf(stdin_pipe[1], "secret\001\013\031\n");
+    check_line("");
+    readline_set_mask_character(readline_ctx, '\0');
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+    dprintf(stdin_pipe[1], "\031\n");
+    check_line("");
+}
+
+TEST(readline_non_blocking, continuation_callback_joins_lines)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    create_context();
+    readline_set_continuation_callback(readline_ctx, ends_with_backslash, NULL);
+
+    dprintf(stdin_pipe[1], "abc \\\n");
+    check_pending();
+    dprintf(stdin_pipe[1], "def\n");
+    check_line("abc \\\ndef");
+}
+
+TEST(readline_non_blocking, up_arrow_moves_to_previous_row)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    create_context();
+    readline_set_continuation_callback(readline_ctx, ends_with_backslash, "+ ");
+
+    dprintf(stdin_pipe[1], "ab\\\ncd\033[Ax\033[By\n");
+    check_line("abx\\\ncdy");
+}
+
+TEST(readline_non_blocking, word_characters_are_part_of_a_word)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    create_context();
+    readline_set_word_characters(readline_ctx, "/");
+
+    dprintf(stdin_pipe[1], "show Gi0/1\027\n");
+    check_line("show ");
+}
+
+TEST(readline_non_blocking, maximum_line_length_is_honoured)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    readline_ctx = readline_context_create(NULL, NULL, NULL, '\0', stdin_pipe[0], stdout_pipe[1], 0);
+    readline_set_maximum_line_length(readline_ctx, 5);
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+
+    dprintf(stdin_pipe[1], "abcdefg\033[D\033[Dx\n");
+    check_line("abcde");
+}
+
+TEST(readline_non_blocking, input_left_over_is_used_by_next_line)
+{
+    readline_fds_st fds;
+
+    mock().disable();
+    create_context();
+
+    dprintf(stdin_pipe[1], "abc\ndef\n");
+    check_line("abc");
+
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+    readline_get_fds(readline_ctx, &fds);
+    LONGS_EQUAL(stdin_pipe[0], fds.read_fd);
+    CHECK_TRUE(fds.input_pending);
+    check_line("def");
+}
+
+TEST(readline_non_blocking, line_is_copied_into_caller_buffer)
+{
+    char buffer[16];
+    size_t length;
+
+    mock().disable();
+    create_context();
+
+    dprintf(stdin_pipe[1], "abc def\n");
+    LONGS_EQUAL(readline_result_success, readline_process_ready_into(readline_ctx, buffer, sizeof buffer, &length));
+    STRCMP_EQUAL("abc def", buffer);
+    LONGS_EQUAL(7, length);
+}
+
+TEST(readline_non_blocking, line_is_truncated_to_fit_caller_buffer)
+{
+    char buffer[4];
+    size_t length;
+
+    mock().disable();
+    create_context();
+
+    dprintf(stdin_pipe[1], "abc def\n");
+    LONGS_EQUAL(readline_result_success, readline_process_ready_into(readline_ctx, buffer, sizeof buffer, &length));
+    STRCMP_EQUAL("abc", buffer);
+    LONGS_EQUAL(7, length);
+}
+
+TEST(readline_non_blocking, borrowed_line_is_valid_until_next_line)
+{
+    char const * line;
+    size_t length;
+
+    mock().disable();
+    create_context();
+
+    LONGS_EQUAL(readline_result_pending, readline_process_ready_borrow(readline_ctx, &line, &length));
+    POINTERS_EQUAL(NULL, line);
+    LONGS_EQUAL(0, length);
+
+    dprintf(stdin_pipe[1], "abc\ndef\n");
+    LONGS_EQUAL(readline_result_success, readline_process_ready_borrow(readline_ctx, &line, &length));
+    STRCMP_EQUAL("abc", line);
+    LONGS_EQUAL(3, length);
+
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+    LONGS_EQUAL(readline_result_success, readline_process_ready_borrow(readline_ctx, &line, &length));
+    STRCMP_EQUAL("def", line);
+    LONGS_EQUAL(3, length);
+}
+
+TEST(readline_non_blocking, tab_completes_unique_match)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    readline_ctx = readline_context_create(NULL, complete_keywords, NULL, '\0', stdin_pipe[0], stdout_pipe[1], 0);
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+
+    dprintf(stdin_pipe[1], "show in\t\n");
+    check_line("show interface");
+}
+
+TEST(readline_non_blocking, tab_completes_common_prefix)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    readline_ctx = readline_context_create(NULL, complete_keywords, NULL, '\0', stdin_pipe[0], stdout_pipe[1], 0);
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+
+    dprintf(stdin_pipe[1], "s\t\n");
+    check_line("sh");
+}
+
+TEST(readline_non_blocking, tab_waits_for_queued_output_without_blocking)
+{
+    char buffer[4096];
+    readline_fds_st fds;
+
+    mock().expectOneCall("isatty").andReturnValue(1);
+    readline_ctx = readline_context_create(NULL, complete_keywords, NULL, '\0', stdin_pipe[0], stdout_pipe[1], 0);
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+
+    /* Fill the output pipe, so that the client appears not to be 
+     * reading its output. 
+     */
+    fcntl(stdout_pipe[1], F_SETFL, fcntl(stdout_pipe[1], F_GETFL) | O_NONBLOCK);
+    memset(buffer, 'x', sizeof buffer);
+    while (write(stdout_pipe[1], buffer, sizeof buffer) > 0)
+    {
+    }
+    readline_write_output(readline_ctx, "queued", strlen("queued"));
+
+    dprintf(stdin_pipe[1], "s\t\n");
+    check_pending();
+    readline_get_fds(readline_ctx, &fds);
+    LONGS_EQUAL(-1, fds.read_fd);
+    CHECK_FALSE(fds.input_pending);
+
+    /* Once the output has drained the TAB is processed. */
+    fcntl(stdout_pipe[0], F_SETFL, fcntl(stdout_pipe[0], F_GETFL) | O_NONBLOCK);
+    while (read(stdout_pipe[0], buffer, sizeof buffer) > 0)
+    {
+    }
+    LONGS_EQUAL(readline_result_success, readline_process_writable(readline_ctx));
+    readline_get_fds(readline_ctx, &fds);
+    CHECK_TRUE(fds.input_pending);
+    check_line("sh");
+}
+
+TEST(readline_non_blocking, output_past_limit_is_dropped_and_line_shown_again)
+{
+    char buffer[4096];
+    ssize_t bytes_read;
+
+    create_context();
+    readline_set_output_queue_limit(readline_ctx, 8);
+    dprintf(stdin_pipe[1], "ab");
+    check_pending();
+    fcntl(stdout_pipe[0], F_SETFL, fcntl(stdout_pipe[0], F_GETFL) | O_NONBLOCK);
+    while (read(stdout_pipe[0], buffer, sizeof buffer) > 0)
+    {
+    }
+
+    /* Fill the output pipe, so that nothing queued can be written. */
+    fcntl(stdout_pipe[1], F_SETFL, fcntl(stdout_pipe[1], F_GETFL) | O_NONBLOCK);
+    memset(buffer, 'x', sizeof buffer);
+    while (write(stdout_pipe[1], buffer, sizeof buffer) > 0)
+    {
+    }
+    CHECK_FALSE(readline_write_output(readline_ctx, "0123456789", strlen("0123456789")));
+
+    /* Once the output has drained the line is shown again. */
+    while (read(stdout_pipe[0], buffer, sizeof buffer) > 0)
+    {
+    }
+    LONGS_EQUAL(readline_result_success, readline_process_writable(readline_ctx));
+    bytes_read = read(stdout_pipe[0], buffer, sizeof buffer);
+    LONGS_EQUAL(strlen("01234567\nab"), bytes_read);
+    MEMCMP_EQUAL("01234567\nab", buffer, bytes_read);
+    dprintf(stdin_pipe[1], "c\n");
+    check_line("abc");
+}
+
+TEST(readline_non_blocking, tab_completes_prefix_common_to_all_words)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    readline_ctx = readline_context_create(NULL, complete_ports, NULL, '\0', stdin_pipe[0], stdout_pipe[1], 0);
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+
+    dprintf(stdin_pipe[1], "p\t\n");
+    check_line("po");
+}
+
+TEST(readline_non_blocking, help_callback_is_given_tokens)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    readline_ctx = readline_context_create(NULL, NULL, record_help_tokens, '?', stdin_pipe[0], stdout_pipe[1], 0);
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+
+    dprintf(stdin_pipe[1], "show int | count?\n");
+    check_line("show int | count");
+    STRCMP_EQUAL("show,int,|,count", help_tokens);
+}
+
+TEST(readline_non_blocking, help_callback_is_given_token_spans)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    readline_ctx = readline_context_create(NULL, NULL, record_help_spans, '?', stdin_pipe[0], stdout_pipe[1], 0);
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+
+    /* The span of the current token covers all of it. */
+    dprintf(stdin_pipe[1], "show \"a b\" interface\x1b[D\x1b[D?\n");
+    check_line("show \"a b\" interface");
+    STRCMP_EQUAL("show,a b,interface", help_tokens);
+}
+
+TEST(readline_non_blocking, help_callback_is_given_current_segment)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    readline_ctx = readline_context_create(NULL, NULL, record_help_segment, '?', stdin_pipe[0], stdout_pipe[1], 0);
+    readline_set_field_separators(readline_ctx, "|");
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+
+    dprintf(stdin_pipe[1], "show run | include ip?\n");
+    check_line("show run | include ip");
+    STRCMP_EQUAL("3,2,include", help_tokens);
+}
+
+TEST(readline_non_blocking, help_tokens_follow_edits_to_the_line)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    readline_ctx = readline_context_create(NULL, NULL, record_help_tokens, '?', stdin_pipe[0], stdout_pipe[1], 0);
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+
+    /* Ask for help, then insert a word at the start of the line 
+     * and ask again. 
+     */
+    dprintf(stdin_pipe[1], "show int?\x01no ?\n");
+    check_line("no show int");
+    STRCMP_EQUAL("no,show,int", help_tokens);
+}
+
+TEST(readline_non_blocking, reset_context_starts_afresh)
+{
+    mock().expectOneCall("isatty").andReturnValue(1);
+    mock().expectOneCall("isatty").andReturnValue(1);
+    readline_ctx = readline_context_create(NULL, NULL, NULL, '\0', stdin_pipe[0], stdout_pipe[1], 0);
+    readline_set_maximum_line_length(readline_ctx, 2);
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+
+    dprintf(stdin_pipe[1], "abc\n");
+    check_line("ab");
+
+    readline_context_reset(readline_ctx, NULL, stdin_pipe[0], stdout_pipe[1]);
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+    dprintf(stdin_pipe[1], "abc\n");
+    check_line("abc");
+}
+
+TEST(readline_non_blocking, pool_reuses_idle_context)
+{
+    readline_context_pool_st * pool;
+    readline_st * first_ctx;
+
+    mock().disable();
+    pool = readline_context_pool_create(1, NULL, NULL, '\0', 0);
+    first_ctx = readline_context_pool_get(pool, NULL, stdin_pipe[0], stdout_pipe[1]);
+    CHECK(first_ctx != NULL);
+    readline_context_pool_put(pool, first_ctx);
+
+    readline_ctx = readline_context_pool_get(pool, NULL, stdin_pipe[0], stdout_pipe[1]);
+    POINTERS_EQUAL(first_ctx, readline_ctx);
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+    dprintf(stdin_pipe[1], "abc\n");
+    check_line("abc");
+
+    readline_ctx = NULL;
+    readline_context_pool_put(pool, first_ctx);
+    readline_context_pool_destroy(pool);
+}
+
+TEST_GROUP(readline_telnet)
+{
+    readline_st * readline_ctx;
+    int sockets[2]; /* [0] is the server end, [1] the client end. */
+
+    void setup()
+    {
+        readline_ctx = NULL;
+        socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+        fcntl(sockets[0], F_SETFL, fcntl(sockets[0], F_GETFL) | O_NONBLOCK);
+        fcntl(sockets[1], F_SETFL, fcntl(sockets[1], F_GETFL) | O_NONBLOCK);
+        mock().disable();
+        readline_ctx = readline_context_create(NULL,
+                                               NULL,
+                                               NULL,
+                                               '\0',
+                                               sockets[0],
+                                               sockets[0],
+                                               0);
+        CHECK(readline_ctx != NULL);
+        readline_enable_telnet(readline_ctx);
+    }
+
+    void teardown()
+    {
+        readline_context_destroy(readline_ctx);
+        close(sockets[0]);
+        close(sockets[1]);
+        mock().clear();
+    }
+
+    size_t read_from_client_end(char * const buffer, size_t const buffer_size)
+    {
+        ssize_t const bytes_read = read(sockets[1], buffer, buffer_size);
+
+        return bytes_read > 0 ? bytes_read : 0;
+    }
+};
+
+TEST(readline_telnet, negotiation_is_sent_before_prompt)
+{
+    char const expected[] = "\377\373\001" "\377\373\003" "\377\375\037" "> ";
+    char buffer[64];
+    size_t bytes_read;
+
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, "> "));
+
+    bytes_read = read_from_client_end(buffer, sizeof buffer);
+    LONGS_EQUAL(sizeof expected - 1, bytes_read);
+    MEMCMP_EQUAL(expected, buffer, bytes_read);
+}
+
+TEST(readline_telnet, telnet_commands_are_removed_from_the_line)
+{
+    /* WILL NAWS, a window size update, then "ab" and CR NUL. */
+    char const input[] = "\377\373\037" "\377\372\037\000\144\000\030\377\360" "ab\r";
+    char expected_echo[] = "ab\r\n";
+    char buffer[64];
+    size_t bytes_read;
+    char * line;
+
+    LONGS_EQUAL(readline_result_success, readline_begin(readline_ctx, ""));
+    read_from_client_end(buffer, sizeof buffer); /* Discard the negotiation. */
+
+    /* sizeof input includes the NUL that follows the CR. */
+    write(sockets[1], input, sizeof input);
+
+    LONGS_EQUAL(readline_result_success, readline_process_ready(readline_ctx, &line));
+    STRCMP_EQUAL("ab", line);
+    free(line);
+
+    bytes_read = read_from_client_end(buffer, sizeof buffer);
+    LONGS_EQUAL(strlen(expected_echo), bytes_read);
+    MEMCMP_EQUAL(expected_echo, buffer, bytes_read);
+}
@@ -0,0 +1,109 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include <CppUTest/TestHarness.h>
+
+extern "C"
+{
+#include "rows.h"
+};
+
+#include <stdlib.h>
+#include <string.h>
+
+TEST_GROUP(rows)
+{
+    rows_st rows;
+
+    void setup()
+    {
+        rows_init(&rows);
+    }
+
+    void teardown()
+    {
+        rows_teardown(&rows);
+    }
+
+    void append(char const * const text)
+    {
+        CHECK_TRUE(rows_append(&rows, text, strlen(text)));
+    }
+
+    void check_row(size_t const index, char const * const expected)
+    {
+        row_st const * const row = rows_get_row(&rows, index);
+
+        CHECK_TRUE(row != NULL);
+        LONGS_EQUAL(strlen(expected), row->length);
+        CHECK_TRUE(memcmp(expected, rows_get_text(&rows, index), row->length) == 0);
+    }
+};
+
+TEST(rows, new_rows_are_empty)
+{
+    /* check results */
+    LONGS_EQUAL(0, rows_get_num_rows(&rows));
+    POINTERS_EQUAL(NULL, rows_get_row(&rows, 0));
+    STRCMP_EQUAL("", rows_get_all_text(&rows));
+}
+
+TEST(rows, appended_rows_are_separated_by_newlines)
+{
+    /* perform test */
+    append("first");
+    append("");
+    append("third");
+
+    /* check results */
+    LONGS_EQUAL(3, rows_get_num_rows(&rows));
+    check_row(0, "first");
+    check_row(1, "");
+    check_row(2, "third");
+    STRCMP_EQUAL("first\n\nthird", rows_get_all_text(&rows));
+}
+
+TEST(rows, setting_text_moves_following_rows)
+{
+    /* setup */
+    append("one");
+    append("two");
+    append("three");
+
+    /* perform test */
+    CHECK_TRUE(rows_set_text(&rows, 0, "a longer row", strlen("a longer row")));
+    CHECK_TRUE(rows_set_text(&rows, 1, "", 0));
+
+    /* check results */
+    check_row(0, "a longer row");
+    check_row(1, "");
+    check_row(2, "three");
+    STRCMP_EQUAL("a longer row\n\nthree", rows_get_all_text(&rows));
+}
+
+TEST(rows, set_text_of_missing_row_fails)
+{
+    /* setup */
+    append("one");
+
+    /* check results */
+    CHECK_FALSE(rows_set_text(&rows, 1, "two", 3));
+}
+
+TEST(rows, clear_removes_all_rows)
+{
+    /* setup */
+    append("one");
+    append("two");
+
+    /* perform test */
+    rows_clear(&rows);
+    append("three");
+
+    /* check results */
+    LONGS_EQUAL(1, rows_get_num_rows(&rows));
+    STRCMP_EQUAL("three", rows_get_all_text(&rows));
+}
@@ -0,0 +1,146 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include <CppUTest/TestHarness.h>
+
+extern "C"
+{
+#include "telnet.h"
+};
+
+#include <string.h>
+#include <unistd.h>
+
+TEST_GROUP(telnet)
+{
+    int fds[2];
+    telnet_st telnet;
+    output_queue_st replies;
+
+    void setup()
+    {
+        if (pipe(fds) != 0)
+        {
+            FAIL("pipe failed");
+        }
+        telnet_init(&telnet);
+        output_queue_init(&replies, fds[1]);
+    }
+
+    void teardown()
+    {
+        output_queue_teardown(&replies);
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    size_t filter(char * const data, size_t const length)
+    {
+        return telnet_filter_input(&telnet, data, length, &replies);
+    }
+};
+
+TEST(telnet, plain_characters_are_unchanged)
+{
+    char data[] = "show ip";
+    size_t length;
+
+    /* perform test */
+    length = filter(data, strlen(data));
+
+    /* check results */
+    LONGS_EQUAL(strlen("show ip"), length);
+    MEMCMP_EQUAL("show ip", data, length);
+    LONGS_EQUAL(0, output_queue_get_length(&replies));
+}
+
+TEST(telnet, cr_lf_and_cr_nul_become_new_line)
+{
+    char data[] = { 'a', '\r', '\n', 'b', '\r', '\0', 'c', '\r' };
+    size_t length;
+
+    /* perform test */
+    length = filter(data, sizeof data);
+
+    /* check results */
+    LONGS_EQUAL(6, length);
+    MEMCMP_EQUAL("a\nb\nc\n", data, length);
+}
+
+TEST(telnet, lf_after_cr_in_next_read_is_dropped)
+{
+    char first[] = { 'a', '\r' };
+    char second[] = { '\n', 'b' };
+    size_t length;
+
+    /* perform test */
+    filter(first, sizeof first);
+    length = filter(second, sizeof second);
+
+    /* check results */
+    LONGS_EQUAL(1, length);
+    LONGS_EQUAL('b', second[0]);
+}
+
+TEST(telnet, escaped_iac_is_kept)
+{
+    char data[] = { 'a', (char)255, (char)255, 'b' };
+    size_t length;
+
+    /* perform test */
+    length = filter(data, sizeof data);
+
+    /* check results */
+    LONGS_EQUAL(3, length);
+    MEMCMP_EQUAL("a\377b", data, length);
+}
+
+TEST(telnet, window_size_is_taken_from_naws_split_across_reads)
+{
+    char first[] = { (char)255, (char)250, 31, 0 };
+    char second[] = { (char)132, 0, 40, (char)255, (char)240, 'x' };
+    size_t length;
+
+    /* perform test */
+    length = filter(first, sizeof first);
+    LONGS_EQUAL(0, length);
+    length = filter(second, sizeof second);
+
+    /* check results */
+    LONGS_EQUAL(1, length);
+    LONGS_EQUAL('x', second[0]);
+    LONGS_EQUAL(132, telnet.width);
+    LONGS_EQUAL(40, telnet.height);
+    CHECK_TRUE(telnet.window_size_changed);
+}
+
+TEST(telnet, unsupported_options_are_refused)
+{
+    char data[] = { (char)255, (char)251, 24, (char)255, (char)253, 24 };
+    char expected_replies[] = { (char)255, (char)254, 24, (char)255, (char)252, 24 };
+    size_t length;
+
+    /* perform test */
+    length = filter(data, sizeof data);
+
+    /* check results */
+    LONGS_EQUAL(0, length);
+    LONGS_EQUAL(sizeof expected_replies, output_queue_get_length(&replies));
+    MEMCMP_EQUAL(expected_replies, replies.buffer, sizeof expected_replies);
+}
+
+TEST(telnet, interrupt_process_becomes_ctrl_c)
+{
+    char data[] = { 'a', (char)255, (char)244 };
+    size_t length;
+
+    /* perform test */
+    length = filter(data, sizeof data);
+
+    /* check results */
+    LONGS_EQUAL(2, length);
+    LONGS_EQUAL(3, data[1]);
+}
@@ -0,0 +1,128 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include <CppUTest/TestHarness.h>
+
+extern "C"
+{
+#include "token_class.h"
+};
+
+#include <stdlib.h>
+#include <string.h>
+
+TEST_GROUP(token_class)
+{
+    token_class_st token_class;
+
+    void setup()
+    {
+        token_class_init(&token_class, NULL);
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(token_class, characters_are_classified)
+{
+    /* perform test */
+    token_class_init(&token_class, "|;");
+
+    /* check results */
+    LONGS_EQUAL(token_char_plain, token_class_get(&token_class, 'a'));
+    LONGS_EQUAL(token_char_plain, token_class_get(&token_class, '\xe9'));
+    LONGS_EQUAL(token_char_whitespace, token_class_get(&token_class, ' '));
+    LONGS_EQUAL(token_char_whitespace, token_class_get(&token_class, '\t'));
+    LONGS_EQUAL(token_char_separator, token_class_get(&token_class, '|'));
+    LONGS_EQUAL(token_char_separator, token_class_get(&token_class, ';'));
+    LONGS_EQUAL(token_char_quote, token_class_get(&token_class, '"'));
+    LONGS_EQUAL(token_char_end, token_class_get(&token_class, '\0'));
+    LONGS_EQUAL(token_char_end, token_class_get(&token_class, '\n'));
+}
+
+TEST(token_class, whitespace_separator_is_whitespace)
+{
+    /* perform test */
+    token_class_init(&token_class, " ");
+
+    /* check results */
+    LONGS_EQUAL(token_char_whitespace, token_class_get(&token_class, ' '));
+}
+
+TEST(token_class, skip_plain_stops_at_each_class)
+{
+    char const text[] = "abcdefghijklmnopqrstuvwxyz0123456789|abcdefghijklmnopqrstuvwxyz0123456789\"abc def\x01\xff\tx";
+
+    /* setup */
+    token_class_init(&token_class, "|");
+
+    /* perform test */
+    /* check results */
+    LONGS_EQUAL(36, token_class_skip_plain(&token_class, text, 0, sizeof text - 1));
+    LONGS_EQUAL(36, token_class_skip_plain(&token_class, text, 36, sizeof text - 1));
+    LONGS_EQUAL(73, token_class_skip_plain(&token_class, text, 37, sizeof text - 1));
+    LONGS_EQUAL(77, token_class_skip_plain(&token_class, text, 74, sizeof text - 1));
+    LONGS_EQUAL(83, token_class_skip_plain(&token_class, text, 78, sizeof text - 1));
+    LONGS_EQUAL(strlen(text), token_class_skip_plain(&token_class, text, 84, sizeof text - 1));
+}
+
+TEST(token_class, skip_plain_at_every_alignment)
+{
+    size_t const length = 100;
+    char * const text = (char *)malloc(length + 1);
+    size_t start;
+
+    /* setup */
+    memset(text, 'x', length);
+    text[length] = '\0';
+
+    /* perform test */
+    /* check results */
+    for (start = 0; start <= length; start++)
+    {
+        LONGS_EQUAL(length, token_class_skip_plain(&token_class, text, start, length));
+    }
+
+    free(text);
+}
+
+TEST(token_class, skip_plain_stops_at_length)
+{
+    size_t const length = 40;
+    /* Not NUL terminated, so nothing past the length may be read. */
+    char * const text = (char *)malloc(length);
+    size_t start;
+
+    /* setup */
+    memset(text, 'x', length);
+
+    /* perform test */
+    /* check results */
+    for (start = 0; start <= length; start++)
+    {
+        size_t const shorter_length = start + 3 < length ? start + 3 : length;
+
+        LONGS_EQUAL(length, token_class_skip_plain(&token_class, text, start, length));
+        LONGS_EQUAL(shorter_length, token_class_skip_plain(&token_class, text, start, shorter_length));
+    }
+
+    free(text);
+}
+
+TEST(token_class, skip_plain_with_many_separators)
+{
+    char const text[] = "abcdefghijklmnopqrstuvwxyz0123456789%abc";
+
+    /* setup */
+    token_class_init(&token_class, "!#$%&()*+,-./");
+
+    /* perform test */
+    /* check results */
+    LONGS_EQUAL(token_char_separator, token_class_get(&token_class, '/'));
+    LONGS_EQUAL(36, token_class_skip_plain(&token_class, text, 0, sizeof text - 1));
+}
@@ -6,6 +6,10 @@
 
 #include <CppUTest/TestHarness.h>
 
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
 extern "C"
 {
 #include "tokenise.h"
@@ -13,17 +17,21 @@ extern "C"
 
 TEST_GROUP(tokenise)
 {
+    tokens_st tokens_storage;
     tokens_st * tokens;
+    token_class_st token_class;
 
     void setup()
     {
-        tokens = NULL;
+        tokens = &tokens_storage;
+        tokens_init(tokens);
+        token_class_init(&token_class, NULL);
     }
 
     void teardown()
     {
         /* cleanup */
-        tokens_free(tokens);
+        tokens_teardown(tokens);
     }
 
     void do_test(char const * const line, size_t const expected_num_tokens, char const * const * const expected_tokens)
@@ -31,7 +39,7 @@ TEST_GROUP(tokenise)
         size_t index;
 
         /* perform test */
-        tokens = tokenise_line(line, 0, 0, false, NULL);
+        CHECK_TRUE(tokenise_line(tokens, line, 0, 0, false, &token_class));
 
         /* check results */
         LONGS_EQUAL(expected_num_tokens, tokens_get_num_tokens(tokens));
@@ -125,19 +133,199 @@ TEST(tokenise, word_with_embedded_quote_not_split_in_two)
     do_test("test1\"test2", 1, expected_tokens);
 }
 
+TEST(tokenise, many_tokens)
+{
+    size_t const num_tokens = 10000;
+    char * const line = (char *)malloc(num_tokens * 2 + 1);
+    size_t index;
+
+    /* setup */
+    for (index = 0; index < num_tokens; index++)
+    {
+        line[index * 2] = 'a' + (index % 26);
+        line[index * 2 + 1] = ' ';
+    }
+    line[num_tokens * 2] = '\0';
+
+    /* perform test */
+    CHECK_TRUE(tokenise_line(tokens, line, 0, 0, false, &token_class));
+
+    /* check results */
+    LONGS_EQUAL(num_tokens, tokens_get_num_tokens(tokens));
+    STRCMP_EQUAL("a", tokens_get_token_at_index(tokens, 0));
+    STRCMP_EQUAL("p", tokens_get_token_at_index(tokens, num_tokens - 1));
+
+    free(line);
+}
+
+TEST(tokenise, single_quoted_word_includes_quotes)
+{
+    char const * expected_tokens[] = {"'test1 \"test2'", "x"};
+
+    do_test("'test1 \"test2' x", 2, expected_tokens);
+}
+
+TEST(tokenise, escaped_space_not_split_in_two)
+{
+    char const * expected_tokens[] = {"test1\\ test2"};
+
+    do_test("test1\\ test2", 1, expected_tokens);
+}
+
+TEST(tokenise, quoted_separator_not_split)
+{
+    char const * expected_tokens[] = {"a", "|", "\"b|c\"", "d\\|e"};
+
+    /* setup */
+    token_class_init(&token_class, "|");
+
+    /* perform test */
+    do_test("a|\"b|c\" d\\|e", 4, expected_tokens);
+}
+
+TEST(tokenise, long_tokens_are_split_at_separators)
+{
+    char const * expected_tokens[] = {"abcdefghijklmnopqrstuvwxyz0123456789", 
+                                      "|", 
+                                      "abcdefghijklmnopqrstuvwxyz", 
+                                      "0123456789"};
+
+    /* setup */
+    token_class_init(&token_class, "|");
+
+    /* perform test */
+    do_test("abcdefghijklmnopqrstuvwxyz0123456789|abcdefghijklmnopqrstuvwxyz\t0123456789", 4, expected_tokens);
+}
+
+TEST(tokenise, tokens_are_replaced_by_next_line)
+{
+    char const * expected_tokens[] = {"def"};
+
+    /* setup */
+    CHECK_TRUE(tokenise_line(tokens, "abc xyz", 0, 0, false, &token_class));
+
+    /* perform test */
+    do_test("def", 1, expected_tokens);
+}
+
+TEST_GROUP(tokenise_values)
+{
+    tokens_st tokens_storage;
+    tokens_st * tokens;
+    token_class_st token_class;
+
+    void setup()
+    {
+        tokens = &tokens_storage;
+        tokens_init(tokens);
+        token_class_init(&token_class, "|");
+    }
+
+    void teardown()
+    {
+        /* cleanup */
+        tokens_teardown(tokens);
+    }
+
+    void do_test(char const * const line, size_t const expected_num_tokens, char const * const * const expected_values)
+    {
+        size_t index;
+
+        /* perform test */
+        CHECK_TRUE(tokenise_line(tokens, line, 0, 0, false, &token_class));
+
+        /* check results */
+        LONGS_EQUAL(expected_num_tokens, tokens_get_num_tokens(tokens));
+        for (index = 0; index < expected_num_tokens; index++)
+        {
+            STRCMP_EQUAL(expected_values[index], tokens_get_token_value_at_index(tokens, index));
+        }
+    }
+};
+
+TEST(tokenise_values, plain_value_is_the_token)
+{
+    char const * expected_values[] = {"abc", "|", "def"};
+
+    do_test("abc|def", 3, expected_values);
+}
+
+TEST(tokenise_values, double_quotes_are_removed)
+{
+    char const * expected_values[] = {"test1 test2", "x"};
+
+    do_test("\"test1 test2\" x", 2, expected_values);
+}
+
+TEST(tokenise_values, single_quotes_are_removed)
+{
+    char const * expected_values[] = {"a \"b\" \\c"};
+
+    do_test("'a \"b\" \\c'", 1, expected_values);
+}
+
+TEST(tokenise_values, adjacent_quoted_parts_are_joined)
+{
+    char const * expected_values[] = {"ab c|d e"};
+
+    do_test("a\"b c\"'|d'\\ e", 1, expected_values);
+}
+
+TEST(tokenise_values, backslash_escapes_next_character)
+{
+    char const * expected_values[] = {"a b", "|", "\"", "\\"};
+
+    do_test("a\\ b \\| \\\" \\\\", 4, expected_values);
+}
+
+TEST(tokenise_values, only_quote_and_backslash_escaped_within_double_quotes)
+{
+    char const * expected_values[] = {"a\"b\\c\\d"};
+
+    do_test("\"a\\\"b\\\\c\\d\"", 1, expected_values);
+}
+
+TEST(tokenise_values, unterminated_quote_runs_to_end_of_line)
+{
+    char const * expected_values[] = {"x", "a | b "};
+
+    do_test("x 'a | b ", 2, expected_values);
+}
+
+TEST(tokenise_values, backslash_at_end_of_line_is_kept)
+{
+    char const * expected_values[] = {"a\\"};
+
+    do_test("a\\", 1, expected_values);
+}
+
+TEST(tokenise_values, current_token_has_quotes_removed)
+{
+    /* perform test */
+    CHECK_TRUE(tokenise_line(tokens, "ls \"my fi", 0, 8, true, &token_class));
+
+    /* check results */
+    LONGS_EQUAL(1, tokens_get_current_token_index(tokens));
+    STRCMP_EQUAL("my f", tokens_get_current_token(tokens));
+}
+
 TEST_GROUP(tokenise_cursor_index)
 {
+    tokens_st tokens_storage;
     tokens_st * tokens;
+    token_class_st token_class;
 
     void setup()
     {
-        tokens = NULL;
+        tokens = &tokens_storage;
+        tokens_init(tokens);
+        token_class_init(&token_class, NULL);
     }
 
     void teardown()
     {
         /* cleanup */
-        tokens_free(tokens);
+        tokens_teardown(tokens);
     }
 
     void do_test(char const * const line, 
@@ -146,7 +334,7 @@ TEST_GROUP(tokenise_cursor_index)
                  char const * const expected_current_token)
     {
         /* perform test */
-        tokens = tokenise_line(line, 0, cursor_index, true, NULL);
+        CHECK_TRUE(tokenise_line(tokens, line, 0, cursor_index, true, &token_class));
 
         /* check results */
         CHECK_TRUE(expected_current_token_index <= tokens_get_num_tokens(tokens));
@@ -208,3 +396,408 @@ TEST(tokenise_cursor_index, beyond_line_length)
     do_test("abc def  ", 12, 2, NULL);
 }
 
+TEST_GROUP(tokenise_segments)
+{
+    tokens_st tokens_storage;
+    tokens_st * tokens;
+    token_class_st token_class;
+
+    void setup()
+    {
+        tokens = &tokens_storage;
+        tokens_init(tokens);
+        token_class_init(&token_class, "|");
+    }
+
+    void teardown()
+    {
+        /* cleanup */
+        tokens_teardown(tokens);
+    }
+
+    void do_test(char const * const line,
+                 size_t const cursor_index,
+                 size_t const expected_first_token_index,
+                 size_t const expected_num_tokens,
+                 char const * const expected_first_token)
+    {
+        token_segment_st segment;
+
+        /* perform test */
+        CHECK_TRUE(tokenise_line(tokens, line, 0, cursor_index, true, &token_class));
+        tokens_get_current_segment(tokens, &segment);
+
+        /* check results */
+        LONGS_EQUAL(expected_first_token_index, segment.first_token_index);
+        LONGS_EQUAL(expected_num_tokens, segment.num_tokens);
+        if (expected_first_token != NULL)
+        {
+            STRCMP_EQUAL(expected_first_token, segment.first_token);
+        }
+        else
+        {
+            POINTERS_EQUAL(NULL, segment.first_token);
+        }
+    }
+};
+
+TEST(tokenise_segments, line_without_separators_is_one_segment)
+{
+    do_test("show ip route", 6, 0, 3, "show");
+}
+
+TEST(tokenise_segments, cursor_in_first_command)
+{
+    do_test("cat file | grep x | wc -l", 2, 0, 2, "cat");
+}
+
+TEST(tokenise_segments, cursor_in_middle_command)
+{
+    do_test("cat file | grep x | wc -l", 13, 3, 2, "grep");
+}
+
+TEST(tokenise_segments, cursor_in_last_command)
+{
+    do_test("cat file | grep x | wc -l", 25, 6, 2, "wc");
+}
+
+TEST(tokenise_segments, cursor_on_separator_is_in_command_before_it)
+{
+    do_test("cat file|grep", 9, 0, 2, "cat");
+}
+
+TEST(tokenise_segments, cursor_between_tokens_is_counted)
+{
+    /* The empty token at the cursor is the first in the segment. */
+    do_test("cat file |  grep x", 11, 3, 3, "");
+}
+
+TEST(tokenise_segments, empty_command_has_no_first_token)
+{
+    do_test("| grep", 0, 0, 1, "");
+    do_test("|| grep", 2, 1, 0, NULL);
+}
+
+TEST(tokenise_segments, quoted_separator_does_not_end_segment)
+{
+    do_test("grep \"a|b\" | wc", 3, 0, 2, "grep");
+}
+
+TEST_GROUP(tokenise_update)
+{
+    tokens_st tokens_storage;
+    tokens_st * tokens;
+    token_class_st token_class;
+
+    void setup()
+    {
+        tokens = &tokens_storage;
+        tokens_init(tokens);
+        token_class_init(&token_class, NULL);
+    }
+
+    void teardown()
+    {
+        /* cleanup */
+        tokens_teardown(tokens);
+    }
+
+    void check_tokens(size_t const expected_num_tokens, char const * const * const expected_tokens)
+    {
+        size_t index;
+
+        LONGS_EQUAL(expected_num_tokens, tokens_get_num_tokens(tokens));
+        for (index = 0; index < expected_num_tokens; index++)
+        {
+            STRCMP_EQUAL(expected_tokens[index], tokens_get_token_at_index(tokens, index));
+        }
+    }
+};
+
+TEST(tokenise_update, edit_in_middle_of_line_is_tokenised_again)
+{
+    char const * expected_tokens[] = {"abc", "dXf", "ghi"};
+
+    /* setup */
+    CHECK_TRUE(tokens_update(tokens, "abc def ghi", strlen("abc def ghi"), &token_class, SIZE_MAX));
+
+    /* perform test */
+    tokens_line_changed(tokens, 5);
+    CHECK_TRUE(tokens_update(tokens, "abc dXf ghi", strlen("abc dXf ghi"), &token_class, SIZE_MAX));
+
+    /* check results */
+    check_tokens(3, expected_tokens);
+}
+
+TEST(tokenise_update, unchanged_line_is_not_tokenised_again)
+{
+    char const * expected_tokens[] = {"abc", "def"};
+
+    /* setup */
+    CHECK_TRUE(tokens_update(tokens, "abc def", strlen("abc def"), &token_class, SIZE_MAX));
+
+    /* perform test */
+    /* Nothing has been reported as changed, so the new text 
+     * isn't looked at. 
+     */
+    CHECK_TRUE(tokens_update(tokens, "xyz", strlen("xyz"), &token_class, SIZE_MAX));
+
+    /* check results */
+    check_tokens(2, expected_tokens);
+}
+
+TEST(tokenise_update, appending_extends_last_token)
+{
+    char const * expected_tokens[] = {"abc", "def"};
+
+    /* setup */
+    CHECK_TRUE(tokens_update(tokens, "abc de", strlen("abc de"), &token_class, SIZE_MAX));
+
+    /* perform test */
+    tokens_line_changed(tokens, 6);
+    CHECK_TRUE(tokens_update(tokens, "abc def", strlen("abc def"), &token_class, SIZE_MAX));
+
+    /* check results */
+    check_tokens(2, expected_tokens);
+}
+
+TEST(tokenise_update, inserting_separator_splits_token)
+{
+    char const * expected_tokens[] = {"abc", "|", "def"};
+
+    /* setup */
+    token_class_init(&token_class, "|");
+    CHECK_TRUE(tokens_update(tokens, "abcdef", strlen("abcdef"), &token_class, SIZE_MAX));
+
+    /* perform test */
+    tokens_line_changed(tokens, 3);
+    CHECK_TRUE(tokens_update(tokens, "abc|def", strlen("abc|def"), &token_class, SIZE_MAX));
+
+    /* check results */
+    check_tokens(3, expected_tokens);
+}
+
+TEST(tokenise_update, deleting_space_joins_tokens)
+{
+    char const * expected_tokens[] = {"abcdef", "ghi"};
+
+    /* setup */
+    CHECK_TRUE(tokens_update(tokens, "abc def ghi", strlen("abc def ghi"), &token_class, SIZE_MAX));
+
+    /* perform test */
+    tokens_line_changed(tokens, 3);
+    CHECK_TRUE(tokens_update(tokens, "abcdef ghi", strlen("abcdef ghi"), &token_class, SIZE_MAX));
+
+    /* check results */
+    check_tokens(2, expected_tokens);
+}
+
+TEST(tokenise_update, cursor_between_tokens_adds_empty_token)
+{
+    char const * expected_tokens[] = {"abc", "", "def"};
+
+    /* setup */
+    CHECK_TRUE(tokens_update(tokens, "abc  def", strlen("abc  def"), &token_class, SIZE_MAX));
+
+    /* perform test */
+    CHECK_TRUE(tokens_set_cursor(tokens, "abc  def", 4));
+
+    /* check results */
+    check_tokens(3, expected_tokens);
+    LONGS_EQUAL(1, tokens_get_current_token_index(tokens));
+    STRCMP_EQUAL("", tokens_get_current_token(tokens));
+}
+
+TEST(tokenise_update, moving_cursor_leaves_tokens_unchanged)
+{
+    char const * expected_tokens[] = {"abc", "def"};
+
+    /* setup */
+    CHECK_TRUE(tokens_update(tokens, "abc  def", strlen("abc  def"), &token_class, SIZE_MAX));
+    CHECK_TRUE(tokens_set_cursor(tokens, "abc  def", 4));
+
+    /* perform test */
+    CHECK_TRUE(tokens_update(tokens, "abc  def", strlen("abc  def"), &token_class, SIZE_MAX));
+    CHECK_TRUE(tokens_set_cursor(tokens, "abc  def", 7));
+
+    /* check results */
+    check_tokens(2, expected_tokens);
+    LONGS_EQUAL(1, tokens_get_current_token_index(tokens));
+    STRCMP_EQUAL("de", tokens_get_current_token(tokens));
+}
+
+TEST(tokenise_update, token_spans_refer_to_line)
+{
+    char const line[] = "ab \"c d\"  ef";
+    token_span_st span;
+
+    /* setup */
+    CHECK_TRUE(tokens_update(tokens, line, strlen(line), &token_class, SIZE_MAX));
+    CHECK_TRUE(tokens_set_cursor(tokens, line, 9));
+
+    /* perform test */
+    /* check results */
+    CHECK_TRUE(tokens_get_token_span(tokens, line, 0, &span));
+    POINTERS_EQUAL(&line[0], span.text);
+    LONGS_EQUAL(2, span.length);
+    /* The quotes are removed from a quoted token. */
+    CHECK_TRUE(tokens_get_token_span(tokens, line, 1, &span));
+    LONGS_EQUAL(3, span.length);
+    CHECK_TRUE(memcmp("c d", span.text, span.length) == 0);
+    LONGS_EQUAL(3, span.line_index);
+    /* The empty token at the cursor. */
+    CHECK_TRUE(tokens_get_token_span(tokens, line, 2, &span));
+    LONGS_EQUAL(0, span.length);
+    LONGS_EQUAL(9, span.line_index);
+    CHECK_TRUE(tokens_get_token_span(tokens, line, 3, &span));
+    LONGS_EQUAL(10, span.line_index);
+    CHECK_FALSE(tokens_get_token_span(tokens, line, 4, &span));
+}
+
+TEST(tokenise_update, preceding_token_spans_are_returned_together)
+{
+    char const line[] = "abc def ghi";
+    token_span_st const * spans;
+
+    /* setup */
+    CHECK_TRUE(tokens_update(tokens, line, strlen(line), &token_class, SIZE_MAX));
+    CHECK_TRUE(tokens_set_cursor(tokens, line, 9));
+
+    /* perform test */
+    LONGS_EQUAL(2, tokens_get_preceding_token_spans(tokens, line, &spans));
+
+    /* check results */
+    POINTERS_EQUAL(&line[0], spans[0].text);
+    LONGS_EQUAL(3, spans[0].length);
+    POINTERS_EQUAL(&line[4], spans[1].text);
+    LONGS_EQUAL(4, spans[1].line_index);
+}
+
+TEST_GROUP(tokenise_lazily)
+{
+    tokens_st tokens_storage;
+    tokens_st * tokens;
+    token_class_st token_class;
+
+    void setup()
+    {
+        tokens = &tokens_storage;
+        tokens_init(tokens);
+        token_class_init(&token_class, "|");
+    }
+
+    void teardown()
+    {
+        /* cleanup */
+        tokens_teardown(tokens);
+    }
+
+    void update(char const * const line, size_t const cursor_index)
+    {
+        CHECK_TRUE(tokens_update(tokens, line, strlen(line), &token_class, cursor_index));
+        CHECK_TRUE(tokens_set_cursor(tokens, line, cursor_index));
+    }
+};
+
+TEST(tokenise_lazily, tokens_after_cursor_are_found_when_asked_for)
+{
+    /* setup */
+    update("abc def ghi jkl", 5);
+
+    /* perform test */
+    LONGS_EQUAL(2, tokens_get_num_tokens(tokens));
+    CHECK_TRUE(tokens_find_token(tokens, 2));
+    LONGS_EQUAL(3, tokens_get_num_tokens(tokens));
+    CHECK_FALSE(tokens_find_token(tokens, 4));
+
+    /* check results */
+    LONGS_EQUAL(4, tokens_get_num_tokens(tokens));
+    STRCMP_EQUAL("ghi", tokens_get_token_at_index(tokens, 2));
+    STRCMP_EQUAL("jkl", tokens_get_token_at_index(tokens, 3));
+    STRCMP_EQUAL("d", tokens_get_current_token(tokens));
+}
+
+TEST(tokenise_lazily, empty_token_at_cursor_is_counted)
+{
+    /* setup */
+    update("ab  cd ef", 3);
+
+    /* perform test */
+    /* The scan stops once it finds a token after the cursor. */
+    LONGS_EQUAL(3, tokens_get_num_tokens(tokens));
+    CHECK_TRUE(tokens_find_token(tokens, 1));
+    CHECK_TRUE(tokens_find_token(tokens, 3));
+
+    /* check results */
+    LONGS_EQUAL(4, tokens_get_num_tokens(tokens));
+    LONGS_EQUAL(1, tokens_get_current_token_index(tokens));
+    STRCMP_EQUAL("", tokens_get_token_at_index(tokens, 1));
+    STRCMP_EQUAL("cd", tokens_get_token_at_index(tokens, 2));
+    STRCMP_EQUAL("ef", tokens_get_token_at_index(tokens, 3));
+}
+
+TEST(tokenise_lazily, text_already_returned_does_not_move)
+{
+    char line[1024];
+    char const * current_token;
+    char const * first_token;
+    size_t index;
+
+    /* setup */
+    strcpy(line, "'a b' c");
+    for (index = strlen(line); index < sizeof line - 3; index += 2)
+    {
+        strcpy(&line[index], " x");
+    }
+    update(line, 2);
+    current_token = tokens_get_current_token(tokens);
+    first_token = tokens_get_token_value_at_index(tokens, 0);
+
+    /* perform test */
+    CHECK_TRUE(tokens_find_all(tokens));
+
+    /* check results */
+    CHECK_TRUE(tokens_get_num_tokens(tokens) > 500);
+    POINTERS_EQUAL(current_token, tokens_get_current_token(tokens));
+    POINTERS_EQUAL(first_token, tokens_get_token_value_at_index(tokens, 0));
+    STRCMP_EQUAL("a", current_token);
+    STRCMP_EQUAL("a b", first_token);
+}
+
+TEST(tokenise_lazily, edit_after_tokens_found_so_far)
+{
+    char const * expected_tokens[] = {"abc", "def", "gXi", "jkl"};
+    size_t index;
+
+    /* setup */
+    update("abc def ghi jkl", 1);
+
+    /* perform test */
+    tokens_line_changed(tokens, 9);
+    update("abc def gXi jkl", 1);
+    CHECK_TRUE(tokens_find_all(tokens));
+
+    /* check results */
+    LONGS_EQUAL(4, tokens_get_num_tokens(tokens));
+    for (index = 0; index < 4; index++)
+    {
+        STRCMP_EQUAL(expected_tokens[index], tokens_get_token_at_index(tokens, index));
+    }
+}
+
+TEST(tokenise_lazily, segment_end_is_found_when_asked_for)
+{
+    token_segment_st segment;
+
+    /* setup */
+    update("a b c | d e", 0);
+
+    /* perform test */
+    tokens_get_current_segment(tokens, &segment);
+
+    /* check results */
+    LONGS_EQUAL(0, segment.first_token_index);
+    LONGS_EQUAL(3, segment.num_tokens);
+    STRCMP_EQUAL("a", segment.first_token);
+    LONGS_EQUAL(4, tokens_get_num_tokens(tokens));
+}
@@ -0,0 +1,225 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include <CppUTest/TestHarness.h>
+
+extern "C"
+{
+#include "undo_log.h"
+};
+
+#include <stdlib.h>
+#include <string.h>
+
+TEST_GROUP(undo_log)
+{
+    undo_log_st undo_log;
+
+    void setup()
+    {
+        undo_log_init(&undo_log, 1024);
+    }
+
+    void teardown()
+    {
+        undo_log_teardown(&undo_log);
+    }
+
+    void type(size_t index, char const * const string)
+    {
+        size_t i;
+
+        for (i = 0; string[i] != '\0'; i++, index++)
+        {
+            undo_log_begin_typing(&undo_log);
+            undo_log_record(&undo_log, undo_operation_insert, index, &string[i], 1);
+            undo_log_end_typing(&undo_log);
+        }
+    }
+
+    void backspace(size_t const index, char const * const deleted)
+    {
+        undo_log_begin_typing(&undo_log);
+        undo_log_record(&undo_log, undo_operation_delete, index, deleted, 1);
+        undo_log_end_typing(&undo_log);
+    }
+
+    void check_record(undo_record_st const * const record, 
+                      undo_operation_t const operation, 
+                      size_t const index, 
+                      char const * const text)
+    {
+        CHECK_TRUE(record != NULL);
+        LONGS_EQUAL(operation, record->operation);
+        LONGS_EQUAL(index, record->index);
+        LONGS_EQUAL(strlen(text), record->length);
+        CHECK_TRUE(memcmp(text, undo_log_get_text(&undo_log, record), record->length) == 0);
+    }
+};
+
+TEST(undo_log, nothing_to_undo_in_new_log)
+{
+    /* check results */
+    POINTERS_EQUAL(NULL, undo_log_undo(&undo_log));
+    POINTERS_EQUAL(NULL, undo_log_redo(&undo_log));
+}
+
+TEST(undo_log, consecutive_typing_is_merged_into_one_record)
+{
+    /* perform test */
+    type(0, "abc");
+
+    /* check results */
+    LONGS_EQUAL(1, undo_log.num_records);
+    check_record(undo_log_undo(&undo_log), undo_operation_insert, 0, "abc");
+    POINTERS_EQUAL(NULL, undo_log_undo(&undo_log));
+}
+
+TEST(undo_log, typing_starts_a_new_record_at_each_word)
+{
+    /* perform test */
+    type(0, "show int");
+
+    /* check results */
+    check_record(undo_log_undo(&undo_log), undo_operation_insert, 5, "int");
+    check_record(undo_log_undo(&undo_log), undo_operation_insert, 0, "show ");
+}
+
+TEST(undo_log, typing_elsewhere_starts_a_new_record)
+{
+    /* setup */
+    type(0, "ac");
+
+    /* perform test */
+    type(1, "b");
+
+    /* check results */
+    check_record(undo_log_undo(&undo_log), undo_operation_insert, 1, "b");
+    check_record(undo_log_undo(&undo_log), undo_operation_insert, 0, "ac");
+}
+
+TEST(undo_log, backspaces_are_merged_in_line_order)
+{
+    /* perform test */
+    backspace(2, "c");
+    backspace(1, "b");
+    backspace(0, "a");
+
+    /* check results */
+    LONGS_EQUAL(1, undo_log.num_records);
+    check_record(undo_log_undo(&undo_log), undo_operation_delete, 0, "abc");
+}
+
+TEST(undo_log, single_character_edit_other_than_typing_is_not_merged)
+{
+    /* setup */
+    backspace(2, "c");
+
+    /* perform test */
+    undo_log_record(&undo_log, undo_operation_delete, 1, "b", 1);
+    backspace(0, "a");
+
+    /* check results */
+    LONGS_EQUAL(3, undo_log.num_records);
+    check_record(undo_log_undo(&undo_log), undo_operation_delete, 0, "a");
+    check_record(undo_log_undo(&undo_log), undo_operation_delete, 1, "b");
+}
+
+TEST(undo_log, records_in_a_group_are_joined)
+{
+    /* perform test */
+    undo_log_begin_group(&undo_log);
+    undo_log_record(&undo_log, undo_operation_delete, 0, "old", 3);
+    undo_log_record(&undo_log, undo_operation_insert, 0, "new", 3);
+    undo_log_end_group(&undo_log);
+
+    /* check results */
+    undo_record_st const * record = undo_log_undo(&undo_log);
+    check_record(record, undo_operation_insert, 0, "new");
+    CHECK_TRUE(record->joined_to_previous);
+    record = undo_log_undo(&undo_log);
+    check_record(record, undo_operation_delete, 0, "old");
+    CHECK_FALSE(record->joined_to_previous);
+}
+
+TEST(undo_log, undone_record_can_be_redone)
+{
+    /* setup */
+    type(0, "abc");
+    undo_log_undo(&undo_log);
+
+    /* perform test */
+    undo_record_st const * const record = undo_log_redo(&undo_log);
+
+    /* check results */
+    check_record(record, undo_operation_insert, 0, "abc");
+    POINTERS_EQUAL(NULL, undo_log_redo(&undo_log));
+}
+
+TEST(undo_log, new_edit_discards_records_to_redo)
+{
+    /* setup */
+    type(0, "abc");
+    undo_log_undo(&undo_log);
+
+    /* perform test */
+    type(0, "x");
+
+    /* check results */
+    POINTERS_EQUAL(NULL, undo_log_redo(&undo_log));
+    check_record(undo_log_undo(&undo_log), undo_operation_insert, 0, "x");
+    POINTERS_EQUAL(NULL, undo_log_undo(&undo_log));
+}
+
+TEST(undo_log, oldest_records_are_discarded_at_limit)
+{
+    char text[100];
+    size_t i;
+
+    /* setup */
+    memset(text, 'a', sizeof text);
+
+    /* perform test */
+    for (i = 0; i < 50; i++)
+    {
+        undo_log_record(&undo_log, undo_operation_insert, i * sizeof text, text, sizeof text);
+    }
+
+    /* check results */
+    CHECK_TRUE(undo_log.num_records * sizeof(undo_record_st) + undo_log.text_length <= 1024);
+    CHECK_TRUE(undo_log.text_size <= 1024);
+    /* The newest edit is kept. */
+    undo_record_st const * const record = undo_log_undo(&undo_log);
+    CHECK_TRUE(record != NULL);
+    LONGS_EQUAL(49 * sizeof text, record->index);
+}
+
+TEST(undo_log, edit_larger_than_limit_clears_log)
+{
+    char text[2000];
+
+    /* setup */
+    memset(text, 'a', sizeof text);
+    type(0, "abc");
+
+    /* perform test */
+    undo_log_record(&undo_log, undo_operation_insert, 3, text, sizeof text);
+
+    /* check results */
+    POINTERS_EQUAL(NULL, undo_log_undo(&undo_log));
+}
+
+TEST(undo_log, suspended_log_records_nothing)
+{
+    /* setup */
+    undo_log.suspended = true;
+
+    /* perform test */
+    type(0, "abc");
+
+    /* check results */
+    POINTERS_EQUAL(NULL, undo_log_undo(&undo_log));
+}
@@ -0,0 +1,137 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include <CppUTest/TestHarness.h>
+
+extern "C"
+{
+#include "word_class.h"
+};
+
+#include <stdlib.h>
+#include <string.h>
+
+TEST_GROUP(word_class)
+{
+    word_class_st word_class;
+
+    void setup()
+    {
+        word_class_init(&word_class, NULL, NULL);
+    }
+
+    void teardown()
+    {
+    }
+
+    size_t skip_forward(char const * const text, bool const skip_word_chars)
+    {
+        return word_class_skip_forward(&word_class, text, strlen(text), skip_word_chars);
+    }
+
+    size_t skip_backward(char const * const text, bool const skip_word_chars)
+    {
+        return word_class_skip_backward(&word_class, text, strlen(text), skip_word_chars);
+    }
+};
+
+TEST(word_class, letters_and_digits_are_word_chars_by_default)
+{
+    /* check results */
+    CHECK_TRUE(word_class_is_word_char(&word_class, 'a'));
+    CHECK_TRUE(word_class_is_word_char(&word_class, 'Z'));
+    CHECK_TRUE(word_class_is_word_char(&word_class, '7'));
+    CHECK_FALSE(word_class_is_word_char(&word_class, '/'));
+    CHECK_FALSE(word_class_is_word_char(&word_class, ' '));
+    CHECK_FALSE(word_class_is_word_char(&word_class, '\xe9'));
+}
+
+TEST(word_class, extra_word_chars_are_added)
+{
+    /* perform test */
+    word_class_init(&word_class, "/-", NULL);
+
+    /* check results */
+    CHECK_TRUE(word_class_is_word_char(&word_class, '/'));
+    CHECK_TRUE(word_class_is_word_char(&word_class, '-'));
+    CHECK_FALSE(word_class_is_word_char(&word_class, '.'));
+}
+
+TEST(word_class, field_separators_are_never_word_chars)
+{
+    /* perform test */
+    word_class_init(&word_class, "/", "/x");
+
+    /* check results */
+    CHECK_FALSE(word_class_is_word_char(&word_class, '/'));
+    CHECK_FALSE(word_class_is_word_char(&word_class, 'x'));
+}
+
+TEST(word_class, skip_forward_short_text)
+{
+    /* check results */
+    LONGS_EQUAL(3, skip_forward("abc def", true));
+    LONGS_EQUAL(0, skip_forward("abc def", false));
+    LONGS_EQUAL(3, skip_forward("abc", true));
+}
+
+TEST(word_class, skip_backward_short_text)
+{
+    /* check results */
+    LONGS_EQUAL(4, skip_backward("abc def", true));
+    LONGS_EQUAL(7, skip_backward("abc def", false));
+    LONGS_EQUAL(0, skip_backward("abc", true));
+}
+
+TEST(word_class, skips_match_table_on_long_text)
+{
+    char text[10000];
+    size_t index;
+    size_t start;
+
+    /* setup */
+    word_class_init(&word_class, "_.", ";");
+    srand(1);
+    for (index = 0; index < sizeof text; index++)
+    {
+        /* Mostly word characters, with all byte values appearing. */
+        text[index] = (rand() % 8) != 0 ? "abcXYZ09_."[rand() % 10] : (char)(rand() % 255 + 1);
+    }
+
+    /* perform test */
+    for (start = 0; start < sizeof text; start += 97)
+    {
+        bool const skip_word_chars = word_class_is_word_char(&word_class, text[start]);
+        size_t const forward = start + word_class_skip_forward(&word_class, &text[start], sizeof text - start, skip_word_chars);
+        size_t const backward = word_class_skip_backward(&word_class, text, start + 1, skip_word_chars);
+
+        /* check results */
+        for (index = start; index < forward; index++)
+        {
+            CHECK_TRUE(word_class_is_word_char(&word_class, text[index]) == skip_word_chars);
+        }
+        CHECK_TRUE(forward == sizeof text || word_class_is_word_char(&word_class, text[forward]) != skip_word_chars);
+        for (index = backward; index <= start; index++)
+        {
+            CHECK_TRUE(word_class_is_word_char(&word_class, text[index]) == skip_word_chars);
+        }
+        CHECK_TRUE(backward == 0 || word_class_is_word_char(&word_class, text[backward - 1]) != skip_word_chars);
+    }
+}
+
+TEST(word_class, long_run_is_skipped)
+{
+    char text[10001];
+
+    /* setup */
+    memset(text, 'a', sizeof text - 1);
+    text[sizeof text - 1] = '\0';
+    text[5000] = ' ';
+
+    /* check results */
+    LONGS_EQUAL(5000, skip_forward(text, true));
+    LONGS_EQUAL(5001, skip_backward(text, true));
+}
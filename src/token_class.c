@@ -0,0 +1,139 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include "token_class.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define VECTOR_SIZE 16
+#endif
+
+/* The characters isspace() accepts in the "C" locale. */
+static bool is_ascii_space(unsigned int const ch)
+{
+    return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
+
+void token_class_init(token_class_st * const token_class, char const * const field_separators)
+{
+    unsigned int ch;
+    char const * p;
+    size_t const num_separators = field_separators != NULL ? strlen(field_separators) : 0;
+
+    /* Where a character is in more than one class, the one set 
+     * last wins. This matches the order the tokeniser used to 
+     * test the characters in. 
+     */
+    memset(token_class->char_class, token_char_plain, sizeof token_class->char_class);
+    token_class->char_class['\''] = token_char_quote;
+    token_class->char_class['\"'] = token_char_quote;
+    token_class->char_class['\\'] = token_char_escape;
+    for (p = field_separators; p != NULL && *p != '\0'; p++)
+    {
+        token_class->char_class[(unsigned char)*p] = token_char_separator;
+    }
+    for (ch = 0; ch < 256; ch++)
+    {
+        if (is_ascii_space(ch))
+        {
+            token_class->char_class[ch] = token_char_whitespace;
+        }
+    }
+    token_class->char_class['\0'] = token_char_end;
+    token_class->char_class['\n'] = token_char_end;
+
+    if (num_separators <= TOKEN_CLASS_MAXIMUM_VECTOR_SEPARATORS)
+    {
+        if (num_separators > 0)
+        {
+            memcpy(token_class->separators, field_separators, num_separators);
+        }
+        token_class->num_separators = num_separators;
+        token_class->can_use_vectors = true;
+    }
+    else
+    {
+        token_class->num_separators = 0;
+        token_class->can_use_vectors = false;
+    }
+}
+
+token_char_class_t token_class_get(token_class_st const * const token_class, char const ch)
+{
+    return (token_char_class_t)token_class->char_class[(unsigned char)ch];
+}
+
+#if defined(VECTOR_SIZE)
+/* Returns a bit for each of the 16 characters, set if it isn't a 
+ * plain character. This matches the table built by 
+ * token_class_init(). 
+ */
+static unsigned int get_non_plain_mask(token_class_st const * const token_class, char const * const text)
+{
+    __m128i const chars = _mm_loadu_si128((__m128i const *)text);
+    /* Unsigned compare of chars - '\t' against '\r' - '\t'. */
+    __m128i const offset = _mm_sub_epi8(chars, _mm_set1_epi8('\t'));
+    __m128i is_special = _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8('\r' - '\t')), offset);
+    size_t index;
+
+    is_special = _mm_or_si128(is_special, _mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')));
+    is_special = _mm_or_si128(is_special, _mm_cmpeq_epi8(chars, _mm_set1_epi8('\'')));
+    is_special = _mm_or_si128(is_special, _mm_cmpeq_epi8(chars, _mm_set1_epi8('\"')));
+    is_special = _mm_or_si128(is_special, _mm_cmpeq_epi8(chars, _mm_set1_epi8('\\')));
+    is_special = _mm_or_si128(is_special, _mm_cmpeq_epi8(chars, _mm_setzero_si128()));
+    for (index = 0; index < token_class->num_separators; index++)
+    {
+        is_special = _mm_or_si128(is_special, _mm_cmpeq_epi8(chars, _mm_set1_epi8(token_class->separators[index])));
+    }
+
+    return (unsigned int)_mm_movemask_epi8(is_special);
+}
+#endif
+
+/* Returns the index of the first character at or after 'index' 
+ * that isn't a plain character, or length if there is no such 
+ * character. 
+ */
+size_t token_class_skip_plain(token_class_st const * const token_class, 
+                              char const * const line, 
+                              size_t const index, 
+                              size_t const length)
+{
+    size_t skipped_index = index;
+    bool found = false;
+
+#if defined(VECTOR_SIZE)
+    while (token_class->can_use_vectors && !found && skipped_index + VECTOR_SIZE <= length)
+    {
+        unsigned int const mask = get_non_plain_mask(token_class, &line[skipped_index]);
+
+        if (mask != 0)
+        {
+            skipped_index += __builtin_ctz(mask);
+            found = true;
+        }
+        else
+        {
+            skipped_index += VECTOR_SIZE;
+        }
+    }
+#endif
+    while (!found && skipped_index < length)
+    {
+        if (token_class_get(token_class, line[skipped_index]) != token_char_plain)
+        {
+            found = true;
+        }
+        else
+        {
+            skipped_index++;
+        }
+    }
+
+    return skipped_index;
+}
@@ -0,0 +1,51 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#ifndef __TOKEN_CLASS_H__
+#define __TOKEN_CLASS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TOKEN_CLASS_MAXIMUM_VECTOR_SEPARATORS 8
+
+typedef enum token_char_class_t
+{
+    token_char_plain,
+    token_char_whitespace,
+    token_char_separator,
+    token_char_quote, /* A single or double quote. */
+    token_char_escape, /* A backslash. */
+    token_char_end /* The NUL or newline at the end of the line. */
+} token_char_class_t;
+
+typedef struct token_class_st token_class_st;
+/* Says how each character is treated when a line is split into 
+ * tokens, so that the tokeniser needs just one table lookup per 
+ * character. The table is built whenever the field separators 
+ * are set. 
+ * Runs of plain characters are skipped 16 characters at a time 
+ * using SSE2 where it is available, which needs the separators 
+ * to be compared individually, so is only done if there aren't 
+ * too many of them. 
+ */
+struct token_class_st
+{
+    unsigned char char_class[256];
+
+    bool can_use_vectors;
+    char separators[TOKEN_CLASS_MAXIMUM_VECTOR_SEPARATORS];
+    size_t num_separators;
+};
+
+void token_class_init(token_class_st * const token_class, char const * const field_separators);
+token_char_class_t token_class_get(token_class_st const * const token_class, char const ch);
+size_t token_class_skip_plain(token_class_st const * const token_class, 
+                              char const * const line, 
+                              size_t const index, 
+                              size_t const length);
+
+#endif /* __TOKEN_CLASS_H__ */
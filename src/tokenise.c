@@ -5,29 +5,77 @@
  */
 
 #include "tokenise.h"
-#include "strdup_partial.h"
+#include "utils.h"
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
-#include <ctype.h>
 #include <stdio.h>
 
-typedef struct token_st token_st;
-struct token_st
+#define TOKENS_MINIMUM_ARRAY_SIZE 8
+#define TOKENS_MINIMUM_TEXT_SIZE 64
+
+void tokens_init(tokens_st * const tokens)
 {
-    size_t start_index;
-    size_t end_index;
-    char * token;
-};
+    tokens->token_array = NULL;
+    tokens->token_array_size = 0;
+    tokens->text = NULL;
+    tokens->text_size = 0;
+    tokens->span_array = NULL;
+    tokens->span_array_size = 0;
+    tokens_clear(tokens);
+}
 
-struct tokens_st
+void tokens_teardown(tokens_st * const tokens)
 {
-    size_t current_token_index;
-    char const * current_token;
-    size_t count;
-    size_t token_array_size;
-    token_st * token_array;
-}; 
+    free(tokens->token_array);
+    free(tokens->text);
+    free(tokens->span_array);
+    tokens_init(tokens);
+}
+
+static void tokens_forget_current_token(tokens_st * const tokens)
+{
+    /* The current token's text is the last thing in the text block 
+     * unless more tokens have been found since. 
+     */
+    if (tokens->have_current_token && tokens->text_length == tokens->current_token_text_end)
+    {
+        tokens->text_length = tokens->current_token_offset;
+    }
+    tokens->current_token_index = 0;
+    tokens->current_token_offset = 0;
+    tokens->have_current_token = false;
+    tokens->cursor_is_between_tokens = false;
+}
+
+/* Forget the tokens, keeping the memory for the next line. */
+void tokens_clear(tokens_st * const tokens)
+{
+    tokens->count = 0;
+    tokens->text_length = 0;
+    tokens->unchanged_length = 0;
+    tokens->all_found = false;
+    tokens->line = NULL;
+    tokens->line_length = 0;
+    tokens->token_class = NULL;
+    tokens->have_current_token = false;
+    tokens_forget_current_token(tokens);
+}
+
+/* Forget the tokens, and give back the memory if more than 
+ * maximum_idle_size bytes is held. 
+ */
+void tokens_trim(tokens_st * const tokens, size_t const maximum_idle_size)
+{
+    tokens_clear(tokens);
+    if (tokens->token_array_size * sizeof *tokens->token_array 
+        + tokens->span_array_size * sizeof *tokens->span_array 
+        + tokens->text_size > maximum_idle_size)
+    {
+        tokens_teardown(tokens);
+    }
+}
 
 static bool tokens_ensure_space_for_new_token(tokens_st * const tokens)
 {
@@ -40,16 +88,16 @@ static bool tokens_ensure_space_for_new_token(tokens_st * const tokens)
         has_space = true;
         goto done;
     }
-    /* Make space for another token. */
-    new_token_array_size = tokens->token_array_size + 1;
-    new_token_array = calloc(new_token_array_size, sizeof *new_token_array);
+    /* The array doubles in size so that adding a token takes 
+     * constant time on average, however many tokens there are. 
+     */
+    new_token_array_size = MAX(tokens->token_array_size * 2, TOKENS_MINIMUM_ARRAY_SIZE);
+    new_token_array = realloc(tokens->token_array, new_token_array_size * sizeof *new_token_array);
     if (new_token_array == NULL)
     {
         has_space = false;
         goto done;
     }
-    memcpy(new_token_array, tokens->token_array, tokens->token_array_size * sizeof *new_token_array);
-    free(tokens->token_array);
     tokens->token_array = new_token_array;
     tokens->token_array_size = new_token_array_size;
     has_space = true;
@@ -58,90 +106,236 @@ done:
     return has_space;
 }
 
-static tokens_st * tokens_alloc(void)
+static bool tokens_ensure_space_for_text(tokens_st * const tokens, size_t const size_required)
 {
-    tokens_st * const tokens = calloc(1, sizeof *tokens);
+    bool has_space;
+
+    if (size_required > tokens->text_size)
+    {
+        size_t const new_text_size = MAX(MAX(tokens->text_size * 2, TOKENS_MINIMUM_TEXT_SIZE), size_required);
+        char * const new_text = realloc(tokens->text, new_text_size);
 
-    return tokens;
+        if (new_text == NULL)
+        {
+            has_space = false;
+            goto done;
+        }
+        tokens->text = new_text;
+        tokens->text_size = new_text_size;
+    }
+    has_space = true;
+
+done:
+    return has_space;
 }
 
-static bool check_if_cursor_index_within_token(size_t const cursor_index, size_t const start_index, size_t const end_index)
+/* Copy the characters of the line from start_index up to (but not 
+ * including) end_index onto the end of the text block, followed 
+ * by a NUL. The text is referred to by its offset into the block 
+ * so that the block can be moved when it grows. 
+ */
+static bool tokens_add_text(tokens_st * const tokens,
+                            char const * const line,
+                            size_t const start_index,
+                            size_t const end_index,
+                            size_t * const text_offset)
 {
-    bool const cursor_is_within_token = cursor_index >= start_index && cursor_index <= end_index;
+    bool added;
+    size_t const length = end_index - start_index;
+    size_t const size_required = tokens->text_length + length + 1;
 
-    return cursor_is_within_token;
+    if (!tokens_ensure_space_for_text(tokens, size_required))
+    {
+        added = false;
+        goto done;
+    }
+    if (length > 0)
+    {
+        memcpy(&tokens->text[tokens->text_length], &line[start_index], length);
+    }
+    tokens->text[tokens->text_length + length] = '\0';
+    *text_offset = tokens->text_length;
+    tokens->text_length = size_required;
+    added = true;
+
+done:
+    return added;
 }
 
-static bool create_cursor_token_if_cursor_index_fits_in_token(char const * const line,
-                                                              size_t const cursor_index,
-                                                              tokens_st * const tokens)
+/* Like tokens_add_text(), but the quotes are left out, and a 
+ * backslash is replaced by the character after it. Within double 
+ * quotes only a double quote or a backslash can be escaped, and 
+ * within single quotes nothing can. The value is never longer 
+ * than the text, so the space needed is known before starting. 
+ */
+static bool tokens_add_value(tokens_st * const tokens,
+                             char const * const line,
+                             size_t const start_index,
+                             size_t const end_index,
+                             size_t * const value_offset,
+                             size_t * const value_length)
 {
-    bool cursor_falls_within_token;
+    bool added;
+    size_t const size_required = tokens->text_length + (end_index - start_index) + 1;
+    char const single_quote = '\'';
+    char const double_quote = '\"';
+    char const escape = '\\';
+    enum quote_type_t
+    {
+        quote_type_none,
+        quote_type_single,
+        quote_type_double
+    };
+    enum quote_type_t quote_type;
+    char * value;
+    size_t length;
+    size_t index;
 
-    cursor_falls_within_token = check_if_cursor_index_within_token(cursor_index,
-                                                                  tokens->token_array[tokens->count].start_index,
-                                                                  tokens->token_array[tokens->count].end_index);
+    if (!tokens_ensure_space_for_text(tokens, size_required))
+    {
+        added = false;
+        goto done;
+    }
+    value = &tokens->text[tokens->text_length];
+    length = 0;
+    quote_type = quote_type_none;
 
-    if (cursor_falls_within_token)
+    for (index = start_index; index < end_index; index++)
     {
-        tokens->current_token_index = tokens->count;
-        /* Only include the part of the token from the start to the 
-         * current cursor position. 
-         */
-        tokens->current_token = strdup_partial(line,
-                                               tokens->token_array[tokens->count].start_index,
-                                               cursor_index);
+        char const ch = line[index];
+        bool is_literal = true;
+
+        if (quote_type == quote_type_single)
+        {
+            if (ch == single_quote)
+            {
+                quote_type = quote_type_none;
+                is_literal = false;
+            }
+        }
+        else if (quote_type == quote_type_double)
+        {
+            if (ch == double_quote)
+            {
+                quote_type = quote_type_none;
+                is_literal = false;
+            }
+            else if (ch == escape 
+                     && index + 1 < end_index 
+                     && (line[index + 1] == double_quote || line[index + 1] == escape))
+            {
+                is_literal = false;
+            }
+        }
+        else if (ch == single_quote)
+        {
+            quote_type = quote_type_single;
+            is_literal = false;
+        }
+        else if (ch == double_quote)
+        {
+            quote_type = quote_type_double;
+            is_literal = false;
+        }
+        else if (ch == escape && index + 1 < end_index)
+        {
+            is_literal = false;
+        }
+
+        if (is_literal)
+        {
+            value[length] = ch;
+            length++;
+        }
+        else if (ch == escape)
+        {
+            /* The escaped character is always literal. */
+            index++;
+            value[length] = line[index];
+            length++;
+        }
+    }
+    value[length] = '\0';
+    *value_offset = tokens->text_length;
+    *value_length = length;
+    tokens->text_length += length + 1;
+    added = true;
+
+done:
+    return added;
+}
+
+/* Where the segment that a token at 'index' in the token array 
+ * would be part of starts, given the tokens before it. A separator 
+ * is part of the segment it ends. 
+ */
+static size_t tokens_get_segment_start_index(tokens_st const * const tokens, size_t const index)
+{
+    size_t segment_start_index;
+
+    if (index == 0)
+    {
+        segment_start_index = 0;
+    }
+    else if (tokens->token_array[index - 1].is_separator)
+    {
+        segment_start_index = index;
+    }
+    else
+    {
+        segment_start_index = tokens->token_array[index - 1].segment_start_index;
     }
 
-    return cursor_falls_within_token;
+    return segment_start_index;
 }
 
-static bool populate_next_token(tokens_st * const tokens,
-                                char const * const line, 
-                                size_t const start_index, 
-                                size_t const end_index,
-                                bool const assign_token_to_cursor_index,
-                                bool * const done_cursor_index_token,
-                                size_t cursor_index)
+static bool add_token(tokens_st * const tokens,
+                      char const * const line, 
+                      size_t const start_index, 
+                      size_t const end_index,
+                      size_t const scan_end_index,
+                      size_t const resume_index,
+                      bool const is_separator,
+                      bool const is_quoted)
 {
-    bool populated_ok;
+    bool added_ok;
     token_st * token;
 
     if (!tokens_ensure_space_for_new_token(tokens))
     {
-        populated_ok = false;
+        added_ok = false;
         goto done;
     }
     token = &tokens->token_array[tokens->count];
-    token->token = strdup_partial(line, start_index, end_index);
-
-    if (token->token == NULL)
+    if (!tokens_add_text(tokens, line, start_index, end_index, &token->text_offset))
     {
-        populated_ok = false;
+        added_ok = false;
         goto done;
     }
-
-    token->start_index = start_index;
-    token->end_index = end_index;
-
-    if (assign_token_to_cursor_index)
+    if (!is_quoted)
     {
-        if (!(*done_cursor_index_token))
-        {
-            *done_cursor_index_token =
-                create_cursor_token_if_cursor_index_fits_in_token(line,
-                                                                  cursor_index,
-                                                                  tokens);
-        }
+        token->value_offset = token->text_offset;
+        token->value_length = end_index - start_index;
+    }
+    else if (!tokens_add_value(tokens, line, start_index, end_index, &token->value_offset, &token->value_length))
+    {
+        added_ok = false;
+        goto done;
     }
 
+    token->start_index = start_index;
+    token->end_index = end_index;
+    token->scan_end_index = scan_end_index;
+    token->resume_index = resume_index;
+    token->is_separator = is_separator;
+    token->is_quoted = is_quoted;
+    token->segment_start_index = tokens_get_segment_start_index(tokens, tokens->count);
     tokens->count++; 
 
-
-    populated_ok = true;
+    added_ok = true;
 
 done:
-    return populated_ok;
+    return added_ok;
 }
 
 size_t tokens_get_current_token_index(tokens_st const * const tokens)
@@ -164,9 +358,9 @@ char const * tokens_get_current_token(tokens_st const * const tokens)
 {
     char const * current_token;
 
-    if (tokens != NULL)
+    if (tokens != NULL && tokens->have_current_token)
     {
-        current_token = tokens->current_token;
+        current_token = &tokens->text[tokens->current_token_offset];
     }
     else
     {
@@ -176,25 +370,129 @@ char const * tokens_get_current_token(tokens_st const * const tokens)
     return current_token;
 }
 
-bool tokens_index_is_within_current_token(tokens_st const * const tokens, size_t const index)
+/* Returns the token at 'index', counting the empty token at the 
+ * cursor if the cursor is between tokens, or NULL if there is no 
+ * such token. 
+ */
+static token_st const * tokens_lookup(tokens_st const * const tokens, size_t const index)
 {
-    bool is_within_token;
-    token_st const * current_token;
+    token_st const * token;
+    size_t index_in_array;
 
     if (tokens == NULL)
     {
-        is_within_token = false;
+        token = NULL;
+        goto done;
+    }
+    if (tokens->cursor_is_between_tokens && index >= tokens->current_token_index)
+    {
+        if (index == tokens->current_token_index)
+        {
+            token = &tokens->cursor_token;
+            goto done;
+        }
+        /* The tokens after the cursor follow the empty one. */
+        index_in_array = index - 1;
+    }
+    else
+    {
+        index_in_array = index;
+    }
+    token = index_in_array < tokens->count ? &tokens->token_array[index_in_array] : NULL;
+
+done:
+    return token;
+}
+
+/* A token without quotes or escapes is referred to where it is in 
+ * the line rather than being copied, so the span is only valid 
+ * while the line is unchanged. 
+ */
+static void tokens_set_span(tokens_st const * const tokens, 
+                            char const * const line, 
+                            token_st const * const token, 
+                            token_span_st * const span)
+{
+    span->text = token->is_quoted ? &tokens->text[token->value_offset] : &line[token->start_index];
+    span->length = token->value_length;
+    span->line_index = token->start_index;
+}
+
+bool tokens_get_token_span(tokens_st const * const tokens, 
+                           char const * const line, 
+                           size_t const index, 
+                           token_span_st * const span)
+{
+    bool have_span;
+    token_st const * const token = tokens_lookup(tokens, index);
+
+    if (token == NULL)
+    {
+        have_span = false;
+        goto done;
+    }
+    tokens_set_span(tokens, line, token, span);
+    have_span = true;
+
+done:
+    return have_span;
+}
+
+/* Points 'spans' at the spans of all the tokens before the current 
+ * token and returns how many there are. The array is kept for 
+ * next time, so once it is big enough no memory is allocated. 
+ * Returns 0 if there wasn't enough memory. 
+ */
+size_t tokens_get_preceding_token_spans(tokens_st * const tokens, 
+                                        char const * const line, 
+                                        token_span_st const * * const spans)
+{
+    size_t const num_spans = tokens->have_current_token ? tokens->current_token_index : 0;
+    size_t index;
+
+    *spans = NULL;
+    if (num_spans == 0)
+    {
         goto done;
     }
+    if (num_spans > tokens->span_array_size)
+    {
+        size_t const new_span_array_size = MAX(MAX(tokens->span_array_size * 2, TOKENS_MINIMUM_ARRAY_SIZE), num_spans);
+        token_span_st * const new_span_array = realloc(tokens->span_array, new_span_array_size * sizeof *new_span_array);
 
-    current_token = &tokens->token_array[tokens->current_token_index];
-    if (current_token == NULL)
+        if (new_span_array == NULL)
+        {
+            goto done;
+        }
+        tokens->span_array = new_span_array;
+        tokens->span_array_size = new_span_array_size;
+    }
+    /* The tokens before the current one are all in the token 
+     * array, whether or not the cursor is between tokens. 
+     */
+    for (index = 0; index < num_spans; index++)
+    {
+        tokens_set_span(tokens, line, &tokens->token_array[index], &tokens->span_array[index]);
+    }
+    *spans = tokens->span_array;
+
+done:
+    return *spans != NULL ? num_spans : 0;
+}
+
+bool tokens_index_is_within_current_token(tokens_st const * const tokens, size_t const index)
+{
+    bool is_within_token;
+    token_st const * current_token;
+
+    if (tokens == NULL || !tokens->have_current_token)
     {
         is_within_token = false;
         goto done;
     }
 
-    is_within_token = (index + current_token->start_index) <= current_token->end_index;
+    current_token = tokens_lookup(tokens, tokens->current_token_index);
+    is_within_token = current_token != NULL && (index + current_token->start_index) <= current_token->end_index;
 
 done:
     return is_within_token;
@@ -206,7 +504,7 @@ size_t tokens_get_num_tokens(tokens_st const * const tokens)
 
     if (tokens != NULL)
     {
-        count = tokens->count;
+        count = tokens->cursor_is_between_tokens ? tokens->count + 1 : tokens->count;
     }
     else
     {
@@ -216,193 +514,166 @@ size_t tokens_get_num_tokens(tokens_st const * const tokens)
     return count;
 }
 
+/* Returns the token as it is in the line, including any quotes. */
 char const * tokens_get_token_at_index(tokens_st const * const tokens, size_t const index)
 {
-    char const * token;
+    token_st const * const token = tokens_lookup(tokens, index);
 
-    if (tokens == NULL)
-    {
-        token = NULL;
-        goto done;
-    }
-    if (index >= tokens->count)
-    {
-        token = NULL;
-        goto done;
-    }
-    token = tokens->token_array[index].token;
-
-done:
-    return token;
+    return token != NULL ? &tokens->text[token->text_offset] : NULL;
 }
 
-void tokens_free(tokens_st * const tokens)
+/* Returns the token with its quotes and escapes removed. */
+char const * tokens_get_token_value_at_index(tokens_st const * const tokens, size_t const index)
 {
-    if (tokens != NULL)
-    {
-        if (tokens->token_array)
-        {
-            size_t index;
+    token_st const * const token = tokens_lookup(tokens, index);
 
-            for (index = 0; index < tokens->count; index++)
-            {
-                free(tokens->token_array[index].token);
-            }
-            free(tokens->token_array);
-        }
-        free(tokens);
-    }
+    return token != NULL ? &tokens->text[token->value_offset] : NULL;
 }
 
-static bool char_is_field_separator(char const * const field_separators, char const ch)
+/* Returns the length of the token as it is in the line, including 
+ * any quotes and escapes. 
+ */
+size_t tokens_get_token_line_length(tokens_st const * const tokens, size_t const index)
 {
-    bool const is_a_field_separator = field_separators != NULL && strchr(field_separators, (int)ch) != NULL; 
+    token_st const * const token = tokens_lookup(tokens, index);
 
-    return is_a_field_separator;
+    return token != NULL ? token->end_index - token->start_index : 0;
 }
 
-/* Find the start and end indexes for all tokens on the current 
- * line. In addition, if the cursor is between tokens, add in 
- * an entry for this as well. Use an empty string to represent 
- * the token in that case. 
+/* Returns true if a token that ends after 'index' has been found. */
+static bool tokens_have_token_ending_after(tokens_st const * const tokens, size_t const index)
+{
+    return tokens->count > 0 && tokens->token_array[tokens->count - 1].end_index > index;
+}
+
+/* Add the tokens found in the line from start_index onwards. The 
+ * scan must start between tokens, and stops once a token ending 
+ * after stop_index has been found, leaving the rest of the line 
+ * for later. 
+ * A token ends at whitespace or a separator that isn't quoted or 
+ * escaped, or at the end of the line, so each part of the line 
+ * is looked at once. Each token records how far into the line it 
+ * was necessary to look to find it, so that it can be kept if 
+ * the line is only changed after that point, and where to start 
+ * looking for the token that follows it. 
  */
-tokens_st * tokenise_line(char const * const line,
-                          size_t const start_index,
-                          size_t const cursor_index,
-                          bool const assign_token_to_cursor_index,
-                          char const * const field_separators)
+static bool tokens_scan(tokens_st * const tokens,
+                        char const * const line,
+                        size_t const line_length,
+                        size_t const start_index,
+                        token_class_st const * const token_class,
+                        size_t const stop_index)
 {
-    tokens_st * tokens;
+    bool scanned;
     size_t current_index;
     size_t token_start_index;
-    bool done_cursor_index_token;
-    char const double_quote_delimiter = '\"';
-    char const newline = '\n';
-    char const nul = '\0';
+    bool token_is_quoted;
+    token_char_class_t char_class;
+    char const single_quote = '\'';
+    char const double_quote = '\"';
+    char const escape = '\\';
     enum token_type_t
     {
         token_type_none,
         token_type_plain,
+        token_type_single_quoted, /* Within single quotes in a token. */
         token_type_double_quoted
     };
     enum token_type_t token_type;
 
-    tokens = tokens_alloc();
-    if (tokens == NULL)
-    {
-        goto done;
-    }
-
-    done_cursor_index_token = false;
     token_type = token_type_none;
-    current_index = start_index;
-    token_start_index = current_index; /* Avoid compiler warning. */
+    token_start_index = start_index; /* Avoid compiler warning. */
+    token_is_quoted = false;
 
     for (current_index = start_index;
-         line[current_index] != nul && line[current_index] != newline;
+         (char_class = token_class_get(token_class, line[current_index])) != token_char_end;
          current_index++)
     {
-        char ch = line[current_index];
+        char const ch = line[current_index];
+
+        if (token_type == token_type_none && tokens_have_token_ending_after(tokens, stop_index))
+        {
+            tokens->all_found = false;
+            scanned = true;
+            goto done;
+        }
 
-        if (token_type == token_type_double_quoted)
+        if (token_type == token_type_single_quoted)
         {
-            if (ch == double_quote_delimiter)
+            if (ch == single_quote)
             {
-                size_t const index_of_end_of_token = current_index; /* exclude the terminating double quote */
-
-                populate_next_token(tokens, 
-                                    line, 
-                                    token_start_index, 
-                                    index_of_end_of_token, 
-                                    assign_token_to_cursor_index,
-                                    &done_cursor_index_token,
-                                    cursor_index);
-                token_type = token_type_none;
+                token_type = token_type_plain;
             }
         }
-        else if (isspace((int)ch))
+        else if (token_type == token_type_double_quoted)
         {
-            if (token_type == token_type_plain)
+            if (ch == double_quote)
             {
-                populate_next_token(tokens, 
-                                    line, 
-                                    token_start_index, 
-                                    current_index,
-                                    assign_token_to_cursor_index,
-                                    &done_cursor_index_token,
-                                    cursor_index);
-                token_type = token_type_none;
+                token_type = token_type_plain;
             }
-            else if (current_index == cursor_index)
+            else if (ch == escape 
+                     && (line[current_index + 1] == double_quote || line[current_index + 1] == escape))
             {
-                /* Cursor lies somewhere within the current token. */
-                if (assign_token_to_cursor_index)
-                {
-                    if (!done_cursor_index_token)
-                    {
-                        populate_next_token(tokens, 
-                                            NULL, 
-                                            cursor_index, 
-                                            cursor_index,
-                                            assign_token_to_cursor_index,
-                                            &done_cursor_index_token,
-                                            cursor_index);
-                    }
-                }
+                current_index++;
             }
         }
-        else if (char_is_field_separator(field_separators, ch))
+        else if (char_class == token_char_whitespace)
         {
             if (token_type == token_type_plain)
             {
-                populate_next_token(tokens, 
-                                    line, 
-                                    token_start_index, 
-                                    current_index,
-                                    assign_token_to_cursor_index,
-                                    &done_cursor_index_token,
-                                    cursor_index);
-                token_type = token_type_none;
-            }
-            else if (current_index == cursor_index)
-            {
-                if (assign_token_to_cursor_index)
+                if (!add_token(tokens,
+                               line,
+                               token_start_index,
+                               current_index,
+                               current_index + 1,
+                               current_index,
+                               false,
+                               token_is_quoted))
                 {
-                    if (!done_cursor_index_token)
-                    {
-                        populate_next_token(tokens, 
-                                            NULL, 
-                                            cursor_index, 
-                                            cursor_index,
-                                            assign_token_to_cursor_index,
-                                            &done_cursor_index_token,
-                                            cursor_index);
-                    }
+                    scanned = false;
+                    goto done;
                 }
+                token_type = token_type_none;
             }
-            if (token_type == token_type_none)
+        }
+        else if (char_class == token_char_separator)
+        {
+            if (token_type == token_type_plain)
             {
-                /* Create a token that includes just the field separator. */
-                /* XXX - This may need fixing. At present, the field separator 
-                 * specified is more of a command separator, and with mycli, 
-                 * happens to be the '|' character. This is why we make a 
-                 * token out of the separator. 
+                /* The separator is looked at again if the scan 
+                 * resumes after this token. 
                  */
-                populate_next_token(tokens, 
-                                    line, 
-                                    current_index, 
-                                    current_index + 1,
-                                    assign_token_to_cursor_index,
-                                    &done_cursor_index_token,
-                                    cursor_index);
+                if (!add_token(tokens,
+                               line,
+                               token_start_index,
+                               current_index,
+                               current_index + 1,
+                               current_index,
+                               false,
+                               token_is_quoted))
+                {
+                    scanned = false;
+                    goto done;
+                }
+                token_type = token_type_none;
             }
-        }
-        else if (ch == double_quote_delimiter)
-        {
-            if (token_type == token_type_none) /* ignore double quotes embedded in tokens */
+            /* Create a token that includes just the field separator. */
+            /* The field separator is more of a command separator (with 
+             * mycli it happens to be the '|' character), which is why 
+             * we make a token out of the separator. It ends the 
+             * segment of tokens making up the command before it. 
+             */
+            if (!add_token(tokens,
+                           line,
+                           current_index,
+                           current_index + 1,
+                           current_index + 1,
+                           current_index + 1,
+                           true,
+                           false))
             {
-                token_start_index = current_index + 1; /* exclude the leading double quote */
-                token_type = token_type_double_quoted;
+                scanned = false;
+                goto done;
             }
         }
         else
@@ -410,43 +681,391 @@ tokens_st * tokenise_line(char const * const line,
             if (token_type == token_type_none)
             {
                 token_start_index = current_index;
+                token_is_quoted = false;
                 token_type = token_type_plain;
             }
+            if (char_class == token_char_quote)
+            {
+                /* Quotes may start anywhere in a token, and the 
+                 * quoted part is joined to whatever is next to it. 
+                 */
+                token_type = ch == single_quote ? token_type_single_quoted : token_type_double_quoted;
+                token_is_quoted = true;
+            }
+            else if (char_class == token_char_escape)
+            {
+                /* A backslash at the end of the line is kept as it is. */
+                if (token_class_get(token_class, line[current_index + 1]) != token_char_end)
+                {
+                    current_index++;
+                }
+                token_is_quoted = true;
+            }
+            else
+            {
+                /* Skip the rest of the run of plain characters in one go. */
+                current_index = token_class_skip_plain(token_class, line, current_index + 1, line_length) - 1;
+            }
         }
     }
 
     if (token_type != token_type_none) /* Line has chars at the end of the line. */
     {
-        populate_next_token(tokens, 
-                            line, 
-                            token_start_index, 
-                            current_index,
-                            assign_token_to_cursor_index,
-                            & done_cursor_index_token,
-                            cursor_index);
+        /* The token depends on where the line ends, so it is found 
+         * again whenever the line changes. 
+         */
+        if (!add_token(tokens,
+                       line,
+                       token_start_index,
+                       current_index,
+                       current_index + 1,
+                       current_index,
+                       false,
+                       token_is_quoted))
+        {
+            scanned = false;
+            goto done;
+        }
+    }
+    tokens->all_found = true;
+
+    scanned = true;
+
+done:
+    return scanned;
+}
+
+/* Carry on from where the last scan of the line stopped, until a 
+ * token ending after stop_index has been found or the end of the 
+ * line is reached. The tokens already found are left as they are 
+ * if there isn't enough memory. 
+ */
+static bool tokens_scan_more(tokens_st * const tokens, size_t const stop_index)
+{
+    bool scanned;
+    size_t start_index;
+
+    if (tokens->all_found || tokens_have_token_ending_after(tokens, stop_index))
+    {
+        scanned = true;
+        goto done;
     }
+    start_index = tokens->count > 0 ? tokens->token_array[tokens->count - 1].resume_index : 0;
+    scanned = tokens_scan(tokens, tokens->line, tokens->line_length, start_index, tokens->token_class, stop_index);
 
-    if (assign_token_to_cursor_index)
+done:
+    return scanned;
+}
+
+/* Returns true if there is a token at 'index_in_array', finding 
+ * the tokens up to it first if need be. 
+ */
+static bool tokens_find_token_in_array(tokens_st * const tokens, size_t const index_in_array)
+{
+    while (index_in_array >= tokens->count && !tokens->all_found)
     {
-        if (!done_cursor_index_token)
+        /* Each token ends after the one before it. */
+        size_t const stop_index = tokens->count > 0 ? tokens->token_array[tokens->count - 1].end_index : 0;
+
+        if (!tokens_scan_more(tokens, stop_index))
         {
-            /* The line must have whitespace chars before the end of the 
-             * line, and the cursor must also be at the end of the line. 
-             */
+            break;
+        }
+    }
 
-            populate_next_token(tokens, 
-                                NULL, 
-                                cursor_index, 
-                                cursor_index,
-                                assign_token_to_cursor_index,
-                                &done_cursor_index_token,
-                                cursor_index);
+    return index_in_array < tokens->count;
+}
+
+/* Find the tokens up to the one at 'index', counting the empty 
+ * token at the cursor if the cursor is between tokens. Returns 
+ * false if there is no such token. 
+ */
+bool tokens_find_token(tokens_st * const tokens, size_t const index)
+{
+    bool found;
+
+    if (tokens->cursor_is_between_tokens && index >= tokens->current_token_index)
+    {
+        found = index == tokens->current_token_index || tokens_find_token_in_array(tokens, index - 1);
+    }
+    else
+    {
+        found = tokens_find_token_in_array(tokens, index);
+    }
+
+    return found;
+}
+
+/* Find the rest of the tokens in the line. Returns false if there 
+ * wasn't enough memory. 
+ */
+bool tokens_find_all(tokens_st * const tokens)
+{
+    return tokens_scan_more(tokens, SIZE_MAX);
+}
+
+/* The segment starts are kept as indexes into the token array, 
+ * which are the same as the token indexes for the tokens before 
+ * the cursor. The end of the segment is found by looking through 
+ * the tokens after the cursor for the next separator, finding 
+ * them if they haven't been found yet. 
+ */
+void tokens_get_current_segment(tokens_st * const tokens, token_segment_st * const segment)
+{
+    token_st const * current_token;
+    size_t index_in_array;
+    size_t end_index;
+
+    segment->first_token_index = 0;
+    segment->num_tokens = 0;
+    segment->first_token = NULL;
+    if (tokens == NULL || !tokens->have_current_token)
+    {
+        goto done;
+    }
+
+    current_token = tokens_lookup(tokens, tokens->current_token_index);
+    segment->first_token_index = current_token->segment_start_index;
+    if (current_token->is_separator)
+    {
+        end_index = tokens->current_token_index;
+    }
+    else
+    {
+        index_in_array = tokens->cursor_is_between_tokens ? tokens->current_token_index : tokens->current_token_index + 1;
+        while (tokens_find_token_in_array(tokens, index_in_array) && !tokens->token_array[index_in_array].is_separator)
+        {
+            index_in_array++;
         }
+        end_index = tokens->cursor_is_between_tokens ? index_in_array + 1 : index_in_array;
+    }
+    segment->num_tokens = end_index - segment->first_token_index;
+    if (segment->num_tokens > 0)
+    {
+        segment->first_token = tokens_get_token_value_at_index(tokens, segment->first_token_index);
     }
 
 done:
+    return;
+}
 
-    return tokens;
+/* Called when the line the tokens were found in is changed at 
+ * 'index' or beyond. 
+ */
+void tokens_line_changed(tokens_st * const tokens, size_t const index)
+{
+    tokens->unchanged_length = MIN(tokens->unchanged_length, index);
 }
 
+/* Where the text of the token, and its value, end in the text 
+ * block. 
+ */
+static size_t token_get_text_end(token_st const * const token)
+{
+    size_t text_end;
+
+    if (token->is_quoted)
+    {
+        text_end = token->value_offset + token->value_length + 1;
+    }
+    else
+    {
+        text_end = token->text_offset + (token->end_index - token->start_index) + 1;
+    }
+
+    return text_end;
+}
+
+/* Bring the tokens up to date with the line after it has been 
+ * edited. The tokens found before the first change are kept, and 
+ * the line is only scanned again from there, and then only until 
+ * a token ending after stop_index has been found. The rest are 
+ * found if they are asked for while the line is unchanged. 
+ * Returns false if there wasn't enough memory, in which case the 
+ * tokens will all be found again next time. 
+ */
+bool tokens_update(tokens_st * const tokens, 
+                   char const * const line, 
+                   size_t const line_length, 
+                   token_class_st const * const token_class, 
+                   size_t const stop_index)
+{
+    bool updated;
+
+    tokens_forget_current_token(tokens);
+    tokens->line = line;
+    tokens->line_length = line_length;
+    tokens->token_class = token_class;
+    if (tokens->unchanged_length != SIZE_MAX)
+    {
+        /* The tokens are in order of where they were found, so 
+         * those affected by the change are all at the end. Any 
+         * text after that of the last token kept is no longer 
+         * needed. 
+         */
+        while (tokens->count > 0 && tokens->token_array[tokens->count - 1].scan_end_index > tokens->unchanged_length)
+        {
+            tokens->count--;
+        }
+        tokens->text_length = tokens->count > 0 ? token_get_text_end(&tokens->token_array[tokens->count - 1]) : 0;
+        tokens->all_found = false;
+        tokens->unchanged_length = SIZE_MAX;
+    }
+
+    if (!tokens_scan_more(tokens, stop_index))
+    {
+        tokens_clear(tokens);
+        updated = false;
+        goto done;
+    }
+
+    updated = true;
+
+done:
+    return updated;
+}
+
+/* Make the token at the cursor the current token. If the cursor 
+ * is between tokens the current token is an empty one at the 
+ * cursor, which is counted amongst the tokens but isn't kept in 
+ * the token array, so moving the cursor doesn't change the 
+ * tokens that were found. 
+ */
+bool tokens_set_cursor(tokens_st * const tokens, char const * const line, size_t const cursor_index)
+{
+    bool set_ok;
+    size_t low = 0;
+    size_t high = tokens->count;
+    token_st const * token;
+
+    tokens_forget_current_token(tokens);
+
+    /* Find the first token that ends at or after the cursor. The 
+     * end indexes never decrease from one token to the next. 
+     */
+    while (low < high)
+    {
+        size_t const middle = low + (high - low) / 2;
+
+        if (tokens->token_array[middle].end_index < cursor_index)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    tokens->current_token_index = low;
+    token = low < tokens->count ? &tokens->token_array[low] : NULL;
+
+    /* A separator token only becomes the current token once the 
+     * cursor is past the separator. 
+     */
+    if (token == NULL
+        || token->start_index > cursor_index 
+        || (token->start_index == cursor_index && token->is_separator))
+    {
+        tokens->cursor_token.start_index = cursor_index;
+        tokens->cursor_token.end_index = cursor_index;
+        tokens->cursor_token.value_length = 0;
+        tokens->cursor_token.is_separator = false;
+        tokens->cursor_token.is_quoted = false;
+        tokens->cursor_token.segment_start_index = tokens_get_segment_start_index(tokens, low);
+        tokens->cursor_is_between_tokens = true;
+        token = &tokens->cursor_token;
+    }
+
+    /* Only include the part of the token from the start to the 
+     * current cursor position. The text is kept after the text 
+     * of the other tokens, but is replaced by the next update. 
+     */
+    if (token->is_quoted)
+    {
+        size_t value_length;
+
+        set_ok = tokens_add_value(tokens,
+                                  line,
+                                  token->start_index,
+                                  MIN(cursor_index, token->end_index),
+                                  &tokens->current_token_offset,
+                                  &value_length);
+    }
+    else
+    {
+        set_ok = tokens_add_text(tokens,
+                                 line,
+                                 token->start_index,
+                                 MIN(cursor_index, token->end_index),
+                                 &tokens->current_token_offset);
+    }
+    if (!set_ok)
+    {
+        tokens_forget_current_token(tokens);
+        goto done;
+    }
+    tokens->current_token_text_end = tokens->text_length;
+    tokens->have_current_token = true;
+    if (!tokens->all_found)
+    {
+        /* The text of the tokens not yet found is added after that 
+         * of the tokens already handed out, so room is made for it 
+         * now, so that the text block doesn't move. Each character 
+         * left in the line adds at most four bytes; one to each of 
+         * the token's text and value, and NULs for both. 
+         */
+        size_t const resume_index = tokens->count > 0 ? tokens->token_array[tokens->count - 1].resume_index : 0;
+
+        set_ok = tokens_ensure_space_for_text(tokens, tokens->text_length + 4 * (tokens->line_length - resume_index));
+        if (!set_ok)
+        {
+            tokens_forget_current_token(tokens);
+            goto done;
+        }
+    }
+    if (tokens->cursor_is_between_tokens)
+    {
+        tokens->cursor_token.text_offset = tokens->current_token_offset;
+        tokens->cursor_token.value_offset = tokens->current_token_offset;
+    }
+
+done:
+    return set_ok;
+}
+
+/* Find the start and end indexes for all tokens on the current 
+ * line. In addition, if the cursor is between tokens, add in 
+ * an entry for this as well. Use an empty string to represent 
+ * the token in that case. 
+ */
+bool tokenise_line(tokens_st * const tokens,
+                   char const * const line,
+                   size_t const start_index,
+                   size_t const cursor_index,
+                   bool const assign_token_to_cursor_index,
+                   token_class_st const * const token_class)
+{
+    bool tokenised;
+
+    tokens_clear(tokens);
+    tokens->line = line;
+    tokens->line_length = strlen(line);
+    tokens->token_class = token_class;
+
+    if (!tokens_scan(tokens, line, tokens->line_length, start_index, token_class, SIZE_MAX))
+    {
+        tokenised = false;
+        goto done;
+    }
+    if (assign_token_to_cursor_index && !tokens_set_cursor(tokens, line, cursor_index))
+    {
+        tokenised = false;
+        goto done;
+    }
+
+    tokenised = true;
+
+done:
+    return tokenised;
+}
 
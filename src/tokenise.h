@@ -10,26 +10,117 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+#include "token_class.h"
+#include "../include/readline.h"
+
+typedef struct token_st token_st;
+struct token_st
+{
+    size_t start_index; /* Where the token is in the line, including any quotes. */
+    size_t end_index;
+    size_t text_offset; /* Where the token's text, as it is in the line, is in the text block. */
+    size_t value_offset; /* Where the token's text without its quotes and escapes is. The same as text_offset if it has none. */
+    size_t value_length;
+    size_t scan_end_index; /* One past the last character looked at to find the token. */
+    size_t resume_index; /* Where to carry on looking for the next token. */
+    size_t segment_start_index; /* The first token of the command this token is part of. */
+    bool is_separator;
+    bool is_quoted; /* Has quotes or escapes, so its value is different to its text. */
+};
+
 typedef struct tokens_st tokens_st;
+/* The tokens found in a line. The text of every token is copied 
+ * into a single block, each followed by a NUL, so tokenising a 
+ * line only needs the token array and the text block, and both 
+ * are kept for the next line. Both grow geometrically, so the 
+ * time taken is in proportion to the length of the line however 
+ * many tokens it has. 
+ * The table can also be kept up to date with a line as it is 
+ * edited. Only the tokens that depend on the part of the line 
+ * that has changed are found again. 
+ * Quoting follows the shell. Whitespace and separators are 
+ * literal within single or double quotes, or after a backslash, 
+ * and a token may be made up of several quoted and unquoted 
+ * parts. A token's value, with the quotes and escapes removed, 
+ * is written to the text block only if it differs from the 
+ * token's text. 
+ * Each separator ends a segment of the line, and each token 
+ * records where its segment starts, so the tokens of the command 
+ * at the cursor can be found without looking at the others. 
+ * The tokens after the cursor's token need only be found when 
+ * they are asked for, so editing near the start of a long line 
+ * doesn't mean the rest of it is tokenised each time. 
+ */
+struct tokens_st
+{
+    token_st * token_array;
+    size_t token_array_size; /* The number of tokens there is space for. */
+    size_t count;
+
+    char * text;
+    size_t text_size;
+    size_t text_length;
+
+    token_span_st * span_array; /* Filled in when the spans of the tokens before the cursor are asked for. */
+    size_t span_array_size;
+
+    size_t unchanged_length; /* How much of the line is unchanged since the tokens were found. SIZE_MAX if none of it has changed. */
+    bool all_found; /* False if the scan stopped before the end of the line. */
+    char const * line; /* Where to find more tokens. Only valid while the line is unchanged. */
+    size_t line_length;
+    token_class_st const * token_class;
+
+    size_t current_token_index;
+    size_t current_token_offset; /* The value of the current token up to the cursor. */
+    size_t current_token_text_end; /* The end of the current token's text in the text block. */
+    token_st cursor_token; /* The empty token at the cursor when it is between tokens. */
+    bool have_current_token;
+    bool cursor_is_between_tokens; /* The current token is cursor_token, which isn't in token_array. */
+};
+
+void tokens_init(tokens_st * const tokens);
+void tokens_teardown(tokens_st * const tokens);
+void tokens_clear(tokens_st * const tokens);
+void tokens_trim(tokens_st * const tokens, size_t const maximum_idle_size);
+
+void tokens_line_changed(tokens_st * const tokens, size_t const index);
+bool tokens_update(tokens_st * const tokens, 
+                   char const * const line, 
+                   size_t const line_length, 
+                   token_class_st const * const token_class, 
+                   size_t const stop_index);
+bool tokens_find_token(tokens_st * const tokens, size_t const index);
+bool tokens_find_all(tokens_st * const tokens);
+bool tokens_set_cursor(tokens_st * const tokens, char const * const line, size_t const cursor_index);
 
 size_t tokens_get_current_token_index(tokens_st const * const tokens);
 char const * tokens_get_current_token(tokens_st const * const tokens);
 size_t tokens_get_num_tokens(tokens_st const * const tokens);
 char const * tokens_get_token_at_index(tokens_st const * const tokens, size_t const index);
+char const * tokens_get_token_value_at_index(tokens_st const * const tokens, size_t const index);
+size_t tokens_get_token_line_length(tokens_st const * const tokens, size_t const index);
+bool tokens_get_token_span(tokens_st const * const tokens, 
+                           char const * const line, 
+                           size_t const index, 
+                           token_span_st * const span);
+size_t tokens_get_preceding_token_spans(tokens_st * const tokens, 
+                                        char const * const line, 
+                                        token_span_st const * * const spans);
+void tokens_get_current_segment(tokens_st * const tokens, token_segment_st * const segment);
 bool tokens_index_is_within_current_token(tokens_st const * const tokens, size_t const index);
 
-void tokens_free(tokens_st * const tokens);
-
 /* Find the start and end indexes for all words on the current 
  * line. In addition, if the cursor is between lines, add in 
  * an entry for this as well. Use an empty string to represent 
  * the word in that case. 
- * Return the number of line_indexes found. 
+ * Any tokens already in 'tokens' are replaced. Returns false if 
+ * there wasn't enough memory. 
  */
-tokens_st * tokenise_line(char const * const line,
-                          size_t const start_index,
-                          size_t const cursor_index,
-                          bool const assign_token_to_cursor_index,
-                          char const * const field_separators);
+bool tokenise_line(tokens_st * const tokens,
+                   char const * const line,
+                   size_t const start_index,
+                   size_t const cursor_index,
+                   bool const assign_token_to_cursor_index,
+                   token_class_st const * const token_class);
 
 #endif /* __TOKENISE_H__ */
@@ -0,0 +1,410 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include "undo_log.h"
+#include "utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define UNDO_LOG_MINIMUM_RECORDS 8
+#define UNDO_LOG_MINIMUM_TEXT_SIZE 64
+
+void undo_log_init(undo_log_st * const undo_log, size_t const maximum_size)
+{
+    undo_log->records = NULL;
+    undo_log->records_size = 0;
+    undo_log->num_records = 0;
+    undo_log->current = 0;
+    undo_log->text = NULL;
+    undo_log->text_size = 0;
+    undo_log->text_length = 0;
+    undo_log->maximum_size = maximum_size;
+    undo_log->group_depth = 0;
+    undo_log->group_has_records = false;
+    undo_log->suspended = false;
+    undo_log->typing = false;
+}
+
+void undo_log_teardown(undo_log_st * const undo_log)
+{
+    free(undo_log->records);
+    free(undo_log->text);
+    undo_log_init(undo_log, undo_log->maximum_size);
+}
+
+/* Forget all records, keeping the memory for the next line. */
+void undo_log_clear(undo_log_st * const undo_log)
+{
+    undo_log->num_records = 0;
+    undo_log->current = 0;
+    undo_log->text_length = 0;
+    undo_log->group_has_records = false;
+}
+
+/* Forget all records, and give back the memory if more than
+ * maximum_idle_size bytes is held.
+ */
+void undo_log_trim(undo_log_st * const undo_log, size_t const maximum_idle_size)
+{
+    undo_log_clear(undo_log);
+    if (undo_log->records_size * sizeof *undo_log->records + undo_log->text_size > maximum_idle_size)
+    {
+        undo_log_teardown(undo_log);
+    }
+}
+
+size_t undo_log_set_maximum_size(undo_log_st * const undo_log, size_t const maximum_size)
+{
+    size_t const previous_maximum_size = undo_log->maximum_size;
+
+    undo_log->maximum_size = maximum_size;
+    /* Rather than working out what would fit in the new limit,
+     * just start again.
+     */
+    undo_log_clear(undo_log);
+
+    return previous_maximum_size;
+}
+
+static size_t undo_log_get_size_used(undo_log_st const * const undo_log)
+{
+    return undo_log->num_records * sizeof *undo_log->records + undo_log->text_length;
+}
+
+/* Once the line is changed by something other than a redo, the
+ * records that could have been redone no longer apply.
+ */
+static void undo_log_discard_redo_records(undo_log_st * const undo_log)
+{
+    if (undo_log->current < undo_log->num_records)
+    {
+        undo_log->text_length = undo_log->records[undo_log->current].text_offset;
+        undo_log->num_records = undo_log->current;
+    }
+}
+
+/* Discard the oldest records until there is room for
+ * size_required more bytes. Joined records are always discarded
+ * together. A quarter of the log is freed at a time so that a
+ * full log isn't shuffled along on every keystroke.
+ */
+static void undo_log_discard_oldest_records(undo_log_st * const undo_log, size_t const size_required)
+{
+    size_t const target_size = undo_log->maximum_size - undo_log->maximum_size / 4;
+    size_t size_used = undo_log_get_size_used(undo_log);
+    size_t records_to_discard = 0;
+    size_t text_to_discard;
+    size_t index;
+
+    while (records_to_discard < undo_log->num_records && size_used + size_required > target_size)
+    {
+        do
+        {
+            size_used -= sizeof *undo_log->records + undo_log->records[records_to_discard].length;
+            records_to_discard++;
+        }
+        while (records_to_discard < undo_log->num_records
+               && undo_log->records[records_to_discard].joined_to_previous);
+    }
+    if (records_to_discard == 0)
+    {
+        goto done;
+    }
+
+    text_to_discard = records_to_discard < undo_log->num_records
+        ? undo_log->records[records_to_discard].text_offset
+        : undo_log->text_length;
+    memmove(undo_log->text, &undo_log->text[text_to_discard], undo_log->text_length - text_to_discard);
+    undo_log->text_length -= text_to_discard;
+    memmove(undo_log->records,
+            &undo_log->records[records_to_discard],
+            (undo_log->num_records - records_to_discard) * sizeof *undo_log->records);
+    undo_log->num_records -= records_to_discard;
+    for (index = 0; index < undo_log->num_records; index++)
+    {
+        undo_log->records[index].text_offset -= text_to_discard;
+    }
+    undo_log->current = undo_log->current > records_to_discard ? undo_log->current - records_to_discard : 0;
+
+done:
+    return;
+}
+
+/* Both arrays grow geometrically, but never far beyond what the
+ * maximum size allows, so once a few lines have been edited no
+ * more memory is needed.
+ */
+static bool undo_log_make_space(undo_log_st * const undo_log, size_t const records_required, size_t const text_required)
+{
+    bool have_space;
+
+    if (undo_log->num_records + records_required > undo_log->records_size)
+    {
+        size_t const records_allowed = undo_log->maximum_size / sizeof *undo_log->records + 1;
+        size_t new_records_size = MIN(MAX(undo_log->records_size * 2, UNDO_LOG_MINIMUM_RECORDS), records_allowed);
+        undo_record_st * new_records;
+
+        new_records_size = MAX(new_records_size, undo_log->num_records + records_required);
+        new_records = realloc(undo_log->records, new_records_size * sizeof *new_records);
+        if (new_records == NULL)
+        {
+            have_space = false;
+            goto done;
+        }
+        undo_log->records = new_records;
+        undo_log->records_size = new_records_size;
+    }
+    if (undo_log->text_length + text_required > undo_log->text_size)
+    {
+        size_t new_text_size = MIN(MAX(undo_log->text_size * 2, UNDO_LOG_MINIMUM_TEXT_SIZE), undo_log->maximum_size);
+        char * new_text;
+
+        new_text_size = MAX(new_text_size, undo_log->text_length + text_required);
+        new_text = realloc(undo_log->text, new_text_size);
+        if (new_text == NULL)
+        {
+            have_space = false;
+            goto done;
+        }
+        undo_log->text = new_text;
+        undo_log->text_size = new_text_size;
+    }
+    have_space = true;
+
+done:
+    return have_space;
+}
+
+/* Try to add a single character edit to the newest record, so
+ * that a run of typing, or of deleting, is undone in one go. A
+ * new record is started at the start of each word though, so
+ * undo doesn't throw away too much at once.
+ */
+static bool undo_log_merge(undo_log_st * const undo_log,
+                           undo_operation_t const operation,
+                           size_t const index,
+                           char const ch)
+{
+    bool merged;
+    undo_record_st * last_record;
+    bool is_backspace = false;
+
+    if (undo_log->num_records == 0)
+    {
+        merged = false;
+        goto done;
+    }
+    last_record = &undo_log->records[undo_log->num_records - 1];
+    if (!last_record->is_typing || last_record->operation != operation)
+    {
+        merged = false;
+        goto done;
+    }
+    if (operation == undo_operation_insert)
+    {
+        if (index != last_record->index + last_record->length
+            || (!isspace((int)ch) && isspace((int)undo_log->text[undo_log->text_length - 1])))
+        {
+            merged = false;
+            goto done;
+        }
+    }
+    else if (index + 1 == last_record->index)
+    {
+        is_backspace = true;
+    }
+    else if (index != last_record->index)
+    {
+        merged = false;
+        goto done;
+    }
+    if (undo_log_get_size_used(undo_log) + 1 > undo_log->maximum_size
+        || !undo_log_make_space(undo_log, 0, 1))
+    {
+        merged = false;
+        goto done;
+    }
+
+    if (is_backspace)
+    {
+        /* The character goes before those already deleted. */
+        memmove(&undo_log->text[last_record->text_offset + 1],
+                &undo_log->text[last_record->text_offset],
+                last_record->length);
+        undo_log->text[last_record->text_offset] = ch;
+        last_record->index = index;
+    }
+    else
+    {
+        undo_log->text[undo_log->text_length] = ch;
+    }
+    undo_log->text_length++;
+    last_record->length++;
+    merged = true;
+
+done:
+    return merged;
+}
+
+/* All records made between begin and end are undone and redone
+ * together. Groups may be nested.
+ */
+void undo_log_begin_group(undo_log_st * const undo_log)
+{
+    if (undo_log->group_depth == 0)
+    {
+        undo_log->group_has_records = false;
+    }
+    undo_log->group_depth++;
+}
+
+void undo_log_end_group(undo_log_st * const undo_log)
+{
+    if (undo_log->group_depth > 0)
+    {
+        undo_log->group_depth--;
+    }
+}
+
+/* Edits recorded between begin and end are plain typing, 
+ * backspace or delete, and so can be merged with the typing 
+ * before them. Any other edit starts a record of its own, even 
+ * if it only changes one character. 
+ */
+void undo_log_begin_typing(undo_log_st * const undo_log)
+{
+    undo_log->typing = true;
+}
+
+void undo_log_end_typing(undo_log_st * const undo_log)
+{
+    undo_log->typing = false;
+}
+
+void undo_log_record(undo_log_st * const undo_log,
+                     undo_operation_t const operation,
+                     size_t const index,
+                     char const * const text,
+                     size_t const length)
+{
+    bool const joined_to_previous = undo_log->group_depth > 0 && undo_log->group_has_records;
+    bool const is_typing = undo_log->typing && length == 1 && !joined_to_previous;
+    size_t const size_required = sizeof *undo_log->records + length;
+    undo_record_st * record;
+
+    if (undo_log->suspended || undo_log->maximum_size == 0 || length == 0)
+    {
+        goto done;
+    }
+    undo_log_discard_redo_records(undo_log);
+
+    if (is_typing && undo_log_merge(undo_log, operation, index, text[0]))
+    {
+        undo_log->group_has_records = true;
+        goto done;
+    }
+    if (size_required > undo_log->maximum_size)
+    {
+        /* This edit can't be recorded, and the older records can't
+         * be undone without undoing it first.
+         */
+        undo_log_clear(undo_log);
+        goto done;
+    }
+    if (undo_log_get_size_used(undo_log) + size_required > undo_log->maximum_size)
+    {
+        undo_log_discard_oldest_records(undo_log, size_required);
+    }
+    if (!undo_log_make_space(undo_log, 1, length))
+    {
+        undo_log_clear(undo_log);
+        goto done;
+    }
+
+    record = &undo_log->records[undo_log->num_records];
+    record->operation = operation;
+    record->index = index;
+    record->text_offset = undo_log->text_length;
+    record->length = length;
+    record->joined_to_previous = joined_to_previous;
+    record->is_typing = is_typing;
+    memcpy(&undo_log->text[undo_log->text_length], text, length);
+    undo_log->text_length += length;
+    undo_log->num_records++;
+    undo_log->current = undo_log->num_records;
+    undo_log->group_has_records = true;
+
+done:
+    return;
+}
+
+/* Typing after an undo or redo starts a new record rather than
+ * being merged into an older one.
+ */
+static void undo_log_stop_merging(undo_log_st * const undo_log)
+{
+    if (undo_log->current > 0)
+    {
+        undo_log->records[undo_log->current - 1].is_typing = false;
+    }
+}
+
+/* Returns the next record to undo, or NULL if there is nothing
+ * to undo. If the record is joined to the previous one, that
+ * should be undone too.
+ */
+undo_record_st const * undo_log_undo(undo_log_st * const undo_log)
+{
+    undo_record_st const * record;
+
+    if (undo_log->current == 0)
+    {
+        record = NULL;
+        goto done;
+    }
+    undo_log->current--;
+    record = &undo_log->records[undo_log->current];
+    undo_log_stop_merging(undo_log);
+
+done:
+    return record;
+}
+
+/* Returns the next record to redo, or NULL if there is nothing
+ * to redo.
+ */
+undo_record_st const * undo_log_redo(undo_log_st * const undo_log)
+{
+    undo_record_st const * record;
+
+    if (undo_log->current == undo_log->num_records)
+    {
+        record = NULL;
+        goto done;
+    }
+    record = &undo_log->records[undo_log->current];
+    undo_log->current++;
+    undo_log_stop_merging(undo_log);
+
+done:
+    return record;
+}
+
+/* true if the next record to redo should be redone along with
+ * the one just redone.
+ */
+bool undo_log_redo_is_joined(undo_log_st const * const undo_log)
+{
+    return undo_log->current < undo_log->num_records
+        && undo_log->records[undo_log->current].joined_to_previous;
+}
+
+char const * undo_log_get_text(undo_log_st const * const undo_log, undo_record_st const * const record)
+{
+    return &undo_log->text[record->text_offset];
+}
@@ -0,0 +1,84 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#ifndef __UNDO_LOG_H__
+#define __UNDO_LOG_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum undo_operation_t
+{
+    undo_operation_insert,
+    undo_operation_delete
+} undo_operation_t;
+
+typedef struct undo_record_st undo_record_st;
+/* A single change to the line. Only the text that was inserted
+ * or deleted is kept, never a copy of the whole line.
+ */
+struct undo_record_st
+{
+    undo_operation_t operation;
+    size_t index; /* Where in the line the text was inserted or deleted. */
+    size_t text_offset; /* Where the text is kept in the log's text arena. */
+    size_t length;
+    bool joined_to_previous; /* Undone and redone along with the previous record. */
+    bool is_typing; /* Started by typing a single character, so later typing may be merged into it. */
+};
+
+typedef struct undo_log_st undo_log_st;
+/* The edits made to a line, oldest first. The text of every
+ * record is kept in one arena, in the same order as the
+ * records, so adding a record, or merging a keystroke into the
+ * newest record, only appends to the end of the arena.
+ * Records [0, current) can be undone, and records
+ * [current, num_records) can be redone.
+ * The memory used by the records and their text is kept below
+ * maximum_size by discarding the oldest records. The memory is
+ * kept between lines so that recording an edit doesn't usually
+ * need any memory to be allocated.
+ */
+struct undo_log_st
+{
+    undo_record_st * records;
+    size_t records_size; /* The number of records there is space for. */
+    size_t num_records;
+    size_t current;
+
+    char * text;
+    size_t text_size;
+    size_t text_length;
+
+    size_t maximum_size; /* 0 disables the log. */
+    unsigned int group_depth;
+    bool group_has_records;
+    bool suspended; /* Set while an undo or redo is being applied so that it isn't recorded. */
+    bool typing; /* Set while plain typing, backspace or delete is being recorded, as only those edits are merged. */
+};
+
+void undo_log_init(undo_log_st * const undo_log, size_t const maximum_size);
+void undo_log_teardown(undo_log_st * const undo_log);
+void undo_log_clear(undo_log_st * const undo_log);
+void undo_log_trim(undo_log_st * const undo_log, size_t const maximum_idle_size);
+size_t undo_log_set_maximum_size(undo_log_st * const undo_log, size_t const maximum_size);
+
+void undo_log_begin_group(undo_log_st * const undo_log);
+void undo_log_end_group(undo_log_st * const undo_log);
+void undo_log_begin_typing(undo_log_st * const undo_log);
+void undo_log_end_typing(undo_log_st * const undo_log);
+void undo_log_record(undo_log_st * const undo_log,
+                     undo_operation_t const operation,
+                     size_t const index,
+                     char const * const text,
+                     size_t const length);
+
+undo_record_st const * undo_log_undo(undo_log_st * const undo_log);
+undo_record_st const * undo_log_redo(undo_log_st * const undo_log);
+bool undo_log_redo_is_joined(undo_log_st const * const undo_log);
+char const * undo_log_get_text(undo_log_st const * const undo_log, undo_record_st const * const record);
+
+#endif /* __UNDO_LOG_H__ */
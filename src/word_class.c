@@ -0,0 +1,203 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#include "word_class.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define VECTOR_SIZE 16
+#endif
+
+static bool is_ascii_alnum(unsigned int const ch)
+{
+    return (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z');
+}
+
+/* Copy the characters into the list compared against when 
+ * classifying a vector. Returns false if there are too many. 
+ */
+static bool set_vector_chars(char * const list, size_t * const list_length, char const * const chars)
+{
+    bool set;
+    size_t const length = chars != NULL ? strlen(chars) : 0;
+
+    if (length > WORD_CLASS_MAXIMUM_VECTOR_CHARS)
+    {
+        *list_length = 0;
+        set = false;
+        goto done;
+    }
+    if (length > 0)
+    {
+        memcpy(list, chars, length);
+    }
+    *list_length = length;
+    set = true;
+
+done:
+    return set;
+}
+
+void word_class_init(word_class_st * const word_class, 
+                     char const * const extra_word_chars, 
+                     char const * const field_separators)
+{
+    unsigned int ch;
+    char const * p;
+
+    for (ch = 0; ch < 256; ch++)
+    {
+        word_class->is_word_char[ch] = is_ascii_alnum(ch);
+    }
+    for (p = extra_word_chars; p != NULL && *p != '\0'; p++)
+    {
+        word_class->is_word_char[(unsigned char)*p] = true;
+    }
+    for (p = field_separators; p != NULL && *p != '\0'; p++)
+    {
+        word_class->is_word_char[(unsigned char)*p] = false;
+    }
+
+    word_class->can_use_vectors = 
+        set_vector_chars(word_class->extra_word_chars, &word_class->num_extra_word_chars, extra_word_chars)
+        && set_vector_chars(word_class->separators, &word_class->num_separators, field_separators);
+}
+
+bool word_class_is_word_char(word_class_st const * const word_class, char const ch)
+{
+    return word_class->is_word_char[(unsigned char)ch];
+}
+
+#if defined(VECTOR_SIZE)
+static __m128i in_range(__m128i const chars, char const low, char const high)
+{
+    /* Unsigned compare of chars - low against high - low. */
+    __m128i const offset = _mm_sub_epi8(chars, _mm_set1_epi8(low));
+
+    return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(high - low)), offset);
+}
+
+/* Returns a bit for each of the 16 characters, set if it is a 
+ * word character. This matches the table built by 
+ * word_class_init(). 
+ */
+static unsigned int get_word_char_mask(word_class_st const * const word_class, char const * const text)
+{
+    __m128i const chars = _mm_loadu_si128((__m128i const *)text);
+    __m128i is_word = _mm_or_si128(_mm_or_si128(in_range(chars, '0', '9'), in_range(chars, 'A', 'Z')), 
+                                   in_range(chars, 'a', 'z'));
+    size_t index;
+
+    for (index = 0; index < word_class->num_extra_word_chars; index++)
+    {
+        is_word = _mm_or_si128(is_word, _mm_cmpeq_epi8(chars, _mm_set1_epi8(word_class->extra_word_chars[index])));
+    }
+    for (index = 0; index < word_class->num_separators; index++)
+    {
+        is_word = _mm_andnot_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(word_class->separators[index])), is_word);
+    }
+
+    return (unsigned int)_mm_movemask_epi8(is_word);
+}
+#endif
+
+/* Returns the index of the first character that isn't a word 
+ * character (if skip_word_chars is set) or is one (if not), or 
+ * length if there is no such character. 
+ */
+size_t word_class_skip_forward(word_class_st const * const word_class, 
+                               char const * const text, 
+                               size_t const length, 
+                               bool const skip_word_chars)
+{
+    size_t index = 0;
+    bool found = false;
+
+#if defined(VECTOR_SIZE)
+    while (word_class->can_use_vectors && !found && index + VECTOR_SIZE <= length)
+    {
+        unsigned int mask = get_word_char_mask(word_class, &text[index]);
+
+        if (skip_word_chars)
+        {
+            mask = ~mask & 0xffff;
+        }
+        if (mask != 0)
+        {
+            index += __builtin_ctz(mask);
+            found = true;
+        }
+        else
+        {
+            index += VECTOR_SIZE;
+        }
+    }
+#endif
+    while (!found && index < length)
+    {
+        if (word_class_is_word_char(word_class, text[index]) != skip_word_chars)
+        {
+            found = true;
+        }
+        else
+        {
+            index++;
+        }
+    }
+
+    return index;
+}
+
+/* Working back from the end of the text, returns the index just 
+ * after the last character that isn't a word character (if 
+ * skip_word_chars is set) or is one (if not), or 0 if there is 
+ * no such character. 
+ */
+size_t word_class_skip_backward(word_class_st const * const word_class, 
+                                char const * const text, 
+                                size_t const length, 
+                                bool const skip_word_chars)
+{
+    size_t index = length;
+    bool found = false;
+
+#if defined(VECTOR_SIZE)
+    while (word_class->can_use_vectors && !found && index >= VECTOR_SIZE)
+    {
+        unsigned int mask = get_word_char_mask(word_class, &text[index - VECTOR_SIZE]);
+
+        if (skip_word_chars)
+        {
+            mask = ~mask & 0xffff;
+        }
+        if (mask != 0)
+        {
+            /* The highest set bit is the character nearest the end. */
+            index = index - VECTOR_SIZE + (32 - __builtin_clz(mask));
+            found = true;
+        }
+        else
+        {
+            index -= VECTOR_SIZE;
+        }
+    }
+#endif
+    while (!found && index > 0)
+    {
+        if (word_class_is_word_char(word_class, text[index - 1]) != skip_word_chars)
+        {
+            found = true;
+        }
+        else
+        {
+            index--;
+        }
+    }
+
+    return index;
+}
@@ -0,0 +1,50 @@
+/* Copyright (C) Chris Nisbet - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly 
+ * prohibited. Proprietary and confidential. Written by Chris 
+ * Nisbet <nisbet@ihug.co.nz>, April 2016.
+ */
+
+#ifndef __WORD_CLASS_H__
+#define __WORD_CLASS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define WORD_CLASS_MAXIMUM_VECTOR_CHARS 8
+
+typedef struct word_class_st word_class_st;
+/* Says which characters are part of a word for the word motion 
+ * and deletion commands. Letters and digits are word characters, 
+ * along with any extra word characters, unless they are field 
+ * separators. 
+ * The table is used a character at a time. Long runs of text are 
+ * classified 16 characters at a time using SSE2 where it is 
+ * available, which needs the extra characters and separators to 
+ * be compared individually, so is only done if there aren't too 
+ * many of them. 
+ */
+struct word_class_st
+{
+    bool is_word_char[256];
+
+    bool can_use_vectors;
+    char extra_word_chars[WORD_CLASS_MAXIMUM_VECTOR_CHARS];
+    size_t num_extra_word_chars;
+    char separators[WORD_CLASS_MAXIMUM_VECTOR_CHARS];
+    size_t num_separators;
+};
+
+void word_class_init(word_class_st * const word_class, 
+                     char const * const extra_word_chars, 
+                     char const * const field_separators);
+bool word_class_is_word_char(word_class_st const * const word_class, char const ch);
+size_t word_class_skip_forward(word_class_st const * const word_class, 
+                               char const * const text, 
+                               size_t const length, 
+                               bool const skip_word_chars);
+size_t word_class_skip_backward(word_class_st const * const word_class, 
+                                char const * const text, 
+                                size_t const length, 
+                                bool const skip_word_chars);
+
+#endif /* __WORD_CLASS_H__ */
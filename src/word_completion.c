@@ -6,11 +6,10 @@
 
 #include "word_completion.h"
 #include "tokenise.h"
-#include "args.h"
-#include "strdup_partial.h"
 #include "common_prefix_length.h"
 #include "print_words_in_columns.h"
 #include "readline_context.h"
+#include "multi_line.h"
 #include "utils.h"
 
 #include <stddef.h>
@@ -21,7 +20,12 @@
 #define GET_PRIVATE_CONTEXT_FROM_PUBLIC_CONTEXT(completion_context) \
     container_of(completion_context, private_completion_context_st, public_context)
 
-static char const * find_longest_completion_suffix(size_t const token_length, size_t const num_words, char const * const * const words)
+#define MINIMUM_POSSIBLE_WORDS_SIZE 16
+
+static char const * find_longest_completion_suffix(arena_st * const arena, 
+                                                   size_t const token_length, 
+                                                   size_t const num_words, 
+                                                   char const * const * const words)
 {
     char const * longest_match;
 
@@ -29,7 +33,8 @@ static char const * find_longest_completion_suffix(size_t const token_length, si
      * longest match from the set of words. 
      * An example might be the easiest way to explain.
      * e.g. if token is "a" and words is "abc", "abd", return "ab". 
-     * It is assumed that all words match up to token_length. 
+     * It is assumed that all words match up to token_length, and 
+     * that if there is more than one they are sorted. 
      */
     if (num_words == 0)
     {
@@ -37,11 +42,20 @@ static char const * find_longest_completion_suffix(size_t const token_length, si
     }
     else if (num_words == 1)
     {
-        longest_match = strdup_partial(words[0], token_length, strlen(words[0]));
+        size_t const word_length = strlen(words[0]);
+
+        longest_match = token_length <= word_length
+            ? arena_strdup_partial(arena, words[0], token_length, word_length)
+            : NULL;
     }
     else
     {
-        size_t const common_prefix_length = find_common_prefix_length(num_words, words);
+        /* The words are sorted, so the prefix they all share is the 
+         * one shared by the first and last of them, and the others 
+         * needn't be looked at. 
+         */
+        char const * const first_and_last_words[] = { words[0], words[num_words - 1] };
+        size_t const common_prefix_length = find_common_prefix_length(2, first_and_last_words);
 
         /* Multiple tokens. Find the longest common prefix shared by 
          * the words. 
@@ -56,7 +70,7 @@ static char const * find_longest_completion_suffix(size_t const token_length, si
             longest_match = NULL;
             goto done;
         }
-        longest_match = strdup_partial(words[0], token_length, common_prefix_length);
+        longest_match = arena_strdup_partial(arena, words[0], token_length, common_prefix_length);
     }
 
 done:
@@ -73,12 +87,40 @@ static int possible_word_add(completion_context_st * const completion_context,
 {
     private_completion_context_st * const private_completion_context =
         GET_PRIVATE_CONTEXT_FROM_PUBLIC_CONTEXT(completion_context);
-    args_st * possible_words;
+    char const * word_copy;
 
-    possible_words = private_completion_context->possible_words;
+    if (private_completion_context->num_possible_words == private_completion_context->possible_words_size)
+    {
+        /* The old array stays in the arena until it is reset, but 
+         * as the size doubles each time that wastes no more than 
+         * the size of the final array. 
+         */
+        size_t const new_size = MAX(private_completion_context->possible_words_size * 2, MINIMUM_POSSIBLE_WORDS_SIZE);
+        char const * * const new_words = arena_alloc(private_completion_context->arena, 
+                                                     new_size * sizeof *new_words);
 
-    args_add_arg(possible_words, possible_word);
+        if (new_words == NULL)
+        {
+            goto done;
+        }
+        if (private_completion_context->num_possible_words > 0)
+        {
+            memcpy(new_words, 
+                   private_completion_context->possible_words, 
+                   private_completion_context->num_possible_words * sizeof *new_words);
+        }
+        private_completion_context->possible_words = new_words;
+        private_completion_context->possible_words_size = new_size;
+    }
+    word_copy = arena_strdup(private_completion_context->arena, possible_word);
+    if (word_copy == NULL)
+    {
+        goto done;
+    }
+    private_completion_context->possible_words[private_completion_context->num_possible_words] = word_copy;
+    private_completion_context->num_possible_words++;
 
+done:
     return 0;
 }
 
@@ -106,8 +148,7 @@ static int unique_match_set(completion_context_st * const completion_context,
     private_completion_context_st * const private_completion_context =
         GET_PRIVATE_CONTEXT_FROM_PUBLIC_CONTEXT(completion_context);
 
-    FREE_CONST(private_completion_context->unique_match);
-    private_completion_context->unique_match = strdup(unique_match);
+    private_completion_context->unique_match = arena_strdup(private_completion_context->arena, unique_match);
 
     return 0;
 }
@@ -133,6 +174,9 @@ static size_t get_num_tokens(completion_context_st * const completion_context)
     private_completion_context_st * const private_completion_context =
         GET_PRIVATE_CONTEXT_FROM_PUBLIC_CONTEXT(completion_context);
 
+    /* The tokens after the cursor are only found when needed. */
+    tokens_find_all(private_completion_context->tokens);
+
     return tokens_get_num_tokens(private_completion_context->tokens);
 }
 
@@ -141,7 +185,39 @@ static char const * get_token_at_index(completion_context_st * const completion_
     private_completion_context_st * const private_completion_context =
         GET_PRIVATE_CONTEXT_FROM_PUBLIC_CONTEXT(completion_context);
 
-    return tokens_get_token_at_index(private_completion_context->tokens, index);
+    tokens_find_token(private_completion_context->tokens, index);
+
+    return tokens_get_token_value_at_index(private_completion_context->tokens, index);
+}
+
+static bool get_token_span_at_index(completion_context_st * const completion_context, 
+                                    size_t const index, 
+                                    token_span_st * const span)
+{
+    private_completion_context_st * const private_completion_context =
+        GET_PRIVATE_CONTEXT_FROM_PUBLIC_CONTEXT(completion_context);
+
+    tokens_find_token(private_completion_context->tokens, index);
+
+    return tokens_get_token_span(private_completion_context->tokens, private_completion_context->line, index, span);
+}
+
+static size_t get_preceding_token_spans(completion_context_st * const completion_context, 
+                                        token_span_st const * * const spans)
+{
+    private_completion_context_st * const private_completion_context =
+        GET_PRIVATE_CONTEXT_FROM_PUBLIC_CONTEXT(completion_context);
+
+    return tokens_get_preceding_token_spans(private_completion_context->tokens, private_completion_context->line, spans);
+}
+
+static void get_current_segment(completion_context_st * const completion_context, 
+                                token_segment_st * const segment)
+{
+    private_completion_context_st * const private_completion_context =
+        GET_PRIVATE_CONTEXT_FROM_PUBLIC_CONTEXT(completion_context);
+
+    tokens_get_current_segment(private_completion_context->tokens, segment);
 }
 
 static int qsort_string_compare(const void * p1, const void * p2)
@@ -161,40 +237,49 @@ static void private_completion_context_teardown(private_completion_context_st *
         close(completion_context->write_back_fd);
         completion_context->write_back_fd = -1;
     }
-    
-    args_free(private_completion_context->possible_words);
+
+    /* Frees the possible words. */
+    arena_reset(private_completion_context->arena);
     private_completion_context->possible_words = NULL;
-    tokens_free(private_completion_context->tokens);
+    private_completion_context->num_possible_words = 0;
     private_completion_context->tokens = NULL;
 }
 
 static bool private_completion_context_init(line_context_st * const line_ctx,
                                             private_completion_context_st * const private_completion_context,
-                                            char const * const field_separators)
+                                            arena_st * const arena,
+                                            bool const wait_until_writable)
 {
     completion_context_st * const completion_context = &private_completion_context->public_context;
     bool init_ok;
 
     memset(private_completion_context, 0, sizeof *private_completion_context);
-    private_completion_context->possible_words = args_alloc(1);
-
-    if (private_completion_context->possible_words == NULL)
-    {
-        init_ok = false;
-        goto done;
-    }
-    private_completion_context->tokens = tokenise_line(line_ctx->edit_buffer, 0, line_ctx->edit_index, true, field_separators);
+    completion_context->write_back_fd = -1;
+    private_completion_context->arena = arena;
+    private_completion_context->tokens = line_context_get_tokens(line_ctx);
     if (private_completion_context->tokens == NULL)
     {
         init_ok = false;
         goto done;
     }
+    /* The line isn't changed until the completion is finished. */
+    private_completion_context->line = line_context_get_line(line_ctx);
 
     /* dup() the file descriptor because it will be closed during 
      * completion. 
      */
     /* XXX - Do error checking. */
-    completion_context->write_back_fd = dup(line_ctx->terminal_fd);
+    /* The callback writes directly to the file descriptor, so 
+     * anything already queued must go out first. In non-blocking 
+     * mode the key isn't processed until the queue has drained, so 
+     * this only fails if the output has backed up again. 
+     */
+    if (output_queue_flush(line_ctx->output, wait_until_writable) == output_queue_flush_result_pending)
+    {
+        init_ok = false;
+        goto done;
+    }
+    completion_context->write_back_fd = dup(line_ctx->output->fd);
 
     completion_context->possible_word_add_fn = possible_word_add;
     completion_context->start_index_set_fn = set_completion_start;
@@ -203,6 +288,9 @@ static bool private_completion_context_init(line_context_st * const line_ctx,
     completion_context->tokens_get_current_token_fn = get_current_token;
     completion_context->tokens_get_num_tokens_fn = get_num_tokens;
     completion_context->tokens_get_token_at_index_fn = get_token_at_index;
+    completion_context->tokens_get_token_span_at_index_fn = get_token_span_at_index;
+    completion_context->tokens_get_preceding_token_spans_fn = get_preceding_token_spans;
+    completion_context->tokens_get_current_segment_fn = get_current_segment;
 
     init_ok = true;
 
@@ -227,13 +315,13 @@ static void process_unique_match(private_completion_context_st * const private_c
     char const * const current_token = tokens_get_current_token(private_completion_context->tokens);
     char const * const token = &current_token[private_completion_context->completion_start_index];
 
-    longest_completion_suffix = find_longest_completion_suffix(strlen(token),
+    longest_completion_suffix = find_longest_completion_suffix(private_completion_context->arena,
+                                                               strlen(token),
                                                                1,
                                                                &private_completion_context->unique_match);
     if (longest_completion_suffix != NULL)
     {
         complete_word(line_ctx, longest_completion_suffix, true);
-        FREE_CONST(longest_completion_suffix);
     }
 }
 
@@ -252,7 +340,7 @@ static bool process_multiple_matches(line_context_st * const line_ctx,
      */
     need_to_redisplay_line = false;
 
-    if (private_completion_context->possible_words->argc > 0)
+    if (private_completion_context->num_possible_words > 0)
     {
         char const * longest_completion_suffix;
         bool printed_additional_lines;
@@ -260,37 +348,38 @@ static bool process_multiple_matches(line_context_st * const line_ctx,
         char const * const token = &current_token[private_completion_context->completion_start_index];
 
         printed_additional_lines = false;
-        if (private_completion_context->possible_words->argc > 1)
+        if (private_completion_context->num_possible_words > 1)
         {
-            qsort(private_completion_context->possible_words->argv,
-                  private_completion_context->possible_words->argc, sizeof(*private_completion_context->possible_words->argv),
+            qsort(private_completion_context->possible_words,
+                  private_completion_context->num_possible_words, sizeof(*private_completion_context->possible_words),
                   qsort_string_compare);
-            print_words_in_columns(line_ctx->terminal_fd,
+            print_words_in_columns(line_ctx->output,
                                    line_ctx->terminal_width,
-                                   private_completion_context->possible_words->argc,
-                                   private_completion_context->possible_words->argv);
+                                   private_completion_context->num_possible_words,
+                                   private_completion_context->possible_words);
             need_to_redisplay_line = true;
             printed_additional_lines = true;
         }
 
-        longest_completion_suffix = find_longest_completion_suffix(strlen(token),
-                                                                   private_completion_context->possible_words->argc,
-                                                                   private_completion_context->possible_words->argv);
+        longest_completion_suffix = find_longest_completion_suffix(private_completion_context->arena,
+                                                                   strlen(token),
+                                                                   private_completion_context->num_possible_words,
+                                                                   private_completion_context->possible_words);
         if (longest_completion_suffix != NULL)
         {
             complete_word(line_ctx,
                           longest_completion_suffix,
                           !printed_additional_lines);
-            FREE_CONST(longest_completion_suffix);
         }
     }
     return need_to_redisplay_line;
 }
 
-static void private_completion_context_process_results(line_context_st * const line_ctx,
+static void private_completion_context_process_results(readline_st * const readline_ctx,
                                                        private_completion_context_st * const private_completion_context,
                                                        bool const characters_were_printed)
 {
+    line_context_st * const line_ctx = &readline_ctx->line_context;
     bool need_to_redisplay_line;
 
     if (private_completion_context->unique_match != NULL)
@@ -310,7 +399,7 @@ static void private_completion_context_process_results(line_context_st * const l
 
     if (need_to_redisplay_line)
     {
-        redisplay_line(line_ctx);
+        multi_line_redisplay(readline_ctx);
     }
 }
 
@@ -335,7 +424,8 @@ void do_word_completion(readline_st * const readline_ctx)
 
     if (!private_completion_context_init(line_ctx,
                                          &private_completion_context,
-                                         readline_ctx->field_separators))
+                                         &readline_ctx->arena,
+                                         !readline_ctx->non_blocking))
     {
         goto done;
     }
@@ -343,7 +433,7 @@ void do_word_completion(readline_st * const readline_ctx)
     characters_were_printed = readline_ctx->completion_callback(&private_completion_context.public_context,
                                       readline_ctx->user_context);
 
-    private_completion_context_process_results(line_ctx,
+    private_completion_context_process_results(readline_ctx,
                                                &private_completion_context,
                                                characters_were_printed > 0);
 